@@ -0,0 +1,224 @@
+#include "apic.h"
+#include "lib.h"
+#include "i8259.h"
+#include "idt.h"
+#include "paging.h"
+#include "clock.h"
+#include "klog.h"
+
+uint32_t apic_active = 0;
+
+/* Base of the local APIC registers */
+static volatile uint8_t* lapic_base = NULL;
+
+/* Low word of the redirection entry of each ISA IRQ, so */
+/* masking one is a single write with no read back.      */
+static uint32_t ioapic_redir[ ISA_NUM_IRQS ];
+
+static inline uint32_t lapic_read( uint32_t reg )
+{
+    return *(volatile uint32_t*)( lapic_base + reg );
+}
+
+static inline void lapic_write( uint32_t reg, uint32_t val )
+{
+    *(volatile uint32_t*)( lapic_base + reg ) = val;
+}
+
+static inline uint32_t ioapic_read( uint32_t reg )
+{
+    *(volatile uint32_t*)( IOAPIC_BASE + IOAPIC_REGSEL ) = reg;
+    return *(volatile uint32_t*)( IOAPIC_BASE + IOAPIC_WIN );
+}
+
+static inline void ioapic_write( uint32_t reg, uint32_t val )
+{
+    *(volatile uint32_t*)( IOAPIC_BASE + IOAPIC_REGSEL ) = reg;
+    *(volatile uint32_t*)( IOAPIC_BASE + IOAPIC_WIN ) = val;
+}
+
+/* I/O APIC pin an ISA IRQ is wired to */
+static inline uint32_t ioapic_pin( uint32_t irq_num )
+{
+    return ( irq_num == ISA_PIT_IRQ ) ? IOAPIC_PIT_PIN : irq_num;
+}
+
+/* ---------------------- apic_init ------------------- */
+/* Looks for a local APIC with CPUID, maps it and the   */
+/* I/O APIC, and routes ISA IRQ n to vector 0x20 + n,   */
+/* edge triggered, to this CPU. IRQs that were already  */
+/* enabled on the 8259s stay enabled; the 8259s are     */
+/* then masked for good. Must run after page_init and   */
+/* with interrupts off.                                 */
+/* Inputs:          None.                               */
+/* Outputs:         1 if the APIC is now in use, else 0 */
+/* Side Effects:    Maps the APIC pages, masks the PICs */
+int32_t apic_init( void )
+{
+    uint32_t eax, ebx, ecx, edx;
+    uint32_t base_lo, base_hi;
+    uint32_t ver, pins, dest, irq, pin;
+
+    asm volatile( "cpuid"
+                  : "=a" ( eax ), "=b" ( ebx ), "=c" ( ecx ), "=d" ( edx )
+                  : "a" ( 1 ) );
+    if( ( edx & ( CPUID_FEAT_APIC | CPUID_FEAT_MSR ) ) != ( CPUID_FEAT_APIC | CPUID_FEAT_MSR ) ) {
+        klog( KLOG_INFO, "apic: none, using the 8259 PICs" );
+        return 0;
+    }
+
+    asm volatile( "rdmsr" : "=a" ( base_lo ), "=d" ( base_hi ) : "c" ( MSR_APIC_BASE ) );
+    lapic_base = (volatile uint8_t*)( base_lo & APIC_BASE_ADDR_MASK );
+    page_map_mmio( (uint32_t)lapic_base );
+    page_map_mmio( IOAPIC_BASE );
+
+    /* An absent I/O APIC reads back as all ones */
+    ver = ioapic_read( IOAPIC_REG_VER );
+    pins = ( ( ver >> IOAPIC_MAX_REDIR_SHIFT ) & 0xFF ) + 1;
+    if( ver == 0xFFFFFFFF || pins < ISA_NUM_IRQS || pins > IOAPIC_MAX_PINS ) {
+        klog( KLOG_WARN, "apic: no I/O APIC at 0x%x, using the 8259 PICs", IOAPIC_BASE );
+        return 0;
+    }
+
+    asm volatile( "wrmsr" : : "c" ( MSR_APIC_BASE ), "a" ( base_lo | APIC_BASE_ENABLE ), "d" ( base_hi ) );
+
+    /* Accept every priority, mask LINT0 (where the 8259    */
+    /* output arrives) and the timer until it is started,   */
+    /* then software-enable the APIC.                       */
+    lapic_write( LAPIC_TPR, 0 );
+    lapic_write( LAPIC_LVT_TIMER, LAPIC_LVT_MASKED );
+    lapic_write( LAPIC_LVT_LINT0, LAPIC_LVT_MASKED );
+    lapic_write( LAPIC_LVT_ERROR, LAPIC_LVT_MASKED );
+    lapic_write( LAPIC_SVR, LAPIC_SVR_ENABLE | SPURIOUS_VECTOR );
+
+    /* Program every ISA IRQ masked, on the vector the 8259 */
+    /* would have used. IRQ 2 is only the 8259 cascade.     */
+    dest = lapic_read( LAPIC_ID ) >> LAPIC_ID_SHIFT;
+    for( irq = 0; irq < ISA_NUM_IRQS; irq++ ) {
+        if( irq == SLAVE_CONNECTION ) {
+            continue;
+        }
+        pin = ioapic_pin( irq );
+        ioapic_redir[ irq ] = ( ICW2_MASTER + irq ) | IOAPIC_REDIR_MASKED;
+        ioapic_write( IOAPIC_REG_REDTBL + 2 * pin + 1, dest << IOAPIC_DEST_SHIFT );
+        ioapic_write( IOAPIC_REG_REDTBL + 2 * pin, ioapic_redir[ irq ] );
+    }
+
+    /* Move over what the 8259s had enabled, then mask them */
+    apic_active = 1;
+    for( irq = 0; irq < ISA_NUM_IRQS; irq++ ) {
+        if( irq == SLAVE_CONNECTION ) {
+            continue;
+        }
+        if( irq < 8 ? !( master_mask & ( 1 << irq ) ) : !( slave_mask & ( 1 << ( irq - 8 ) ) ) ) {
+            ioapic_enable_irq( irq );
+        }
+    }
+    master_mask = MASK_ALL;
+    slave_mask = MASK_ALL;
+    outb( MASK_ALL, MASTER_8259_PORT_D );
+    outb( MASK_ALL, SLAVE_8259_PORT_D );
+
+    klog( KLOG_INFO, "apic: local APIC %u at 0x%x, I/O APIC with %u pins",
+          dest, (uint32_t)lapic_base, pins );
+    return 1;
+}
+
+/* ------------------ ioapic_enable_irq --------------- */
+/* Unmasks an ISA IRQ at the I/O APIC.                  */
+/* Inputs:          irq_num -> ISA IRQ, 0 to 15         */
+/* Outputs:         None.                               */
+/* Side Effects:    Writes its redirection entry.       */
+void ioapic_enable_irq( uint32_t irq_num )
+{
+    if( irq_num >= ISA_NUM_IRQS || irq_num == SLAVE_CONNECTION ) {
+        return;
+    }
+    ioapic_redir[ irq_num ] &= ~IOAPIC_REDIR_MASKED;
+    ioapic_write( IOAPIC_REG_REDTBL + 2 * ioapic_pin( irq_num ), ioapic_redir[ irq_num ] );
+}
+
+/* ----------------- ioapic_disable_irq --------------- */
+/* Masks an ISA IRQ at the I/O APIC.                    */
+/* Inputs:          irq_num -> ISA IRQ, 0 to 15         */
+/* Outputs:         None.                               */
+/* Side Effects:    Writes its redirection entry.       */
+void ioapic_disable_irq( uint32_t irq_num )
+{
+    if( irq_num >= ISA_NUM_IRQS || irq_num == SLAVE_CONNECTION ) {
+        return;
+    }
+    ioapic_redir[ irq_num ] |= IOAPIC_REDIR_MASKED;
+    ioapic_write( IOAPIC_REG_REDTBL + 2 * ioapic_pin( irq_num ), ioapic_redir[ irq_num ] );
+}
+
+/* ------------------ ioapic_irq_masked --------------- */
+/* Reads back whether an ISA IRQ is masked.             */
+/* Inputs:          irq_num -> ISA IRQ, 0 to 15         */
+/* Outputs:         1 if masked (or no APIC), else 0    */
+/* Side Effects:    None.                               */
+int32_t ioapic_irq_masked( uint32_t irq_num )
+{
+    if( !apic_active || irq_num >= ISA_NUM_IRQS ) {
+        return 1;
+    }
+    return ( ioapic_read( IOAPIC_REG_REDTBL + 2 * ioapic_pin( irq_num ) ) & IOAPIC_REDIR_MASKED ) != 0;
+}
+
+/* ---------------------- lapic_eoi ------------------- */
+/* Ends the highest priority interrupt in service.      */
+/* Inputs:          None.                               */
+/* Outputs:         None.                               */
+/* Side Effects:    Writes the EOI register.            */
+void lapic_eoi( void )
+{
+    lapic_write( LAPIC_EOI, 0 );
+}
+
+/* ------------------- apic_timer_start --------------- */
+/* Counts how far the local APIC timer runs in one tick */
+/* of the TSC calibrated clock, then starts it periodic */
+/* on the PIT vector so pit_handler keeps working. Must */
+/* run with interrupts off.                             */
+/* Inputs:          hz -> tick rate, at most 1000       */
+/* Outputs:         1 if started, 0 to use the PIT      */
+/* Side Effects:    Programs the local APIC timer.      */
+int32_t apic_timer_start( uint32_t hz )
+{
+    uint64_t start;
+    uint32_t spin;
+    uint32_t count;
+
+    if( !apic_active || tsc_khz == 0 || hz == 0 || hz > 1000 ) {
+        return 0;
+    }
+    spin = tsc_khz * ( 1000 / hz );
+
+    lapic_write( LAPIC_TIMER_DIV, LAPIC_TIMER_DIV_16 );
+    lapic_write( LAPIC_LVT_TIMER, LAPIC_LVT_MASKED );
+    lapic_write( LAPIC_TIMER_INIT, 0xFFFFFFFF );
+    start = rdtsc( );
+    while( (uint32_t)( rdtsc( ) - start ) < spin ) {}
+    count = 0xFFFFFFFF - lapic_read( LAPIC_TIMER_CURR );
+    lapic_write( LAPIC_TIMER_INIT, 0 );
+
+    if( count == 0 ) {
+        klog( KLOG_WARN, "apic: timer did not run, using the PIT" );
+        return 0;
+    }
+
+    lapic_write( LAPIC_LVT_TIMER, PIT_VECTOR | LAPIC_TIMER_PERIODIC );
+    lapic_write( LAPIC_TIMER_INIT, count );
+    klog( KLOG_INFO, "apic: timer at %u Hz, %u counts per tick", hz, count );
+    return 1;
+}
+
+/* ------------------ apic_spurious_handler ----------- */
+/* A spurious interrupt is not in service, so it must   */
+/* not be acknowledged.                                 */
+/* Inputs:          None.                               */
+/* Outputs:         None.                               */
+/* Side Effects:    None.                               */
+void apic_spurious_handler( void )
+{
+}
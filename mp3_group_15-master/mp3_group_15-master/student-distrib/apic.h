@@ -0,0 +1,88 @@
+#ifndef _APIC_H
+#define _APIC_H
+
+#include "types.h"
+
+/* Local APIC and I/O APIC interrupt controllers. When  */
+/* CPUID reports an APIC, apic_init masks both 8259s    */
+/* and routes the ISA IRQs through the I/O APIC to the  */
+/* same vectors the 8259s used, so the IDT and the      */
+/* device drivers do not change. enable_irq, disable_irq */
+/* and send_eoi (i8259.c) then go to the APIC: an EOI   */
+/* is one memory write instead of one or two port       */
+/* writes, and masking an IRQ touches only its own      */
+/* redirection entry. The local APIC timer replaces the */
+/* PIT as the scheduler tick. Without an APIC the 8259s */
+/* are kept as they are.                                */
+
+/* CPUID leaf 1, EDX feature bits */
+#define CPUID_FEAT_MSR          0x00000020
+#define CPUID_FEAT_APIC         0x00000200
+
+/* IA32_APIC_BASE MSR */
+#define MSR_APIC_BASE           0x1B
+#define APIC_BASE_ENABLE        0x00000800
+#define APIC_BASE_ADDR_MASK     0xFFFFF000
+
+/* Local APIC registers, as offsets from its base */
+#define LAPIC_ID                0x020
+#define LAPIC_TPR               0x080   /* Task priority                            */
+#define LAPIC_EOI               0x0B0
+#define LAPIC_SVR               0x0F0   /* Spurious interrupt vector                */
+#define LAPIC_LVT_TIMER         0x320
+#define LAPIC_LVT_LINT0         0x350
+#define LAPIC_LVT_LINT1         0x360
+#define LAPIC_LVT_ERROR         0x370
+#define LAPIC_TIMER_INIT        0x380   /* Timer initial count                      */
+#define LAPIC_TIMER_CURR        0x390   /* Timer current count                      */
+#define LAPIC_TIMER_DIV         0x3E0   /* Timer divide configuration               */
+
+#define LAPIC_SVR_ENABLE        0x00000100
+#define LAPIC_LVT_MASKED        0x00010000
+#define LAPIC_TIMER_PERIODIC    0x00020000
+#define LAPIC_TIMER_DIV_16      0x3
+#define LAPIC_ID_SHIFT          24
+
+/* The I/O APIC is assumed at its default address; the  */
+/* kernel does not parse the ACPI MADT.                 */
+#define IOAPIC_BASE             0xFEC00000
+#define IOAPIC_REGSEL           0x00    /* Register select                          */
+#define IOAPIC_WIN              0x10    /* Data window                              */
+#define IOAPIC_REG_VER          0x01
+#define IOAPIC_REG_REDTBL       0x10    /* Redirection entry n at 0x10 + 2n         */
+#define IOAPIC_MAX_REDIR_SHIFT  16
+#define IOAPIC_MAX_PINS         24
+#define IOAPIC_DEST_SHIFT       24      /* Destination APIC ID, in the high word    */
+#define IOAPIC_REDIR_MASKED     0x00010000
+
+/* ISA IRQ 0 (the PIT) is wired to I/O APIC pin 2 on PCs;   */
+/* the other ISA IRQs keep their number.                    */
+#define ISA_NUM_IRQS            16
+#define ISA_PIT_IRQ             0
+#define IOAPIC_PIT_PIN          2
+
+/* Set once apic_init has switched the IRQs to the APIC */
+extern uint32_t apic_active;
+
+/* Switches from the 8259s to the APIC if there is one.   */
+/* Returns 1 if the APIC is in use, 0 otherwise.          */
+extern int32_t apic_init( void );
+
+/* Unmasks / masks an ISA IRQ at the I/O APIC */
+extern void ioapic_enable_irq( uint32_t irq_num );
+extern void ioapic_disable_irq( uint32_t irq_num );
+
+/* Returns 1 if the ISA IRQ is masked at the I/O APIC */
+extern int32_t ioapic_irq_masked( uint32_t irq_num );
+
+/* Signals end of interrupt to the local APIC */
+extern void lapic_eoi( void );
+
+/* Starts the local APIC timer at hz on the PIT vector.   */
+/* Returns 1 on success, 0 if the PIT has to be used.     */
+extern int32_t apic_timer_start( uint32_t hz );
+
+/* Handler for the spurious interrupt vector */
+extern void apic_spurious_handler( void );
+
+#endif /* _APIC_H */
@@ -0,0 +1,123 @@
+#include "clock.h"
+#include "lib.h"
+#include "scheduling.h"
+#include "klog.h"
+
+uint32_t tsc_khz = 0;
+
+/* Nanoseconds per cycle, shifted left by CLOCK_SHIFT,  */
+/* and the TSC when the clock started.                  */
+static uint32_t clock_mult = 0;
+static uint64_t clock_base = 0;
+
+/* ---------------------- div64_32 -------------------- */
+/* Divides a 64-bit number by a 32-bit one with a       */
+/* single divl, since there is no libgcc to do 64-bit   */
+/* division. The quotient must fit in 32 bits, that is  */
+/* the high word of n must be less than d.              */
+uint32_t div64_32( uint64_t n, uint32_t d )
+{
+    uint32_t q, r;
+
+    asm( "divl %4"
+         : "=a" ( q ), "=d" ( r )
+         : "a" ( (uint32_t)n ), "d" ( (uint32_t)( n >> 32 ) ), "rm" ( d ) );
+    return q;
+}
+
+/* -------------------- clock_pit_run ----------------- */
+/* Times CLOCK_CAL_MS of PIT channel 2 with the TSC.    */
+/* Outputs:         TSC cycles the run took.            */
+static uint64_t clock_pit_run( void )
+{
+    uint64_t start;
+    uint8_t  gate;
+
+    /* Gate channel 2 on with the speaker off, then     */
+    /* load the count. In mode 0 the output goes high   */
+    /* once the count reaches zero.                     */
+    gate = inb( PIT_GATE_PORT );
+    outb( ( gate & ~PIT_GATE_SPEAKER ) | PIT_GATE_CH2, PIT_GATE_PORT );
+    outb( PIT_CH2_ONESHOT, PIT_COMMAND_REG );
+    outb( CLOCK_CAL_COUNT & RELOAD_MASK_LOWER, PIT_CHANNEL_2 );
+    outb( ( CLOCK_CAL_COUNT & RELOAD_MASK_UPPER ) >> 8, PIT_CHANNEL_2 );
+
+    start = rdtsc( );
+    while( !( inb( PIT_GATE_PORT ) & PIT_OUT_CH2 ) ) {}
+    return rdtsc( ) - start;
+}
+
+/* ---------------------- clock_init ------------------ */
+/* Measures the TSC frequency against PIT channel 2 and */
+/* starts the clock. Must run with interrupts off so    */
+/* the runs are not stretched.                          */
+/* Inputs:          None.                               */
+/* Outputs:         None.                               */
+/* Side Effects:    Sets tsc_khz, uses PIT channel 2.   */
+void clock_init( void )
+{
+    uint64_t cycles;
+    uint64_t best = 0;
+    int32_t  i;
+
+    for( i = 0; i < CLOCK_CAL_RUNS; i++ )
+    {
+        cycles = clock_pit_run( );
+        if( best == 0 || cycles < best )
+        {
+            best = cycles;
+        }
+    }
+
+    /* The run is CLOCK_CAL_COUNT PIT periods long.     */
+    tsc_khz = div64_32( best * ( CLOCK_PIT_HZ / 1000 ), CLOCK_CAL_COUNT );
+    if( tsc_khz < CLOCK_MIN_KHZ )
+    {
+        klog( KLOG_WARN, "clock: TSC not usable, using PIT ticks" );
+        tsc_khz = 0;
+        return;
+    }
+
+    clock_mult = div64_32( (uint64_t)NS_PER_MS << CLOCK_SHIFT, tsc_khz );
+    clock_base = rdtsc( );
+    klog( KLOG_INFO, "clock: TSC at %u kHz", tsc_khz );
+}
+
+/* ------------------ clock_cycles_to_ns -------------- */
+/* Multiplies by clock_mult in two 32-bit halves, so    */
+/* the product does not need 96-bit arithmetic.         */
+/* Inputs:          cycles -> TSC cycles                */
+/* Outputs:         The same time in nanoseconds.       */
+uint64_t clock_cycles_to_ns( uint64_t cycles )
+{
+    uint64_t lo = (uint64_t)(uint32_t)cycles * clock_mult;
+    uint64_t hi = (uint64_t)(uint32_t)( cycles >> 32 ) * clock_mult;
+
+    return ( hi << ( 32 - CLOCK_SHIFT ) ) + ( lo >> CLOCK_SHIFT );
+}
+
+/* ----------------------- clock_ns ------------------- */
+/* Outputs:         Nanoseconds since clock_init. Falls */
+/*                  back to PIT ticks without a TSC.    */
+uint64_t clock_ns( void )
+{
+    if( tsc_khz == 0 )
+    {
+        return (uint64_t)sched_ticks * CLOCK_TICK_NS;
+    }
+    return clock_cycles_to_ns( rdtsc( ) - clock_base );
+}
+
+/* -------------------- syscall_gettime --------------- */
+/* Inputs:          ns -> where to store the time       */
+/* Outputs:         0, or -1 if ns is NULL.             */
+/* Side Effects:    None.                               */
+int32_t syscall_gettime( uint64_t* ns )
+{
+    if( ns == NULL )
+    {
+        return -1;
+    }
+    *ns = clock_ns( );
+    return 0;
+}
@@ -0,0 +1,48 @@
+#ifndef _CLOCK_H
+#define _CLOCK_H
+
+#include "types.h"
+#include "scheduling.h"
+
+/* Monotonic high resolution clock. At boot the TSC is  */
+/* timed against PIT channel 2, which runs off its own  */
+/* oscillator, and from then on TSC cycles are turned   */
+/* into nanoseconds with a fixed point multiply, so     */
+/* reading the clock takes no divide and no I/O.        */
+
+#define CLOCK_PIT_HZ        1193182     /* PIT input clock                              */
+#define CLOCK_CAL_MS        10          /* Length of one calibration run                */
+#define CLOCK_CAL_COUNT     ( CLOCK_PIT_HZ * CLOCK_CAL_MS / 1000 )
+#define CLOCK_CAL_RUNS      3           /* Runs; the shortest one is kept               */
+#define CLOCK_SHIFT         22          /* Fixed point bits of clock_mult               */
+#define CLOCK_MIN_KHZ       1000        /* Slower TSCs are treated as missing           */
+#define NS_PER_MS           1000000
+#define CLOCK_TICK_NS       ( NS_PER_MS * 1000 / SCHED_HZ )    /* One PIT tick */
+
+/* PIT channel 2 and its gate, in the keyboard controller's port B */
+#define PIT_CHANNEL_2       0x42
+#define PIT_CH2_ONESHOT     0xB0        /* Channel 2, lobyte/hibyte, mode 0, binary     */
+#define PIT_GATE_PORT       0x61
+#define PIT_GATE_CH2        0x01        /* Gate input of channel 2                      */
+#define PIT_GATE_SPEAKER    0x02        /* Speaker data, kept off                       */
+#define PIT_OUT_CH2         0x20        /* Output of channel 2, set when it reaches 0   */
+
+/* TSC frequency in kHz, 0 if it could not be measured */
+extern uint32_t tsc_khz;
+
+/* Calibrates the TSC and starts the clock at 0 */
+extern void clock_init( void );
+
+/* 64 by 32-bit divide; the quotient must fit 32 bits */
+extern uint32_t div64_32( uint64_t n, uint32_t d );
+
+/* Converts a number of TSC cycles to nanoseconds */
+extern uint64_t clock_cycles_to_ns( uint64_t cycles );
+
+/* Nanoseconds since clock_init */
+extern uint64_t clock_ns( void );
+
+/* System call: stores the nanoseconds since boot in *ns */
+extern int32_t syscall_gettime( uint64_t* ns );
+
+#endif /* _CLOCK_H */
@@ -0,0 +1,85 @@
+#include "deferred.h"
+#include "lib.h"
+#include "klog.h"
+
+/* Ring buffer of pending jobs. Jobs are added at the   */
+/* tail and run from the head, so they run in the same  */
+/* order the interrupts arrived in.                     */
+static deferred_work_t deferred_queue[ DEFERRED_QUEUE_SIZE ];
+static uint32_t deferred_head = 0;
+static uint32_t deferred_tail = 0;
+
+/* Set while a drain is in progress. Interrupts that    */
+/* arrive during the drain only queue their work, and   */
+/* the drain already running picks it up.               */
+static volatile int32_t deferred_running = 0;
+
+uint32_t deferred_dropped = 0;
+
+/* --------------------- defer_work ------------------- */
+/* Adds a job to the tail of the deferred work queue.   */
+/* Inputs:          func -> function to run later       */
+/*                  arg  -> argument for func           */
+/* Outputs:         0 on success, -1 if the queue is    */
+/*                  full and the job was dropped.       */
+/* Side Effects:    Job runs at the end of the current  */
+/*                  (or next) interrupt.                */
+int32_t defer_work( deferred_func_t func, uint32_t arg )
+{
+    uint32_t flags;
+    cli_and_save( flags );
+
+    if( deferred_tail - deferred_head >= DEFERRED_QUEUE_SIZE ) {
+        deferred_dropped++;
+        restore_flags( flags );
+        klog( KLOG_WARN, "deferred work queue full, job dropped" );
+        return -1;
+    }
+
+    deferred_queue[ deferred_tail & DEFERRED_QUEUE_MASK ].func = func;
+    deferred_queue[ deferred_tail & DEFERRED_QUEUE_MASK ].arg = arg;
+    deferred_tail++;
+
+    restore_flags( flags );
+    return 0;
+}
+
+/* ----------------- run_deferred_work ---------------- */
+/* Drains the queue. Each job runs with interrupts      */
+/* enabled; the queue itself is only touched with them  */
+/* disabled. A nested interrupt returns right away and  */
+/* leaves its job to the drain it interrupted.          */
+/* Inputs:          None.                               */
+/* Outputs:         None.                               */
+/* Side Effects:    Runs every queued job. Returns with */
+/*                  interrupts disabled.                */
+void run_deferred_work( void )
+{
+    deferred_work_t work;
+
+    cli( );
+    if( deferred_running ) {
+        return;
+    }
+    deferred_running = 1;
+
+    while( deferred_head != deferred_tail ) {
+        work = deferred_queue[ deferred_head & DEFERRED_QUEUE_MASK ];
+        deferred_head++;
+
+        sti( );
+        work.func( work.arg );
+        cli( );
+    }
+
+    deferred_running = 0;
+}
+
+/* --------------- deferred_work_running -------------- */
+/* Inputs:          None.                               */
+/* Outputs:         Non-zero while a drain is running.  */
+/* Side Effects:    None.                               */
+int32_t deferred_work_running( void )
+{
+    return deferred_running;
+}
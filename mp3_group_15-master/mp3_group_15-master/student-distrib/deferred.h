@@ -0,0 +1,43 @@
+#ifndef _DEFERRED_H
+#define _DEFERRED_H
+
+#include "types.h"
+
+/* Deferred work (bottom halves). Interrupt handlers do */
+/* only what must happen with interrupts masked (read   */
+/* the device, send EOI) and queue the rest. The queue  */
+/* is drained by the interrupt linkage after the        */
+/* handler returns, with interrupts enabled, so a slow  */
+/* job such as a terminal switch does not hold off the  */
+/* other devices.                                       */
+
+/* Number of jobs the queue can hold. Must be a power   */
+/* of two so the ring indices can be masked.            */
+#define DEFERRED_QUEUE_SIZE     64
+#define DEFERRED_QUEUE_MASK     ( DEFERRED_QUEUE_SIZE - 1 )
+
+/* A deferred job is a function and one argument        */
+typedef void ( *deferred_func_t )( uint32_t arg );
+
+typedef struct deferred_work_t {
+    deferred_func_t func;                   /* Function to run later        */
+    uint32_t        arg;                    /* Argument passed to func      */
+} deferred_work_t;
+
+/* Jobs dropped because the queue was full              */
+extern uint32_t deferred_dropped;
+
+/* Queues a job to be run after the current interrupt.  */
+/* Safe to call from interrupt handlers.                */
+int32_t defer_work( deferred_func_t func, uint32_t arg );
+
+/* Runs every queued job. Called by the interrupt       */
+/* linkage with interrupts disabled, returns with them  */
+/* disabled.                                            */
+void run_deferred_work( void );
+
+/* Non-zero while the queue is being drained. The       */
+/* scheduler does not switch away from a drain.         */
+int32_t deferred_work_running( void );
+
+#endif /* _DEFERRED_H */
@@ -5,7 +5,27 @@
 /* Header file for exceptions functon wrapping. */
 #include "exceptions.h"
 
-/* Declare external function wrapper for usage in wrapper and handler*/
-extern void exception_wrapper( uint32_t exception_id );
+/* Exception entry points, defined in exception_wrapper.S. Each */
+/* saves a hw_context_t and calls exception_dispatch.           */
+extern void exception_handler_DE( void );
+extern void exception_handler_DB( void );
+extern void exception_handler_NMI( void );
+extern void exception_handler_BP( void );
+extern void exception_handler_OF( void );
+extern void exception_handler_BR( void );
+extern void exception_handler_UD( void );
+extern void exception_handler_NM( void );
+extern void exception_handler_DF( void );
+extern void exception_handler_CSO( void );
+extern void exception_handler_TS( void );
+extern void exception_handler_NP( void );
+extern void exception_handler_SS( void );
+extern void exception_handler_GP( void );
+extern void exception_handler_PF( void );
+extern void exception_handler_15( void );
+extern void exception_handler_MF( void );
+extern void exception_handler_AC( void );
+extern void exception_handler_MC( void );
+extern void exception_handler_XF( void );
 
 #endif
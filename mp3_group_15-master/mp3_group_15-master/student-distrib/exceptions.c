@@ -1,5 +1,7 @@
 #include "exceptions.h"
 #include "lib.h"
+#include "keyboard.h"
+#include "klog.h"
 
 /*          exception_handler_general                   */
 /* General handler for exceptions. For Checkpoint 3.1,  */
@@ -13,6 +15,12 @@
 /* Side Effects: Prints the exception to the screen.    */
 void exception_handler_general( uint32_t id )
 {
+    /* printf writes from the start of a screen, so make sure the   */
+    /* displayed screen begins at the start of its VGA region and   */
+    /* point printf there.                                           */
+    scroll_reset( display_terminal );
+    set_video_mem( terminal_video_base( display_terminal ) );
+
     /* Test to see if the handler was invoked at all. */
     printf("Exception handler called!\n");
     /* Check if id passed in is an actual exception. If not, return from handler.*/
@@ -95,13 +103,16 @@ void exception_handler_general( uint32_t id )
     }
 
 
+    klog( KLOG_ERR, "exception %u in pid %d", id, curr_pid );
+
     /* Exception identified and handled. Quash the user program.*/
     /* For Checkpoint 3.1, that entails just looping.           */
     /* while(1){ } */
 
     /* For Checkpoint 3.3, that means we halt the program, with */
-    /* status 256.                                              */
-    syscall_halt( (uint8_t)256 );
+    /* status 256. (uint8_t)256 would be 0, so pass the error   */
+    /* status that halt expands to 256.                         */
+    syscall_halt( HALT_ERROR );
 
 }
 
@@ -2,12 +2,12 @@
 #include "types.h"
 #include "lib.h"
 #include "keyboard.h"
+#include "syscall.h"
 
 /* User Memory (0x8000000) + Page_4MB(0x400000) - sizeof(uint32)    */
 /* or might be user start addr + some offset (VM starts at 128 MB)  */
 #define PROGRAM_IMG_ADDRS 0x08048000 
 #define PROGRAM_IMG_OFF   0x00048000
-#define FOUR_MB           0x0400000 
 
 /* Initialize global array of file descriptors */
 open_file_t file_array[FILE_ARRAY_SIZE];
@@ -38,6 +38,19 @@ void fileArray_init(void) {
     return;
 }
 
+/* open_file_t* get_open_file(int32_t fd);
+ *   Inputs: int32_t fd --> File descriptor, 0 to 7
+ *   Return Value: The open file of the running process, or of the kernel's file_array
+ *                 when no process is running
+ *   Function: Lets the drivers work on the caller's own descriptor. A driver may block,
+ *             so there is no shared copy of the descriptors for another process to overwrite */
+open_file_t* get_open_file(int32_t fd) {
+    if (curr_pid >= 0) {
+        return &get_pcb(curr_pid)->fd_array[fd];
+    }
+    return &file_array[fd];
+}
+
 /* void fileSystem_init(uint32_t* fs_start);
  *   Inputs: uit32_t* fs_start --> The starting address of the file system
  *   Return Value: None
@@ -96,27 +109,19 @@ int32_t read_dentry_by_name(const uint8_t* fname, dentry_t* dentry)
     /* substrings from coming up with matches. Aftewards, we    */
     /* will use strcmp to compare the filenames and decide      */
     /* matching filenames.                                      */
-    dentry_t curr_directory;
     char* curr_file_name;
     unsigned int i;
     unsigned int curr_file_name_length;
     int result;
     for( i = 0; i < num_dentries; i++ )
     {
-        /* Get the current dentry we are looking at stored in the   */
-        /* directories array. Also get the corresponding filename   */
-        /* for comparison.                                          */
-        curr_directory = directories[ i ];
-        curr_file_name = curr_directory.file_name;
-
-        /* Also limit the curr_file_name_length if needed. If not   */
-        /* limited/truncated, then the string may become too long   */
-        /* and bugs may occur.                                      */
-        curr_file_name_length = strlen( (int8_t*)curr_file_name );
-        if( curr_file_name_length > MAX_FILE_NAME_LENGTH )
-        {
-            curr_file_name_length  = MAX_FILE_NAME_LENGTH;
-        }
+        /* Get the filename of the current dentry in place, there  */
+        /* is no need to copy the whole dentry for the comparison.  */
+        curr_file_name = directories[ i ].file_name;
+
+        /* Names of the full MAX_FILE_NAME_LENGTH have no '\0', so  */
+        /* never look past the end of the name field.               */
+        curr_file_name_length = strnlen( (int8_t*)curr_file_name, MAX_FILE_NAME_LENGTH );
 
         /* Compare the lengths of the filenames. If they are not of */
         /* the same length, then they cannot be the same string.    */
@@ -313,20 +318,20 @@ int32_t file_read(int32_t fd, void* buf, int32_t nbytes) {
     memset( buf, '\0', nbytes );    
 
     /* Gets the open file corresponding to the passed in file descriptor to read from */
-    open_file_t curr_file = file_array[fd];  
+    open_file_t* curr_file = get_open_file(fd);
 
     /* Gets the inode of the corresponding current open file */
-    curr_inode_index = curr_file.index_node_num;
+    curr_inode_index = curr_file->index_node_num;
 
     /* Gets the file position offset of current open file */
-    curr_file_position = curr_file.file_position;
+    curr_file_position = curr_file->file_position;
 
     /* Reads nbytes of data from the current open file and copies it into the passed in buffer */
     num_bytes_read = read_data(curr_inode_index, curr_file_position, buf, nbytes);
 
     /* Increments and updates the current file position for the open file */
     curr_file_position += num_bytes_read;
-    file_array[fd].file_position = curr_file_position;
+    curr_file->file_position = curr_file_position;
 
     return num_bytes_read;
 }
@@ -353,6 +358,9 @@ int32_t file_open(const uint8_t* filename) {
 
     if (result == -1) return result; /*FaiL: Named file does not exist*/
 
+    /* syscall_open has already set up the process's descriptor */
+    if (curr_pid >= 0) return 0;
+
     file_type = curr_dentry.file_type;
 
     /* Finds the next available file descriptor position in the global file_array */
@@ -398,10 +406,10 @@ int32_t dir_read(int32_t fd, void* buf, int32_t nbytes) {
     }
 
     /* Gets the open directory corresponding to the passed in file descriptor to read from */
-    open_file_t curr_file = file_array[fd];
+    open_file_t* curr_file = get_open_file(fd);
 
     /* Gets the file position to determine which directory entry to read from */
-    unsigned int curr_position = curr_file.file_position;
+    unsigned int curr_position = curr_file->file_position;
 
     /* Declare other local variables */
     dentry_t curr_dentry;
@@ -424,7 +432,7 @@ int32_t dir_read(int32_t fd, void* buf, int32_t nbytes) {
 
     /* Increments and updates the file position */
     curr_position += 1;
-    file_array[fd].file_position = curr_position;
+    curr_file->file_position = curr_position;
 
     /* Gets the current directory's file name and length */
     file_name = curr_dentry.file_name;
@@ -488,6 +496,9 @@ int32_t dir_open(const uint8_t* filename) {
     
     /* Checks if the file type is actually a directory */
     if (file_type == 1) {
+        /* syscall_open has already set up the process's descriptor */
+        if (curr_pid >= 0) return 0;
+
         /* Finds the next available file descriptor position in the global file_array */
         for (i = 0; i < FILE_ARRAY_SIZE; i++) {
             if (file_array[i].flags != 0) {
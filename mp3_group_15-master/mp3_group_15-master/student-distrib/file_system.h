@@ -17,6 +17,9 @@
 #define DIRECTORY_TYPE       1
 #define REG_FILE_TYPE        2
 #define TERMINAL_FILE_TYPE   3
+#define KLOG_FILE_TYPE       4      /* "dmesg", not stored in the image */
+#define SERIAL_FILE_TYPE     5      /* "serial", the COM1 port */
+#define IRQSTAT_FILE_TYPE    6      /* "irqstat", interrupt statistics */
 #define INIT_FILE_POSITION   0
 #define FD_FREE              0
 #define FD_IN_USE            1
@@ -59,10 +62,14 @@ boot_block_t* p_boot_block_addr;
 inode_t* p_inode_addr;
 data_block_t* p_data_block_addr;
 
-/* Also make the file array global so we can synchronize it */
-/* with each individual process's file array.               */
+/* The kernel's own descriptors, used when no process is   */
+/* running (e.g. by the tests). Processes use the fd_array  */
+/* in their PCB instead.                                    */
 extern open_file_t file_array[FILE_ARRAY_SIZE];
 
+/* Returns the caller's open file for a descriptor */
+extern open_file_t* get_open_file(int32_t fd);
+
 /* Function Declarations */
 /* Initializes the file system and the corresponding global pointers */
 extern void fileSystem_init(uint32_t* fs_start);
@@ -2,6 +2,9 @@
 #include "file_system.h"
 #include "rtc.h"
 #include "terminal.h"
+#include "klog.h"
+#include "serial.h"
+#include "irqstat.h"
 
 /* Global table with address to return in the get_[specific]_table functions. */
 fops_table_t table;
@@ -77,3 +80,39 @@ fops_table_t* get_stdout_table (void) {
     table.close = terminal_close;
     return &table;
 }
+
+/* fops_table_t get_klog_table;
+ *   Inputs: None
+ *   Return Value: fops_table_t
+ *   Function: Assemble the open, read, write, and close functions for the kernel log in a table and return the address */
+fops_table_t* get_klog_table (void) {
+    table.open = klog_open;
+    table.read = klog_read;
+    table.write = klog_write;
+    table.close = klog_close;
+    return &table;
+}
+
+/* fops_table_t get_serial_table;
+ *   Inputs: None
+ *   Return Value: fops_table_t
+ *   Function: Assemble the open, read, write, and close functions for the serial port in a table and return the address */
+fops_table_t* get_serial_table (void) {
+    table.open = serial_open;
+    table.read = serial_read;
+    table.write = serial_write;
+    table.close = serial_close;
+    return &table;
+}
+
+/* fops_table_t get_irqstat_table;
+ *   Inputs: None
+ *   Return Value: fops_table_t
+ *   Function: Assemble the open, read, write, and close functions for the interrupt statistics in a table and return the address */
+fops_table_t* get_irqstat_table (void) {
+    table.open = irqstat_open;
+    table.read = irqstat_read;
+    table.write = irqstat_write;
+    table.close = irqstat_close;
+    return &table;
+}
@@ -18,5 +18,8 @@ extern fops_table_t* get_dir_table(void);
 extern fops_table_t* get_terminal_table(void);
 extern fops_table_t* get_stdout_table(void);
 extern fops_table_t* get_stdin_table(void);
+extern fops_table_t* get_klog_table(void);
+extern fops_table_t* get_serial_table(void);
+extern fops_table_t* get_irqstat_table(void);
 
 #endif
@@ -0,0 +1,223 @@
+#include "frame.h"
+#include "lib.h"
+
+/* Start of upper memory (multiboot mem_upper counts    */
+/* from 1 MB), and the start of the kernel's 4 MB page. */
+#define UPPER_MEM_START     0x00100000
+#define LOW_RESERVED_END    0x00400000
+#define FULL_WORD           0xFFFFFFFF
+
+/* One bit per 4 KB frame, 1 = in use. Frames outside   */
+/* of physical memory stay marked as in use forever.    */
+static uint32_t frame_bitmap[ FRAME_BITMAP_WORDS ];
+static uint32_t frame_count = 0;
+static uint32_t frames_free = 0;
+static uint32_t frame_limit = 0;
+
+/* Bitmap helpers, frame is a frame number (addr >> 12) */
+static inline int32_t frame_test( uint32_t frame )
+{
+    return frame_bitmap[ frame >> 5 ] & ( 1 << ( frame & 31 ) );
+}
+
+static inline void frame_set( uint32_t frame )
+{
+    frame_bitmap[ frame >> 5 ] |= ( 1 << ( frame & 31 ) );
+}
+
+static inline void frame_clear( uint32_t frame )
+{
+    frame_bitmap[ frame >> 5 ] &= ~( 1 << ( frame & 31 ) );
+}
+
+/* --------------------- frame_init ------------------- */
+/* Marks every frame of physical memory from the start  */
+/* of the kernel page up to the top of memory as free.  */
+/* The first 4 MB (BIOS, video memory, 4 KB mapped      */
+/* pages) is never handed out. kernel.c reserves the    */
+/* kernel image, the boot modules and the boot stack    */
+/* afterwards with frame_reserve.                       */
+/* Inputs:          mem_upper_kb -> multiboot mem_upper */
+/*                  or 0 if the bootloader gave none.   */
+/* Outputs:         None.                               */
+/* Side Effects:    Initializes the bitmap.             */
+void frame_init( uint32_t mem_upper_kb )
+{
+    uint32_t frame;
+
+    if( mem_upper_kb == 0 ) {
+        frame_limit = FRAME_DEFAULT_MEM;
+    } else if( mem_upper_kb >= ( FRAME_MAX_PHYS - UPPER_MEM_START ) / 1024 ) {
+        frame_limit = FRAME_MAX_PHYS;
+    } else {
+        frame_limit = UPPER_MEM_START + mem_upper_kb * 1024;
+    }
+    /* Round down to a whole frame */
+    frame_limit &= ~( FRAME_SIZE - 1 );
+
+    memset( frame_bitmap, 0xFF, sizeof( frame_bitmap ) );
+    frame_count = 0;
+    frames_free = 0;
+
+    for( frame = LOW_RESERVED_END >> FRAME_SHIFT; frame < ( frame_limit >> FRAME_SHIFT ); frame++ ) {
+        frame_clear( frame );
+        frame_count++;
+        frames_free++;
+    }
+}
+
+/* -------------------- frame_reserve ----------------- */
+/* Inputs:          start -> first byte of the range    */
+/*                  end   -> one past the last byte     */
+/* Outputs:         None.                               */
+/* Side Effects:    Every frame touching [start, end)   */
+/*                  is marked in use.                   */
+void frame_reserve( uint32_t start, uint32_t end )
+{
+    uint32_t frame;
+    uint32_t flags;
+
+    if( end > frame_limit ) {
+        end = frame_limit;
+    }
+
+    cli_and_save( flags );
+    for( frame = start >> FRAME_SHIFT; ( frame << FRAME_SHIFT ) < end; frame++ ) {
+        if( !frame_test( frame ) ) {
+            frame_set( frame );
+            frames_free--;
+        }
+    }
+    restore_flags( flags );
+}
+
+/* --------------------- frame_alloc ------------------ */
+/* Inputs:          None.                               */
+/* Outputs:         Physical address of a free frame,   */
+/*                  or 0 if none are left.              */
+/* Side Effects:    Marks the frame in use.             */
+uint32_t frame_alloc( void )
+{
+    return frame_alloc_contig( 1, 1 );
+}
+
+/* ------------------ frame_alloc_contig -------------- */
+/* First-fit search for count free frames starting on a */
+/* multiple of align. Whole words are skipped while     */
+/* they are full, and when the request spans whole      */
+/* words (4 MB user pages) they are checked a word at a */
+/* time.                                                */
+/* Inputs:          count -> number of frames           */
+/*                  align -> alignment in frames, must  */
+/*                           be a power of two          */
+/* Outputs:         Physical address of the first frame */
+/*                  or 0 if no such run is free.        */
+/* Side Effects:    Marks the frames in use.            */
+uint32_t frame_alloc_contig( uint32_t count, uint32_t align )
+{
+    uint32_t base, frame, end;
+    uint32_t limit = frame_limit >> FRAME_SHIFT;
+    uint32_t flags;
+
+    if( count == 0 || align == 0 || ( align & ( align - 1 ) ) ) {
+        return 0;
+    }
+
+    cli_and_save( flags );
+
+    base = 0;
+    while( base + count <= limit ) {
+        /* Skip words with no free frame at all */
+        if( frame_bitmap[ base >> 5 ] == FULL_WORD ) {
+            base = ( ( base >> 5 ) + 1 ) << 5;
+            base = ( base + align - 1 ) & ~( align - 1 );
+            continue;
+        }
+
+        /* Look for a used frame in [base, base + count) */
+        end = base + count;
+        for( frame = base; frame < end; ) {
+            if( ( frame & 31 ) == 0 && frame + 32 <= end ) {
+                if( frame_bitmap[ frame >> 5 ] != 0 ) {
+                    break;
+                }
+                frame += 32;
+            } else {
+                if( frame_test( frame ) ) {
+                    break;
+                }
+                frame++;
+            }
+        }
+
+        if( frame >= end ) {
+            for( frame = base; frame < end; frame++ ) {
+                frame_set( frame );
+            }
+            frames_free -= count;
+            restore_flags( flags );
+            return base << FRAME_SHIFT;
+        }
+
+        /* Restart at the next aligned frame past the one in use */
+        base = ( frame + align ) & ~( align - 1 );
+    }
+
+    restore_flags( flags );
+    return 0;
+}
+
+/* --------------------- frame_free ------------------- */
+/* Inputs:          addr -> address from frame_alloc    */
+/* Outputs:         None.                               */
+/* Side Effects:    Marks the frame free.               */
+void frame_free( uint32_t addr )
+{
+    frame_free_contig( addr, 1 );
+}
+
+/* ------------------ frame_free_contig --------------- */
+/* Inputs:          addr  -> address from               */
+/*                           frame_alloc_contig         */
+/*                  count -> number of frames           */
+/* Outputs:         None.                               */
+/* Side Effects:    Marks the frames free. Frames that  */
+/*                  are already free or outside of      */
+/*                  managed memory are ignored.         */
+void frame_free_contig( uint32_t addr, uint32_t count )
+{
+    uint32_t frame = addr >> FRAME_SHIFT;
+    uint32_t end = frame + count;
+    uint32_t flags;
+
+    if( addr < LOW_RESERVED_END || end > ( frame_limit >> FRAME_SHIFT ) ) {
+        return;
+    }
+
+    cli_and_save( flags );
+    for( ; frame < end; frame++ ) {
+        if( frame_test( frame ) ) {
+            frame_clear( frame );
+            frames_free++;
+        }
+    }
+    restore_flags( flags );
+}
+
+/* ------------------ frame statistics ---------------- */
+/* Total frames under management, frames currently      */
+/* free, and the end of managed physical memory.        */
+uint32_t frame_total_count( void )
+{
+    return frame_count;
+}
+
+uint32_t frame_free_count( void )
+{
+    return frames_free;
+}
+
+uint32_t frame_mem_end( void )
+{
+    return frame_limit;
+}
@@ -0,0 +1,57 @@
+#ifndef _FRAME_H
+#define _FRAME_H
+
+#include "types.h"
+
+/* Physical page-frame allocator. Physical memory is    */
+/* tracked in 4 KB frames with one bit per frame in a   */
+/* bitmap (1 = in use). The allocator is set up from    */
+/* the multiboot memory size in kernel.c; anything the  */
+/* kernel needs at run time (process kernel stacks and  */
+/* PCBs, user program pages, kernel objects) is taken   */
+/* from it instead of from fixed addresses.             */
+
+#define FRAME_SIZE          0x1000          /* Size of a single frame (4 KB)                */
+#define FRAME_SHIFT         12              /* log2 of FRAME_SIZE                           */
+#define FRAMES_PER_4MB      1024            /* Frames in one 4 MB page                      */
+
+/* Highest physical address the allocator manages. The  */
+/* kernel identity maps all memory below this address   */
+/* (paging.c), and user space starts at 128 MB, so      */
+/* frames above it could not be reached by the kernel.  */
+#define FRAME_MAX_PHYS      0x08000000
+#define FRAME_MAX_FRAMES    ( FRAME_MAX_PHYS >> FRAME_SHIFT )
+#define FRAME_BITMAP_WORDS  ( FRAME_MAX_FRAMES / 32 )
+
+/* Memory assumed when the bootloader does not report   */
+/* mem_upper: enough for the fixed layout MP3 used      */
+/* before (8 MB kernel + six 4 MB user pages).          */
+#define FRAME_DEFAULT_MEM   0x02000000
+
+/* Sets up the bitmap from the size of upper memory (KB) */
+extern void frame_init( uint32_t mem_upper_kb );
+
+/* Marks the physical range [start, end) as in use      */
+extern void frame_reserve( uint32_t start, uint32_t end );
+
+/* Allocates one frame. Returns its physical address,   */
+/* or 0 if no memory is left.                           */
+extern uint32_t frame_alloc( void );
+
+/* Allocates count physically contiguous frames whose   */
+/* first frame is aligned to align frames (a power of   */
+/* two). Returns the physical address or 0.             */
+extern uint32_t frame_alloc_contig( uint32_t count, uint32_t align );
+
+/* Returns frames to the allocator */
+extern void frame_free( uint32_t addr );
+extern void frame_free_contig( uint32_t addr, uint32_t count );
+
+/* Statistics */
+extern uint32_t frame_total_count( void );
+extern uint32_t frame_free_count( void );
+
+/* End of the managed physical memory */
+extern uint32_t frame_mem_end( void );
+
+#endif /* _FRAME_H */
@@ -5,6 +5,7 @@
 
 #include "i8259.h"
 #include "lib.h"
+#include "apic.h"
 
 /* Interrupt masks to determine which interrupts are enabled and disabled */
 uint8_t master_mask = INITIALIZE_MASK; /* IRQs 0-7  */
@@ -41,13 +42,55 @@ void i8259_init( void ) {
 }
 
 /* void enable_irq(uint32_t irq_num);
+ *   Inputs: uint32_t irq_num --> the IRQ number to enable
+ *   Return Value: none
+ *   Function: Enables (unmasks) the specified IRQ on whichever interrupt
+ *             controller is in use, the I/O APIC or the 8259s */
+void enable_irq(uint32_t irq_num) {
+    if (apic_active) {
+        ioapic_enable_irq(irq_num);
+    } else {
+        i8259_enable_irq(irq_num);
+    }
+}
+
+/* void disable_irq(uint32_t irq_num);
+ *   Inputs: uint32_t irq_num --> the IRQ number to disable
+ *   Return Value: none
+ *   Function: Disables (masks) the specified IRQ on whichever interrupt
+ *             controller is in use, the I/O APIC or the 8259s */
+void disable_irq(uint32_t irq_num) {
+    if (apic_active) {
+        ioapic_disable_irq(irq_num);
+    } else {
+        i8259_disable_irq(irq_num);
+    }
+}
+
+/* void send_eoi(uint32_t irq_num);
+ *   Inputs: uint32_t irq_num --> the IRQ number to send the end-of-interrupt signal for
+ *   Return Value: none
+ *   Function: Send end-of-interrupt signal for the specified IRQ. The local
+ *             APIC ends the highest priority interrupt in service, which is
+ *             the one being handled, so irq_num is only checked */
+void send_eoi(uint32_t irq_num) {
+    if (apic_active) {
+        if (irq_num <= 15) {
+            lapic_eoi();
+        }
+    } else {
+        i8259_send_eoi(irq_num);
+    }
+}
+
+/* void i8259_enable_irq(uint32_t irq_num);
  *   Inputs: uint32_t irq_num --> the IRQ number to enable 
  *   Return Value: none
- *   Function: Enables (unmasks) the specified IRQ
+ *   Function: Enables (unmasks) the specified IRQ on the 8259s
  *             Masks are zero-set:
  *                  0 --> unmasked 
  *                  1 --> masked */
-void enable_irq(uint32_t irq_num) {
+void i8259_enable_irq(uint32_t irq_num) {
     unsigned int value_to_unmask;
     unsigned int new_mask;
     unsigned int base_mask = 0x1;
@@ -96,14 +139,14 @@ void enable_irq(uint32_t irq_num) {
     }
 }
 
-/* void disable_irq(uint32_t irq_num);
+/* void i8259_disable_irq(uint32_t irq_num);
  *   Inputs: uint32_t irq_num --> the IRQ number to disable 
  *   Return Value: none
- *   Function: Disables (masks) the specified IRQ
+ *   Function: Disables (masks) the specified IRQ on the 8259s
  *             Masks are zero-set:
  *                  0 --> unmasked 
  *                  1 --> masked */
-void disable_irq(uint32_t irq_num) {
+void i8259_disable_irq(uint32_t irq_num) {
     unsigned int value_to_unmask;
     unsigned int new_mask;
     unsigned int base_mask = 0x1;
@@ -148,11 +191,11 @@ void disable_irq(uint32_t irq_num) {
     }
 }
 
-/* void send_eoi(uint32_t irq_num);
+/* void i8259_send_eoi(uint32_t irq_num);
  *   Inputs: uint32_t irq_num --> the IRQ number to send the end-of-interrutp signal for
  *   Return Value: none
- *   Function: Send end-of-interrupt signal for the specified IRQ */
-void send_eoi(uint32_t irq_num) {
+ *   Function: Send end-of-interrupt signal for the specified IRQ to the 8259s */
+void i8259_send_eoi(uint32_t irq_num) {
     unsigned int end_of_interrupt;
 
     /* Checks whether the given irq_num is valid */
@@ -35,6 +35,10 @@
 #define MASK_ALL            0xFF
 #define SLAVE_CONNECTION    2
 
+/* Interrupt masks of the two PICs */
+extern uint8_t master_mask;
+extern uint8_t slave_mask;
+
 /* Externally-visible functions */
 
 /* Initialize both PICs */
@@ -46,4 +50,9 @@ void disable_irq(uint32_t irq_num);
 /* Send end-of-interrupt signal for the specified IRQ */
 void send_eoi(uint32_t irq_num);
 
+/* The same three on the 8259s, whichever controller is in use */
+void i8259_enable_irq(uint32_t irq_num);
+void i8259_disable_irq(uint32_t irq_num);
+void i8259_send_eoi(uint32_t irq_num);
+
 #endif /* _I8259_H */
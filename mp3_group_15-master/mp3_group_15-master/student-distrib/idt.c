@@ -93,185 +93,13 @@ void init_idt( )
 
     /* Set PIT interrupt handler */
     SET_IDT_ENTRY( idt[PIT_VECTOR], pit_handler_linkage);
-}
-
-
-/*           FUNCTION HEADER FOR ALL EXCEPTION HANDLERS                 */
-/* Description:     handles the corresponding exception by calling the  */
-/*                  assembly linkage and general exception handler. For */
-/*                  Checkpoint 3.1, the handler will be configured to   */
-/*                  loop infinitely.                                    */
-/* Inputs:          None.                                               */
-/* Outputs:         None.                                               */
-/* Side Effects:    Handles the corresponding exception. Prints the     */
-/*                  exception handled. Loops the program infinitely if  */
-/*                  it is Checkpoint 3.1                                */
-void exception_handler_DE( )
-{
-    exception_wrapper( EXCEPTION_VECTOR_DE );
-    printf("Exception 0 (#DE) (Division by Zero) invoked. Looping...\n");
-
-    while(1){ }
-}
-
-void exception_handler_DB( )
-{
-    exception_wrapper( EXCEPTION_VECTOR_DB );
-    printf("Exception 1 (#DB) (Debug) invoked. Looping...\n");
-
-    while(1){ }
-}
-
-void exception_handler_NMI( )
-{
-    exception_wrapper( EXCEPTION_VECTOR_NMI );
-    printf("Exception 2 (NMI) (Non-Maskable Interrupt) invoked. Looping...\n");
-
-    while(1){ }
-}
-
-void exception_handler_BP( )
-{
-    exception_wrapper( EXCEPTION_VECTOR_BP );
-    printf("Exception 3 (#BP) (Breakpoint) invoked. Looping...\n");
-
-    while(1){ }
-}
-
-void exception_handler_OF( )
-{
-    exception_wrapper( EXCEPTION_VECTOR_OF );
-    printf("Exception 4 (#OF) (Overflow) invoked. Looping...\n");
-
-    while(1){ }
-}
-
-void exception_handler_BR( )
-{
-    exception_wrapper( EXCEPTION_VECTOR_BR );
-    printf("Exception 5 (#BR) (Bound Range Exceeded) invoked. Looping...\n");
-
-    while(1){ }
-}
-
-void exception_handler_UD( )
-{
-    exception_wrapper( EXCEPTION_VECTOR_UD );
-    printf("Exception 6 (#UD) (Invalid Opcode) invoked. Looping...\n");
-
-    while(1){ }
-}
-
-void exception_handler_NM( )
-{
-    exception_wrapper( EXCEPTION_VECTOR_NM );
-    printf("Exception 7 (#NM) (Coprocessor Not Available) invoked. Looping...\n");
-
-    while(1){ }
-}
-
-void exception_handler_DF( )
-{
-    exception_wrapper( EXCEPTION_VECTOR_DF );
-    printf("Exception 8 (#DF) (Double Fault) invoked. Looping...\n");
-
-    while(1){ }
-}
-
-void exception_handler_CSO( )
-{
-    exception_wrapper( EXCEPTION_VECTOR_CSO );
-    printf("Exception 9 (CSO) (Coprocessor Segment Overrun) invoked. Looping...\n");
-    
-    while(1){ }
-}
-
-void exception_handler_TS( )
-{
-    exception_wrapper( EXCEPTION_VECTOR_TS );
-    printf("Exception 10 (#TS) (Invalid Task State Segment) invoked. Looping...\n");
-
-    while(1){ }
-}
-
-void exception_handler_NP( )
-{
-    exception_wrapper( EXCEPTION_VECTOR_NP );
-    printf("Exception 11 (#NP) (Segment Not Present) invoked. Looping...\n");
-
-    while(1){ }
-}
-
-void exception_handler_SS( )
-{
-    exception_wrapper( EXCEPTION_VECTOR_SS );
-    printf("Exception 12 (#SS) (Stack Segment Fault) invoked. Looping...\n");
-
-    while(1){ }
-}
-
-void exception_handler_GP( )
-{
-    exception_wrapper( EXCEPTION_VECTOR_GP );
-    printf("Exception 13 (#GP) (General Protection Fault) invoked. Looping...\n");
-
-    while(1){ }
-}
-
-void exception_handler_PF( )
-{
-    exception_wrapper( EXCEPTION_VECTOR_PF );
-    printf("Exception 14 (#PF) (Page Fault) invoked. Looping...\n");
-
-    while(1){ }
-}
-
-void exception_handler_15( )
-{
-    exception_wrapper( EXCEPTION_VECTOR_15 );
-    printf("Exception 15 (-) (Reserved) invoked. Looping...\n");
-
-    while(1){ }
-}
-
-void exception_handler_MF( )
-{
-    exception_wrapper( EXCEPTION_VECTOR_MF );
-    printf("Exception 16 (#MF) (x87 Floating Point Exception) invoked. Looping...\n");
-
-    while(1){ }
-}
-
-void exception_handler_AC( )
-{
-    exception_wrapper( EXCEPTION_VECTOR_AC );
-    printf("Exception 17 (#AC) (Alignment Check) invoked. Looping...\n");
-
-    while(1){ }
-}
-
-void exception_handler_MC( )
-{
-    exception_wrapper( EXCEPTION_VECTOR_MC );
-    printf("Exception 18 (#MC) (Machine Check) invoked. Looping...\n");
-
-    while(1){ }
-}
-
-void exception_handler_XF( void )
-{
-    exception_wrapper( EXCEPTION_VECTOR_XF );
-    printf("Exception 19 (#XF) (SIMD Floating-Point Exception) invoked. Looping...\n");
-    
-    while(1){ }
-}
 
-void exception_handler_sys_call( )
-{
-    syscall_wrapper( );
-    printf("System Call invoked! Looping in initial handler...\n");
+    /* Set COM1 interrupt handler */
+    SET_IDT_ENTRY( idt[SERIAL_VECTOR], serial_handler_linkage);
 
-    while(1){ }
+    /* Set local APIC spurious interrupt handler */
+    SET_IDT_ENTRY( idt[SPURIOUS_VECTOR], apic_spurious_linkage);
 }
 
+/* The exception entry points are in exception_wrapper.S. */
 /* Vectors 20-31 reserved by Intel. Do not use. */
@@ -16,7 +16,9 @@
 /* Defining interrupt vectors for devices */
 #define PIT_VECTOR               0x20
 #define KEYBOARD_VECTOR          0x21
+#define SERIAL_VECTOR            0x24
 #define RTC_VECTOR               0x28
+#define SPURIOUS_VECTOR          0xFF
 
 /* Vectors nums for exceptions */
 #define EXCEPTION_VECTOR_DE     0
@@ -40,29 +42,6 @@
 #define EXCEPTION_VECTOR_MC     18
 #define EXCEPTION_VECTOR_XF     19
 
-/* Functions defined  */
-void exception_handler_DE( );
-void exception_handler_DB( );
-void exception_handler_NMI( );
-void exception_handler_BP( );
-void exception_handler_OF( );
-void exception_handler_BR( );
-void exception_handler_UD( );
-void exception_handler_NM( );
-void exception_handler_DF( );
-void exception_handler_CSO( );
-void exception_handler_TS( );
-void exception_handler_NP( );
-void exception_handler_SS( );
-void exception_handler_GP( );
-void exception_handler_PF( );
-void exception_handler_15( );
-void exception_handler_MF( );
-void exception_handler_AC( );
-void exception_handler_MC( );
-void exception_handler_XF( );
-void exception_handler_sys_call( );
-
 #endif
 
 
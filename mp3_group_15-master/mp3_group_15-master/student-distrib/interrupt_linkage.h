@@ -8,4 +8,10 @@ extern void rtc_handler_linkage();
 /* Links the PIT interrupt handler funciton through assembly linkage */
 extern void pit_handler_linkage();
 
+/* Links the COM1 interrupt handler function through assembly linkage */
+extern void serial_handler_linkage();
+
+/* Links the local APIC spurious interrupt handler through assembly linkage */
+extern void apic_spurious_linkage();
+
 #endif
@@ -0,0 +1,180 @@
+#include "irqstat.h"
+#include "lib.h"
+#include "file_system.h"
+
+irqstat_t irqstats[ IRQSTAT_LINES ];
+
+/* Names printed in the report */
+static int8_t* const irqstat_names[ IRQSTAT_LINES ] = {
+    "pit", "keyboard", "cascade", "com2", "com1", "irq5", "irq6", "irq7",
+    "rtc", "irq9", "irq10", "irq11", "mouse", "fpu", "ata1", "ata2", "spurious"
+};
+
+/* ---------------------- irqstat_log2 ---------------- */
+/* Inputs:          cycles -> a time in TSC cycles      */
+/* Outputs:         Its histogram bucket                */
+static inline uint32_t irqstat_log2( uint64_t cycles )
+{
+    uint32_t hi = (uint32_t)( cycles >> 32 );
+    uint32_t lo = (uint32_t)cycles;
+    uint32_t bit;
+
+    if( hi != 0 ) {
+        asm( "bsrl %1, %0" : "=r" ( bit ) : "rm" ( hi ) );
+        bit += 32;
+        return ( bit < IRQSTAT_BUCKETS ) ? bit : IRQSTAT_BUCKETS - 1;
+    }
+    if( lo == 0 ) {
+        return 0;
+    }
+    asm( "bsrl %1, %0" : "=r" ( bit ) : "rm" ( lo ) );
+    return bit;
+}
+
+/* --------------------- irqstat_enter ---------------- */
+/* Counts an interrupt and how long it has been since   */
+/* the previous one on the same line.                   */
+/* Inputs:          line -> IRQ, or IRQSTAT_SPURIOUS    */
+/* Outputs:         None.                               */
+/* Side Effects:    Stamps the entry time.              */
+void irqstat_enter( uint32_t line )
+{
+    uint64_t   now = rdtsc( );
+    irqstat_t* stat = &irqstats[ line ];
+
+    if( stat->count != 0 ) {
+        stat->gap_hist[ irqstat_log2( now - stat->last_enter ) ]++;
+    }
+    stat->last_enter = now;
+    stat->count++;
+}
+
+/* ---------------------- irqstat_exit ---------------- */
+/* Adds the time since the latest entry on the line to  */
+/* its handler histogram.                               */
+/* Inputs:          line -> IRQ, or IRQSTAT_SPURIOUS    */
+/* Outputs:         None.                               */
+/* Side Effects:    None.                               */
+void irqstat_exit( uint32_t line )
+{
+    irqstat_t* stat = &irqstats[ line ];
+    uint64_t   cycles = rdtsc( ) - stat->last_enter;
+
+    stat->run_hist[ irqstat_log2( cycles ) ]++;
+    if( cycles > stat->max_cycles ) {
+        stat->max_cycles = ( cycles >> 32 ) ? 0xFFFFFFFF : (uint32_t)cycles;
+    }
+    stat->exits++;
+}
+
+/* -------------------- irqstat_format_hist ----------- */
+/* Formats the non-empty buckets of a histogram as      */
+/* "  title: 2^b:count ..." followed by a newline.      */
+/* Outputs:         Length of the line.                 */
+static int32_t irqstat_format_hist( int8_t* line, int8_t* title, const uint32_t* hist )
+{
+    int32_t  len;
+    uint32_t b;
+
+    len = snprintf( line, IRQSTAT_LINE_LEN, "  %s:", title );
+    for( b = 0; b < IRQSTAT_BUCKETS; b++ ) {
+        if( hist[ b ] != 0 ) {
+            len += snprintf( line + len, IRQSTAT_LINE_LEN - len, " 2^%u:%u", b, hist[ b ] );
+        }
+    }
+    len += snprintf( line + len, IRQSTAT_LINE_LEN - len, "\n" );
+    return len;
+}
+
+/* ------------------- irqstat_read_text -------------- */
+/* Formats the report line by line and copies the part  */
+/* from byte *pos on into buf. The counters keep moving */
+/* while a reader walks the report, so a report read in */
+/* several pieces may mix a few interrupts.             */
+/* Inputs:          pos    -> byte offset to start at   */
+/*                  buf    -> buffer to fill            */
+/*                  nbytes -> size of buf               */
+/* Outputs:         Number of bytes stored.             */
+int32_t irqstat_read_text( uint32_t* pos, uint8_t* buf, int32_t nbytes )
+{
+    int8_t     line[ IRQSTAT_LINE_LEN ];
+    irqstat_t* stat;
+    uint32_t   offset = 0;
+    int32_t    done = 0;
+    int32_t    len, i, part, skip;
+
+    for( i = -1; i < IRQSTAT_LINES * 3 && done < nbytes; i++ ) {
+        /* Line -1 is the heading, then three per line used */
+        if( i < 0 ) {
+            len = snprintf( line, IRQSTAT_LINE_LEN, "irq name count max_cycles (histograms in TSC cycles)\n" );
+        } else {
+            stat = &irqstats[ i / 3 ];
+            if( stat->count == 0 ) {
+                continue;
+            }
+            switch( i % 3 ) {
+                case 0:
+                    len = snprintf( line, IRQSTAT_LINE_LEN, "%u %s %u %u\n", i / 3,
+                                    irqstat_names[ i / 3 ], stat->count, stat->max_cycles );
+                    break;
+                case 1:
+                    len = irqstat_format_hist( line, "handler", stat->run_hist );
+                    break;
+                default:
+                    len = irqstat_format_hist( line, "between", stat->gap_hist );
+                    break;
+            }
+        }
+
+        /* Copy whatever part of the line is past *pos */
+        if( offset + len > *pos ) {
+            skip = ( *pos > offset ) ? *pos - offset : 0;
+            part = len - skip;
+            if( part > nbytes - done ) {
+                part = nbytes - done;
+            }
+            memcpy( buf + done, line + skip, part );
+            done += part;
+            *pos += part;
+        }
+        offset += len;
+    }
+    return done;
+}
+
+/* ---------------------- irqstat_open ---------------- */
+/* Inputs:          filename -> unused                  */
+/* Outputs:         0, reading starts at the top.       */
+int32_t irqstat_open( const uint8_t* filename )
+{
+    return 0;
+}
+
+/* ---------------------- irqstat_read ---------------- */
+/* Reads the report. The file position is the byte      */
+/* offset into it, so reads continue where the last one */
+/* stopped and return 0 at the end.                     */
+/* Inputs:          fd     -> file descriptor           */
+/*                  buf    -> buffer to fill            */
+/*                  nbytes -> size of buf               */
+/* Outputs:         Number of bytes read, -1 on error.  */
+int32_t irqstat_read( int32_t fd, void* buf, int32_t nbytes )
+{
+    if( buf == NULL || nbytes <= 0 ) {
+        return -1;
+    }
+    return irqstat_read_text( &get_open_file( fd )->file_position, buf, nbytes );
+}
+
+/* --------------------- irqstat_write ---------------- */
+/* The report is read only.                             */
+int32_t irqstat_write( int32_t fd, const void* buf, int32_t nbytes )
+{
+    return -1;
+}
+
+/* --------------------- irqstat_close ---------------- */
+int32_t irqstat_close( int32_t fd )
+{
+    return 0;
+}
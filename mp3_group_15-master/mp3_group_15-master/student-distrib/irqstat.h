@@ -0,0 +1,53 @@
+#ifndef _IRQSTAT_H
+#define _IRQSTAT_H
+
+/* Interrupt accounting. The interrupt linkage calls    */
+/* irqstat_enter before a handler and irqstat_exit      */
+/* right after it, before the deferred work runs, so    */
+/* the time in between is how long the handler kept     */
+/* interrupts off. Both times are kept as histograms    */
+/* with log2 buckets of TSC cycles: bucket b counts     */
+/* values from 2^b up to 2^(b+1) - 1. The report is     */
+/* read through the "irqstat" pseudo-file.              */
+/* A PIT tick that switches processes is charged up to  */
+/* the point the next process returns from its own tick.*/
+
+#define IRQSTAT_LINES       17              /* The 16 ISA IRQs, then spurious           */
+#define IRQSTAT_SPURIOUS    16
+#define IRQSTAT_BUCKETS     40
+#define IRQSTAT_LINE_LEN    700             /* Longest line of the report               */
+
+#ifndef ASM
+
+#include "types.h"
+
+#define IRQSTAT_FILE_NAME   "irqstat"
+
+typedef struct irqstat_t {
+    uint32_t count;                         /* Interrupts taken                         */
+    uint32_t exits;                         /* Handler runs that returned               */
+    uint32_t max_cycles;                    /* Longest handler run                      */
+    uint64_t last_enter;                    /* TSC at the latest interrupt              */
+    uint32_t run_hist[ IRQSTAT_BUCKETS ];   /* Handler run time                         */
+    uint32_t gap_hist[ IRQSTAT_BUCKETS ];   /* Time since the previous interrupt        */
+} irqstat_t;
+
+extern irqstat_t irqstats[ IRQSTAT_LINES ];
+
+/* Called by the interrupt linkage around each handler */
+extern void irqstat_enter( uint32_t line );
+extern void irqstat_exit( uint32_t line );
+
+/* Formats the report from byte *pos on into buf,       */
+/* advancing *pos. Returns the bytes stored, 0 at end.  */
+extern int32_t irqstat_read_text( uint32_t* pos, uint8_t* buf, int32_t nbytes );
+
+/* File operations of the irqstat pseudo-file */
+extern int32_t irqstat_open( const uint8_t* filename );
+extern int32_t irqstat_read( int32_t fd, void* buf, int32_t nbytes );
+extern int32_t irqstat_write( int32_t fd, const void* buf, int32_t nbytes );
+extern int32_t irqstat_close( int32_t fd );
+
+#endif /* ASM */
+
+#endif /* _IRQSTAT_H */
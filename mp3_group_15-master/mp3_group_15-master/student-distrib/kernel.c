@@ -14,6 +14,12 @@
 #include "file_system.h"
 #include "syscall.h"
 #include "scheduling.h"
+#include "frame.h"
+#include "klog.h"
+#include "serial.h"
+#include "clock.h"
+#include "timer.h"
+#include "apic.h"
 
 /* Set to 1 to run all test cases */
 #define RUN_TESTS 0
@@ -23,6 +29,22 @@
 /* Ignore for now, already tests in launch_tests() */
 #define ENABLE_RTC 1
 
+/* Set to 1 to use the local APIC and I/O APIC instead  */
+/* of the 8259 PICs when the CPU has them.              */
+#define ENABLE_APIC 1
+
+/* Set to 1 to copy the kernel log to COM1 as it is     */
+/* written, e.g. to watch it with qemu -serial stdio.   */
+#define KLOG_TO_SERIAL 1
+
+/* Size of the boot stack set up in boot.S, which grows */
+/* down from 8 MB.                                      */
+#define BOOT_STACK_TOP  0x800000
+#define BOOT_STACK_SIZE 0x2000
+
+/* End of the kernel image, provided by the linker */
+extern uint8_t _end[];
+
 /* Set to 1 if we want to run "shell".  */
 #define SHELL_ENABLE 0
 
@@ -162,15 +184,48 @@ void entry(unsigned long magic, unsigned long addr) {
     uint32_t* file_system_start_addr = (uint32_t*) (module_addr->mod_start);
     fileSystem_init(file_system_start_addr);
 
+    /* Initialize the page-frame allocator from the memory size the */
+    /* bootloader reported, then keep the kernel image, the boot    */
+    /* modules and the boot stack out of it.                        */
+    frame_init( CHECK_FLAG(mbi->flags, 0) ? mbi->mem_upper : 0 );
+    frame_reserve( KERNEL_START_ADDR, (uint32_t) _end );
+    uint32_t mod_index;
+    for (mod_index = 0; mod_index < mbi->mods_count; mod_index++) {
+        frame_reserve( module_addr[mod_index].mod_start, module_addr[mod_index].mod_end );
+    }
+    frame_reserve( BOOT_STACK_TOP - BOOT_STACK_SIZE, BOOT_STACK_TOP );
+    klog( KLOG_INFO, "memory: %u KB, %u of %u frames free",
+          frame_mem_end( ) / 1024, frame_free_count( ), frame_total_count( ) );
+
     /* Initialize paging */
     page_init();
 
+    /* Calibrate the TSC, while interrupts are still off */
+    clock_init();
+
+    /* Move the IRQs to the APIC, if there is one. This has */
+    /* to happen after paging, which maps its registers.    */
+    #if ENABLE_APIC
+    apic_init();
+    #endif
+
+    /* Set up the kernel timers, run by the PIT */
+    timer_wheel_init();
+
     /* Initialize keyboard */
     keyboard_init();
 
     /* Initialize terminal driver */
     terminals_init();    
 
+    /* Initialize the COM1 serial port */
+    if (serial_init()) {
+        #if KLOG_TO_SERIAL
+        klog_sinks |= KLOG_SINK_SERIAL;
+        #endif
+        klog( KLOG_INFO, "serial: COM1 at 115200 baud" );
+    }
+
     /* Initialize the RTC */
     #if ENABLE_RTC
     if (rtc_init()){
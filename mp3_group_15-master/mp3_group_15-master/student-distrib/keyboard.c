@@ -2,6 +2,9 @@
 #include "lib.h"
 #include "i8259.h"
 #include "syscall.h"
+#include "scheduling.h"
+#include "deferred.h"
+#include "signal.h"
 
 #define TESTMODE 1
 
@@ -10,7 +13,6 @@
 /* address this.                                                */
 int     terminal_x[ NUM_TERMINALS ]; 
 int     terminal_y[ NUM_TERMINALS ]; 
-char*   terminal_video_mem;
 
 /* Also keep track of the wordcount, and characters typed to    */
 /* the keyboard. Since the size of the terminal buffer is 128,  */
@@ -24,14 +26,39 @@ int     word_count[ NUM_TERMINALS ];
 /* characters in the buffer is 128. Initialize to '0' on start  */
 uint8_t  keyboard_buffer[ NUM_TERMINALS ][ BUFFER_SIZE ];
 
+/* Attribute used for printing on each terminal, changed by     */
+/* ANSI escape sequences, and their parser states.              */
+static uint8_t      term_attrib[ NUM_TERMINALS ];
+static ansi_state_t ansi_state[ NUM_TERMINALS ];
+
 /* Keep track of the last character in the line printed for     */
-/* backspace support, initialized to zero at start.             */
-static int  end_of_line[ NUM_ROWS ] = { 0, 0, 0, 0, 0,
-                                        0, 0, 0, 0, 0,
-                                        0, 0, 0, 0, 0,
-                                        0, 0, 0, 0, 0,
-                                        0, 0, 0, 0, 0
-};
+/* backspace support, per terminal, initialized to zero.        */
+static int  end_of_line[ NUM_TERMINALS ][ NUM_ROWS ];
+
+/* Row of the terminal's video region shown as the top of the   */
+/* screen. Scrolling moves it down one row and points the VGA   */
+/* CRTC start address at it instead of copying the screen.      */
+int     terminal_top[ NUM_TERMINALS ];
+
+/* Scrollback history: lines that scrolled off the top of each  */
+/* terminal, kept in a ring of SCROLLBACK_ROWS rows.            */
+static uint8_t  scrollback[ NUM_TERMINALS ][ SCROLLBACK_ROWS ][ ROW_BYTES ];
+static int      scrollback_head[ NUM_TERMINALS ];
+static int      scrollback_count[ NUM_TERMINALS ];
+
+/* How many lines the display terminal is scrolled back, 0 when */
+/* it shows the live screen.                                    */
+static int      scrollback_view = 0;
+
+static void scroll_region( int32_t term, char* video );
+static int32_t terminal_wrap( int32_t term, char* video );
+static void terminal_ansi( int32_t term, char* video, uint8_t c );
+static int32_t terminal_emit_char( int32_t term, char* video, uint8_t c );
+static void terminal_output( int32_t term, uint8_t c, int32_t parse_ansi );
+
+/* Address of a cell of the visible screen in a video region    */
+#define SCREEN_CELL( video, term, row, col ) \
+    ( (video) + ( ( NUM_COLS * ( terminal_top[ term ] + ( row ) ) + ( col ) ) << 1 ) )
 
 
 
@@ -125,24 +152,54 @@ void keyboard_init( void ) {
         terminal_x[ i ] = 0;
         terminal_y[ i ] = 0;
     }
-    terminal_video_mem = (char *)VIDEO_MEM_LOC;
-
-    /* Also initialize the keyboard buffer and word_count */
-    reset_keyboard_buffer( );
-
-    memset( terminal_vid_mem, 0, TERMINAL_MEMORY_SIZE );
-
 
+    /* Also initialize the keyboard buffers and word_counts */
+    for( i = 0; i < NUM_TERMINALS; i++ )
+    {
+        reset_keyboard_buffer( i );
+        term_attrib[ i ] = ATTRIB;
+        ansi_state[ i ].state = ANSI_NORMAL;
+    }
 }
 
 /* void keyboard_handler( void );
  *   Inputs: none
  *   Return Value: none
- *   Function: Handles keyboard interrupts when a keystroke is pressed to print the corresponding character to the screen */
+ *   Function: Handles keyboard interrupts. Only reads the scancode and
+ *             queues it for keyboard_process_scancode, which echoes it
+ *             after the EOI with interrupts enabled */
 void keyboard_handler( void ) {
     /* Reads in a physical keystroke */
     unsigned int scancode = inb(KEYBOARD_PORT_IO);
+
+    defer_work( keyboard_process_scancode, scancode );
+
+    /* Sends end-of-interrupt signal to PIC to notify that we are done handling keyboard interrupt */
+    send_eoi( KEYBOARD_IRQ_NUM );
+}
+
+/* void keyboard_process_scancode( uint32_t scancode );
+ *   Inputs: scancode -- the scancode read by keyboard_handler
+ *   Return Value: none
+ *   Function: Deferred half of the keyboard interrupt. Updates the
+ *             modifier keys and prints the corresponding character to the
+ *             screen, or clears / switches terminals on hotkeys */
+void keyboard_process_scancode( uint32_t scancode ) {
     int scancode_flag = 0;
+    int32_t pid;
+
+    /* Shift + Page Up / Page Down scroll through the history   */
+    /* of the display terminal.                                 */
+    if( shift && scancode == PAGE_UP_PRESSED )
+    {
+        terminal_scrollback( SCROLLBACK_STEP );
+        return;
+    }
+    if( shift && scancode == PAGE_DOWN_PRESSED )
+    {
+        terminal_scrollback( -SCROLLBACK_STEP );
+        return;
+    }
 
     /* Update the special characters. Function also tells us if */
     /* the scancode falls outside the acceptable bounds.        */
@@ -155,7 +212,6 @@ void keyboard_handler( void ) {
     /* don't actually have any character to print.              */
     if( ( scancode_flag == -1 ) || ( scancode_flag == 1 ) )
     {
-        send_eoi(KEYBOARD_IRQ_NUM);
         return;
     }
 
@@ -196,11 +252,21 @@ void keyboard_handler( void ) {
         {
             /* Clear and reset the terminal */
             clear_and_reset_screen( );
-            /* Make sure to end the interrupt after cleared */
-            send_eoi( KEYBOARD_IRQ_NUM );
             /* Return to avoid printing anything else */
             return;
         }
+
+        /* Ctrl + C interrupts the program in front on the  */
+        /* displayed terminal. The base shells are left be. */
+        if( scancode == C_PRESSED )
+        {
+            pid = terminals[ display_terminal ].pid;
+            if( pid >= 0 && pid_array[ pid ] == PID_IN_USE && get_pcb( pid )->parent_id != -1 )
+            {
+                signal_raise( pid, SIG_INTERRUPT );
+            }
+            return;
+        }
     }
 
     if( alt )
@@ -210,29 +276,23 @@ void keyboard_handler( void ) {
 
             case F1:
                 switch_terminal( 0 );
-                send_eoi( KEYBOARD_IRQ_NUM );
                 return;
             case F2:
                 switch_terminal( 1 );
-                send_eoi( KEYBOARD_IRQ_NUM );
                 return;
             case F3:
                 switch_terminal( 2 );
-                send_eoi( KEYBOARD_IRQ_NUM );
                 return;
             
             #if TESTMODE
             case 0x02:
                 switch_terminal( 0 );
-                send_eoi( KEYBOARD_IRQ_NUM );
                 return;
             case 0x03:
                 switch_terminal( 1 );
-                send_eoi( KEYBOARD_IRQ_NUM );
                 return;
             case 0x04:
                 switch_terminal( 2 );
-                send_eoi( KEYBOARD_IRQ_NUM );
                 return;
             #endif
             
@@ -248,10 +308,6 @@ void keyboard_handler( void ) {
         /* ONLY print on keypress, NOT release.                    */
         keyboard_putc( keycode );
     }
-
-
-    /* Sends end-of-interrupt signal to PIC to notify that we are done handling keyboard interrupt */
-    send_eoi( KEYBOARD_IRQ_NUM );
 }
 
 /*            process_type_of_character             */
@@ -370,11 +426,22 @@ int process_type_of_character( unsigned int scancode )
 void clear_and_reset_screen( void )
 {
     int32_t i;
-    /* Clear video memory by setting all to ' ' and ATTRIB.     */
+    uint32_t flags;
+    char* video;
+
+    cli_and_save( flags );
+
+    /* Start the screen over at the top of the video region.    */
+    terminal_top[ display_terminal ] = 0;
+    terminal_show_screen( );
+
+    /* Clear the display terminal's screen by setting all to    */
+    /* ' ' and ATTRIB.                                          */
+    video = terminal_video_base( display_terminal );
     for( i = 0; i < NUM_ROWS * NUM_COLS; i++ )
     {
-        *(uint8_t *)(VIDEO_MEM_LOC + (i << 1)) = ' ';
-        *(uint8_t *)(VIDEO_MEM_LOC + (i << 1) + 1) = ATTRIB;
+        *(uint8_t *)(video + (i << 1)) = ' ';
+        *(uint8_t *)(video + (i << 1) + 1) = ATTRIB;
     }
 
     /* Reset x and y values so that we can print to the         */
@@ -385,108 +452,381 @@ void clear_and_reset_screen( void )
     /* Also set end_of_line tracker */
     for( i = 0; i < NUM_ROWS; i++ )
     {
-        end_of_line[ i ] = 0;
+        end_of_line[ display_terminal ][ i ] = 0;
     }
 
     /* Finally, reset the cursor. */
     terminal_print_cursor( terminal_y[ display_terminal ], terminal_x[ display_terminal ] );
 
+    restore_flags( flags );
     return;
 }
 
-/*           void terminal_putc( uint8_t c )            */
-/* Description: prints the character to the console.    */
-/* Customized to handle newlines, backspace, line       */
-/* overflow.                                            */
-/* Will support terminal buffer in the future...        */
+/*           void keyboard_putc( uint8_t c )            */
+/* Description: echoes a typed character to the display */
+/* terminal and records it in that terminal's keyboard  */
+/* buffer. Handles newlines (the line is queued on the  */
+/* terminal's input ring) and backspace (removes the    */
+/* last buffered character). In raw mode the character  */
+/* is queued right away without echo or editing.        */
 /* Inputs: c -> character to be printed                 */
 /* Outputs: None.                                       */
 /* Side Effects: prints given character to screen, or   */
-/* deletes a character from the screen, or scrolls the  */
-/* screen, depending on what is passsed in, and the     */
-/* current x and y location.                            */
+/* deletes a character from the screen, and updates the */
+/* keyboard buffer of the displayed terminal.           */
 void keyboard_putc( uint8_t c )
 {    
+    int32_t term = display_terminal;
+
+    if( terminals[ term ].mode & TERM_MODE_RAW )
+    {
+        terminal_input( term, &c, 1 );
+        return;
+    }
+
+    /* Enter is always queued as a line feed. */
+    if( c == '\r' )
+    {
+        c = '\n';
+    }
+
+    /* The Esc key has nothing to show in a line of input. */
+    if( c == ESCAPE )
+    {
+        return;
+    }
+
     /* First, check if the buffer is full. If so, then  */
     /* do NOT allow more printing to occur. However, we */
     /* want to allow '\n' and BACKSPACE, since we want  */
     /* to be able to remove characters from the buffer, */
     /* and use '\n' to "enter" the command to the       */
     /* terminal.                                        */
-    if( ( word_count[ display_terminal ] >= BUFFER_SIZE - 1 ) && ( c != '\n' && c != BACKSPACE ) )
+    if( ( word_count[ term ] >= BUFFER_SIZE - 1 ) && ( c != '\n' && c != BACKSPACE ) )
     {
         /* Do not nothing if buffer full. Since the last character  */
         /* in the buffer must be '\n', we want to reserve the very  */
         /* last index of the buffer for such.                       */
         
         /* Update the cursor */
-        terminal_print_cursor( terminal_y[ display_terminal ], terminal_x[ display_terminal ] );
+        terminal_print_cursor( terminal_y[ term ], terminal_x[ term ] );
 
         return;
     }
 
     /* Also don't allow printing if the buffer is empty and we      */
     /* attempt to delete a character.                               */
-    if( ( word_count[ display_terminal ] == 0 ) && ( c == BACKSPACE ) )
+    if( ( word_count[ term ] == 0 ) && ( c == BACKSPACE ) )
     {
-        terminal_print_cursor( terminal_y[ display_terminal ], terminal_x[ display_terminal ] );
+        terminal_print_cursor( terminal_y[ term ], terminal_x[ term ] );
 
         return;
     }
-    
+
+    /* Echo the character to the screen of the display terminal.   */
+    /* Typed text is shown as is, even if a program left an escape */
+    /* sequence half written.                                       */
+    terminal_output( term, c, 0 );
+
+    if( c == BACKSPACE )
+    {
+        /* Decrease wordcount. The check above makes sure that a    */
+        /* character exists that can be deleted.                    */
+        word_count[ term ]--;
+
+        /* Remove the character from the keyboard buffer. */
+        keyboard_buffer[ term ][ word_count[ term ] ] = 0;
+        return;
+    }
+
+    /* Update the keyboard buffer by passing in the character   */
+    /* into the buffer. Also update the word_count. These two   */
+    /* operations will go towards the terminal support.         */
+    keyboard_buffer[ term ][ word_count[ term ] ] = c;
+    word_count[ term ]++;
+
+    if( c == '\n' )
+    {
+        /* The line is complete: queue it for the readers of this   */
+        /* terminal and start a new one. Lines typed while nobody   */
+        /* is reading wait in the ring; if it is full the line is   */
+        /* dropped.                                                 */
+        terminal_input( term, keyboard_buffer[ term ], word_count[ term ] );
+        reset_keyboard_buffer( term );
+    }
+}
+
+/*  void terminal_fill( int32_t term, char* video, int row, int from, int to )  */
+/* Description: blanks the cells [from, to) of a row of a terminal's screen     */
+/* with the terminal's current attribute.                                       */
+/* Inputs: term -> terminal to erase in                                         */
+/*         video -> the terminal's video region                                 */
+/*         row -> screen row                                                    */
+/*         from, to -> first column and one past the last column                */
+/* Outputs: None.                                                               */
+/* Side Effects: Erases the cells.                                              */
+static void terminal_fill( int32_t term, char* video, int row, int from, int to )
+{
+    char* cell = SCREEN_CELL( video, term, row, 0 );
+
+    for( ; from < to; from++ )
+    {
+        cell[ from << 1 ] = ' ';
+        cell[ ( from << 1 ) + 1 ] = term_attrib[ term ];
+    }
+}
+
+/*  void terminal_ansi( int32_t term, char* video, uint8_t c )      */
+/* Description: feeds one character of an escape sequence to the    */
+/* parser of a terminal. The supported subset of ANSI/VT100 is:     */
+/*   ESC [ row ; col H  (or f)  move the cursor, 1-based            */
+/*   ESC [ n A / B / C / D      cursor up / down / right / left     */
+/*   ESC [ n K                  erase to end (0), start (1) or all  */
+/*                              (2) of the line                     */
+/*   ESC [ n J                  erase to end (0), start (1) or all  */
+/*                              (2) of the screen                   */
+/*   ESC [ s / u                save / restore the cursor           */
+/*   ESC [ a ; b ... m          attributes: 0 reset, 1 bright, 7    */
+/*                              reverse, 30-37 / 39 foreground,     */
+/*                              40-47 / 49 background               */
+/* Anything else ends the sequence and is ignored.                  */
+/* Inputs: term -> terminal being written to                        */
+/*         video -> the terminal's video region                     */
+/*         c -> next character of the sequence                      */
+/* Outputs: None.                                                   */
+/* Side Effects: May move the cursor, erase the screen or change    */
+/* the attribute used for printing.                                 */
+static void terminal_ansi( int32_t term, char* video, uint8_t c )
+{
+    /* ANSI color order is black, red, green, yellow, blue,     */
+    /* magenta, cyan, white; the VGA palette swaps red/blue.    */
+    static const uint8_t ansi_to_vga[ ANSI_NUM_COLORS ] = { 0, 4, 2, 6, 1, 5, 3, 7 };
+    ansi_state_t* esc = &ansi_state[ term ];
+    int32_t n = esc->params[ 0 ] ? esc->params[ 0 ] : 1;
+    int32_t i, p, row;
+
+    if( esc->state == ANSI_ESCAPE )
+    {
+        /* Only CSI sequences are supported. */
+        if( c == ANSI_CSI )
+        {
+            esc->state = ANSI_PARAMS;
+            esc->nparams = 1;
+            for( i = 0; i < ANSI_MAX_PARAMS; i++ )
+            {
+                esc->params[ i ] = 0;
+            }
+        }
+        else
+        {
+            esc->state = ANSI_NORMAL;
+        }
+        return;
+    }
+
+    /* Collect the numeric parameters. */
+    if( c >= '0' && c <= '9' )
+    {
+        p = esc->params[ esc->nparams - 1 ];
+        if( p < ANSI_PARAM_MAX )
+        {
+            esc->params[ esc->nparams - 1 ] = p * 10 + ( c - '0' );
+        }
+        return;
+    }
+    if( c == ';' )
+    {
+        if( esc->nparams < ANSI_MAX_PARAMS )
+        {
+            esc->nparams++;
+        }
+        return;
+    }
+
+    /* Any other character is the command and ends the sequence. */
+    esc->state = ANSI_NORMAL;
+    switch( c )
+    {
+        case 'H':
+        case 'f':
+            row = esc->params[ 0 ] ? esc->params[ 0 ] : 1;
+            p = esc->params[ 1 ] ? esc->params[ 1 ] : 1;
+            terminal_y[ term ] = ( row > NUM_ROWS ) ? NUM_ROWS - 1 : row - 1;
+            terminal_x[ term ] = ( p > NUM_COLS ) ? NUM_COLS - 1 : p - 1;
+            break;
+        case 'A':
+            terminal_y[ term ] = ( terminal_y[ term ] > n ) ? terminal_y[ term ] - n : 0;
+            break;
+        case 'B':
+            terminal_y[ term ] = ( terminal_y[ term ] + n < NUM_ROWS ) ? terminal_y[ term ] + n : NUM_ROWS - 1;
+            break;
+        case 'C':
+            terminal_x[ term ] = ( terminal_x[ term ] + n < NUM_COLS ) ? terminal_x[ term ] + n : NUM_COLS - 1;
+            break;
+        case 'D':
+            /* Also leaves the pending wrap after a full line. */
+            if( terminal_x[ term ] >= NUM_COLS )
+            {
+                terminal_x[ term ] = NUM_COLS - 1;
+            }
+            terminal_x[ term ] = ( terminal_x[ term ] > n ) ? terminal_x[ term ] - n : 0;
+            break;
+        case 'K':
+            p = esc->params[ 0 ];
+            if( p == 0 )
+            {
+                terminal_fill( term, video, terminal_y[ term ], terminal_x[ term ], NUM_COLS );
+            }
+            else if( p == 1 )
+            {
+                terminal_fill( term, video, terminal_y[ term ], 0, terminal_x[ term ] + 1 );
+            }
+            else
+            {
+                terminal_fill( term, video, terminal_y[ term ], 0, NUM_COLS );
+            }
+            break;
+        case 'J':
+            p = esc->params[ 0 ];
+            for( row = 0; row < NUM_ROWS; row++ )
+            {
+                if( ( p == 0 && row > terminal_y[ term ] ) || ( p == 1 && row < terminal_y[ term ] ) || p == 2 )
+                {
+                    terminal_fill( term, video, row, 0, NUM_COLS );
+                    end_of_line[ term ][ row ] = 0;
+                }
+            }
+            if( p == 0 )
+            {
+                terminal_fill( term, video, terminal_y[ term ], terminal_x[ term ], NUM_COLS );
+            }
+            else if( p == 1 )
+            {
+                terminal_fill( term, video, terminal_y[ term ], 0, terminal_x[ term ] + 1 );
+            }
+            break;
+        case 's':
+            esc->saved_x = terminal_x[ term ];
+            esc->saved_y = terminal_y[ term ];
+            break;
+        case 'u':
+            terminal_x[ term ] = esc->saved_x;
+            terminal_y[ term ] = esc->saved_y;
+            break;
+        case 'm':
+            for( i = 0; i < esc->nparams; i++ )
+            {
+                p = esc->params[ i ];
+                if( p == 0 )
+                {
+                    term_attrib[ term ] = ATTRIB;
+                }
+                else if( p == 1 )
+                {
+                    term_attrib[ term ] |= ATTRIB_BRIGHT;
+                }
+                else if( p == 7 )
+                {
+                    term_attrib[ term ] = ( ( term_attrib[ term ] & ATTRIB_FG_MASK ) << ATTRIB_BG_SHIFT )
+                                        | ( ( term_attrib[ term ] >> ATTRIB_BG_SHIFT ) & ATTRIB_FG_MASK );
+                }
+                else if( p >= ANSI_FG_FIRST && p < ANSI_FG_FIRST + ANSI_NUM_COLORS )
+                {
+                    term_attrib[ term ] = ( term_attrib[ term ] & ~ATTRIB_FG_COLOR ) | ansi_to_vga[ p - ANSI_FG_FIRST ];
+                }
+                else if( p == ANSI_FG_DEFAULT )
+                {
+                    term_attrib[ term ] = ( term_attrib[ term ] & ~ATTRIB_FG_COLOR ) | ATTRIB;
+                }
+                else if( p >= ANSI_BG_FIRST && p < ANSI_BG_FIRST + ANSI_NUM_COLORS )
+                {
+                    term_attrib[ term ] = ( term_attrib[ term ] & ATTRIB_FG_MASK )
+                                        | ( ansi_to_vga[ p - ANSI_BG_FIRST ] << ATTRIB_BG_SHIFT );
+                }
+                else if( p == ANSI_BG_DEFAULT )
+                {
+                    term_attrib[ term ] &= ATTRIB_FG_MASK;
+                }
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/*  int32_t terminal_emit( int32_t term, char* video, uint8_t c )   */
+/* Description: shared part of terminal_putc and terminal_puts.     */
+/* Prints one character to the screen of a terminal at video,       */
+/* handling newlines, backspace, line overflow and escape           */
+/* sequences (see terminal_ansi). Does not touch                    */
+/* the VGA registers; the callers update the start address and the  */
+/* cursor once they are done.                                       */
+/* Inputs: term -> terminal to print to                             */
+/*         video -> the terminal's video region                     */
+/*         c -> character to be printed                             */
+/* Outputs: 1 if the screen scrolled, 0 otherwise.                  */
+/* Side Effects: prints given character to screen, or deletes a     */
+/* character from the screen, or scrolls the screen, depending on   */
+/* what is passsed in, and the current x and y location.            */
+static int32_t terminal_emit( int32_t term, char* video, uint8_t c )
+{
+    /* Characters of an escape sequence are not printed.    */
+    if( ansi_state[ term ].state != ANSI_NORMAL )
+    {
+        terminal_ansi( term, video, c );
+        return 0;
+    }
+    if( c == ESCAPE )
+    {
+        ansi_state[ term ].state = ANSI_ESCAPE;
+        return 0;
+    }
+
+    return terminal_emit_char( term, video, c );
+}
+
+/*  int32_t terminal_emit_char( int32_t term, char* video, uint8_t c )  */
+/* Description: the part of terminal_emit after escape sequences:       */
+/* prints one character, handling newlines, backspace and line          */
+/* overflow. Used directly for keyboard echo.                           */
+/* Inputs: term -> terminal to print to                                 */
+/*         video -> the terminal's video region                         */
+/*         c -> character to be printed                                 */
+/* Outputs: 1 if the screen scrolled, 0 otherwise.                      */
+/* Side Effects: prints, deletes or scrolls as terminal_emit does.      */
+static int32_t terminal_emit_char( int32_t term, char* video, uint8_t c )
+{
+    int32_t scrolled = 0;
 
     /* First, check if newline passed through. If so,   */
     /* move characters to new line and reset x value.   */
     /* Additionally, if printing causes the line to run */
     /* out, then go to the next line if available.      */
-    /* NOTE: Currently configured NOT to support new    */
-    /* rows, i.e. if at bottom of screen, remain at     */
-    /* bottom.                                          */
     if( c == '\n' || c == '\r' )
     {
+        /* Set end of line to terminal_x - 1, since terminal_x and  */
+        /* terminal_y represent the next printable space.           */
+        if( terminal_x[ term ] != 0 )
+        {
+            end_of_line[ term ][ terminal_y[ term ] ] = terminal_x[ term ] - 1;
+        }
+
         /* If NOT at bottom of screen, go to new line.  */
-        if( terminal_y[ display_terminal ] != NUM_ROWS - 1 )
+        if( terminal_y[ term ] != NUM_ROWS - 1 )
         {
-            /* Set end of line to terminal_x - 1, since */
-            /* terminal_x and terminal_y represent the  */
-            /* next printable space.                    */
-            if( terminal_x[ display_terminal ] != 0 )
-            {
-                end_of_line[ terminal_y[ display_terminal ] ] = terminal_x[ display_terminal ] - 1;
-            }
             /* Set y row to next row and x to start of  */
             /* row.                                     */
-            terminal_y[ display_terminal ] = ( terminal_y[ display_terminal ] + 1 ) % NUM_ROWS;
-            terminal_x[ display_terminal ] = 0;
+            terminal_y[ term ]++;
+            terminal_x[ term ] = 0;
         }
         else
         {
             /* Else, we are at the bottom of the screen.    */
             /* Add a newline by scrolling the screen down   */
             /* and resetting the terminal_x value.          */
-            /* Also, update end of line tracker.            */
-            if( terminal_x[ display_terminal ] != 0 )
-            {
-                end_of_line[ terminal_y[ display_terminal ] ] = terminal_x[ display_terminal ] - 1;
-            }
-            else
-            {
-                end_of_line[ terminal_y[ display_terminal ] ] = terminal_x[ display_terminal ];
-            }
-            /* Scroll screen.                               */
-            scroll_screen( );
+            scroll_region( term, video );
+            scrolled = 1;
         }
-
-        /* Update the keyboard buffer by passing in the character   */
-        /* into the buffer. Also update the word_count. These two   */
-        /* operations will go towards the terminal support.         */
-        keyboard_buffer[ display_terminal ][ word_count[ display_terminal ] ] = c;
-        word_count[ display_terminal ]++;
-
-        /* Set the read_ready flag to indicate that the enter key   */
-        /* has been pressed.                                        */
-        read_ready = 1;
-
     }
     /* Check if BACKSPACE was passed through.       */
     /* If so, then replace last char with ' '. We   */
@@ -494,118 +834,223 @@ void keyboard_putc( uint8_t c )
     /* line as well.                                */
     else if( c == BACKSPACE )
     {
-        /* Check if backspace will move into previous   */
-        /* line. If so, change x and y accordingly.     */
-
         /* If terminal_x is at zero, then the last char */
         /* printed was on the previous line. Check if   */
         /* at top of screen. If so, do nothing. Else,   */
         /* delete from end of last line.                */
-        if( terminal_x[ display_terminal ] == 0 )
+        if( terminal_x[ term ] == 0 )
         {
             /* Do nothing if at top-left corner of screen. */
-            if( terminal_y[ display_terminal ] == 0 )
+            if( terminal_y[ term ] == 0 )
             {
-                /* Update end of line tracker to be beginning of line */
-                end_of_line[ terminal_y[ display_terminal ] ] = 0;
-                return;
-            }
-            /* Else, get location of last printed character. */
-            else
-            {
-                /* Update end of line for current line */
-                end_of_line[ terminal_y[ display_terminal ] ] = 0;
-
-                /* Update terminal_x to print to the right space. */
-                terminal_x[ display_terminal ] = end_of_line[ terminal_y[ display_terminal ] - 1 ];
-                /* Also update terminal_y to prev line. */
-                terminal_y[ display_terminal ]--;
+                end_of_line[ term ][ 0 ] = 0;
+                return scrolled;
             }
+            /* Update end of line for current line, and go to   */
+            /* the location of last printed character.          */
+            end_of_line[ term ][ terminal_y[ term ] ] = 0;
+            terminal_y[ term ]--;
+            terminal_x[ term ] = end_of_line[ term ][ terminal_y[ term ] ];
         }
         else
         {
-            terminal_x[ display_terminal ]--;
-            if( terminal_x[ display_terminal ] != 0 )
-            {
-                end_of_line[ terminal_y[ display_terminal ] ] = terminal_x[ display_terminal ];
-            }
-            else
-            {
-                end_of_line[ terminal_y[ display_terminal ] ] = 0;
-            }
+            terminal_x[ term ]--;
+            end_of_line[ term ][ terminal_y[ term ] ] = terminal_x[ term ];
         }
-        /* Set c to ' ' to figuratively "delete" the last character.     */
-        c = ' ';
-        /* Print over character pointed to by terminal_y and terminal_x. */
-        *(uint8_t *)(VIDEO_MEM_LOC + ((NUM_COLS * terminal_y[ display_terminal ] + terminal_x[ display_terminal ]) << 1)) = c;
-        *(uint8_t *)(VIDEO_MEM_LOC + ((NUM_COLS * terminal_y[ display_terminal ] + terminal_x[ display_terminal ]) << 1) + 1) = ATTRIB;
-
-        /* Decrease wordcount. Since this section is already configured */
-        /* to return if at top-left corner, we can safely decrement the */
-        /* word_count, since this part is designed to make sure that a  */
-        /* character exists that can be deleted.                        */
-        word_count[ display_terminal ]--;
+        /* Print ' ' over character pointed to by terminal_y and    */
+        /* terminal_x to figuratively "delete" the last character.  */
+        *(uint8_t *)SCREEN_CELL( video, term, terminal_y[ term ], terminal_x[ term ] ) = ' ';
+        *(uint8_t *)(SCREEN_CELL( video, term, terminal_y[ term ], terminal_x[ term ] ) + 1) = term_attrib[ term ];
+    }
+    /* Else, print the charcater and increment the values of terminal_x */
+    /* and terminal_y accordingly.                                      */
+    else
+    {
+        scrolled = terminal_wrap( term, video );
 
-        /* Remove the character from the keyboard buffer. */
-        keyboard_buffer[ display_terminal ][ word_count[ display_terminal ] ] = 0;
+        /* Update the end of line tracker before printing.              */
+        end_of_line[ term ][ terminal_y[ term ] ] = terminal_x[ term ];
+        *(uint8_t *)SCREEN_CELL( video, term, terminal_y[ term ], terminal_x[ term ] ) = c;
+        *(uint8_t *)(SCREEN_CELL( video, term, terminal_y[ term ], terminal_x[ term ] ) + 1) = term_attrib[ term ];
+        terminal_x[ term ]++;
     }
-    /* Check if printing a character at the current terminal_x value    */
-    /* prints outside of the allowed bounds. If so, scroll to the next  */
-    /* line.                                                            */
-    else if( terminal_x[ display_terminal ] >= NUM_COLS )
+
+    return scrolled;
+}
+
+/*     int32_t terminal_wrap( int32_t term, char* video )   */
+/* Description: if the current line of a terminal is full,  */
+/* moves to the start of the next one, scrolling the screen */
+/* if necessary.                                            */
+/* Inputs: term -> terminal to print to                     */
+/*         video -> the terminal's video region             */
+/* Outputs: 1 if the screen scrolled, 0 otherwise.          */
+/* Side Effects: May scroll the screen.                     */
+static int32_t terminal_wrap( int32_t term, char* video )
+{
+    int32_t scrolled = 0;
+
+    /* Check if printing a character at the current terminal_x  */
+    /* value prints outside of the allowed bounds. If so, move  */
+    /* to the next line, scrolling the screen if necessary.     */
+    if( terminal_x[ term ] >= NUM_COLS )
     {
-        /* Reset the value of terminal_x to zero and move to the next   */
-        /* line. Scroll screen if necessary.                            */
-        if( terminal_y[ display_terminal ] != NUM_ROWS - 1 )
+        if( terminal_y[ term ] != NUM_ROWS - 1 )
         {
-            /* Not at bottom of screen, no need to scroll. Find the     */
-            /* next y value and reset x to zero.                        */
-            terminal_y[ display_terminal ] = ( terminal_y[ display_terminal ] + 1 ) % NUM_ROWS;
+            terminal_y[ term ]++;
         }
         else
         {
-            /* Scroll the screen and reset x to the beginning of line.  */   
-            scroll_screen( );
+            scroll_region( term, video );
+            scrolled = 1;
         }
-        terminal_x[ display_terminal ] = 0;
-
-        /* Print at the current location, then update the values of x   */
-        /* and y accordingly.                                           */
-        *(uint8_t *)(VIDEO_MEM_LOC + ((NUM_COLS * terminal_y[ display_terminal ] + terminal_x[ display_terminal ]) << 1)) = c;
-        *(uint8_t *)(VIDEO_MEM_LOC + ((NUM_COLS * terminal_y[ display_terminal ] + terminal_x[ display_terminal ]) << 1) + 1) = ATTRIB;
-        terminal_x[ display_terminal ]++;
-
-        /* Also update the end of line tracker, add the character to    */
-        /* the keyboard buffer, and increase the word count.            */
-        end_of_line[ terminal_y[ display_terminal ] ] = terminal_x[ display_terminal ];
-        keyboard_buffer[ display_terminal ][ word_count[ display_terminal ] ] = c;
-        word_count[ display_terminal ]++;
-    }
-    /* Else, print the charcater normally and increment the values of   */
-    /* terminal_x and terminal_y accordingly.                           */
-    else
+        terminal_x[ term ] = 0;
+    }
+
+    return scrolled;
+}
+
+/*     void terminal_putc( int32_t term, uint8_t c )    */
+/* Description: prints the character to the screen of   */
+/* the given terminal, in the terminal's VGA region.    */
+/* Customized to handle newlines, backspace, line       */
+/* overflow.                                            */
+/* Inputs: term -> terminal to print to                 */
+/*         c -> character to be printed                 */
+/* Outputs: None.                                       */
+/* Side Effects: prints given character to screen, or   */
+/* deletes a character from the screen, or scrolls the  */
+/* screen, depending on what is passsed in, and the     */
+/* current x and y location.                            */
+void terminal_putc( int32_t term, uint8_t c )
+{
+    terminal_output( term, c, 1 );
+}
+
+/*  void terminal_output( int32_t term, uint8_t c, int32_t parse_ansi ) */
+/* Description: terminal_putc, with the escape sequence parser left     */
+/* out when parse_ansi is 0.                                            */
+/* Inputs: term -> terminal to print to                                 */
+/*         c -> character to be printed                                 */
+/*         parse_ansi -> 1 to pass c through the escape parser          */
+/* Outputs: None.                                                       */
+/* Side Effects: see terminal_putc.                                     */
+static void terminal_output( int32_t term, uint8_t c, int32_t parse_ansi )
+{
+    uint32_t flags;
+    char*    video;
+    int32_t  scrolled;
+
+    /* A terminal switch changes which screen the VGA shows and  */
+    /* the keyboard echoes into the same screen, so keep both    */
+    /* from happening while we are in the middle of printing.    */
+    cli_and_save( flags );
+    video = terminal_video_base( term );
+
+    scrolled = parse_ansi ? terminal_emit( term, video, c ) : terminal_emit_char( term, video, c );
+
+    /* Also, update the screen and the cursor if this terminal  */
+    /* is on screen. Output to the screen being looked at ends  */
+    /* the scrollback view so the new text is visible.          */
+    if( term == display_terminal )
     {
-        /* Assumes that the value of x is valid for printing. Don't     */
-        /* worry about line overflow, as that should be supported by    */
-        /* the previous if statement.                                   */
+        if( scrolled || scrollback_view != 0 )
+        {
+            terminal_show_screen( );
+        }
+        terminal_print_cursor( terminal_y[ term ], terminal_x[ term ] );
+    }
+    restore_flags( flags );
+}
 
-        /* Update the end of line tracker before printing.              */
-        end_of_line[ terminal_y[ display_terminal ] ] = terminal_x[ display_terminal ];
-        /* Print the character to the screen at the current location    */
-        /* determined by terminal_x. terminal_x should not be able to   */
-        /* overflow, and thus we can print without worry.               */
-        *(uint8_t *)(VIDEO_MEM_LOC + ((NUM_COLS * terminal_y[ display_terminal ] + terminal_x[ display_terminal ]) << 1)) = c;
-        *(uint8_t *)(VIDEO_MEM_LOC + ((NUM_COLS * terminal_y[ display_terminal ] + terminal_x[ display_terminal ]) << 1) + 1) = ATTRIB;
-        terminal_x[ display_terminal ]++;
+/* int32_t terminal_puts( int32_t term, const uint8_t* buf, int32_t n ) */
+/* Description: bulk version of terminal_putc used by terminal_write.   */
+/* Runs of printable characters are copied straight into the video      */
+/* region a line at a time; only control characters and escape          */
+/* sequences go through terminal_emit. Interrupts are only off for one  */
+/* line, or PUTS_CHUNK characters, at a time, so a long write does not  */
+/* hold them off for long. The VGA start address is written at most     */
+/* once, after all scrolling is done, and the cursor once at the end.   */
+/* Inputs: term -> terminal to print to                                 */
+/*         buf -> characters to print                                   */
+/*         n -> number of characters in buf                             */
+/* Outputs: Number of characters printed. Stops early at a NUL.         */
+/* Side Effects: prints the characters to the terminal's screen.        */
+int32_t terminal_puts( int32_t term, const uint8_t* buf, int32_t n )
+{
+    uint32_t flags;
+    char*    video;
+    char*    cell;
+    int32_t  scrolled = 0;
+    int32_t  i = 0;
+    int32_t  chunk_end;
+    int32_t  run;
+    int32_t  room;
+    uint8_t  c = 0;
+
+    while( i < n )
+    {
+        /* A terminal switch may move the screen between chunks.    */
+        cli_and_save( flags );
+        video = terminal_video_base( term );
+        chunk_end = ( n - i > PUTS_CHUNK ) ? i + PUTS_CHUNK : n;
+
+        while( i < chunk_end )
+        {
+            c = buf[ i ];
+            if( c == '\0' )
+            {
+                break;
+            }
+
+            if( c == '\n' || c == '\r' || c == BACKSPACE || c == ESCAPE || ansi_state[ term ].state != ANSI_NORMAL )
+            {
+                scrolled |= terminal_emit( term, video, c );
+                i++;
+                if( ( c == '\n' || c == '\r' ) && ansi_state[ term ].state == ANSI_NORMAL )
+                {
+                    break;
+                }
+                continue;
+            }
+
+            /* Copy as many printable characters as fit on this line. */
+            scrolled |= terminal_wrap( term, video );
+            room = NUM_COLS - terminal_x[ term ];
+            cell = SCREEN_CELL( video, term, terminal_y[ term ], terminal_x[ term ] );
+            for( run = 0; run < room && i < chunk_end; run++, i++ )
+            {
+                c = buf[ i ];
+                if( c == '\0' || c == '\n' || c == '\r' || c == BACKSPACE || c == ESCAPE )
+                {
+                    break;
+                }
+                cell[ run << 1 ] = c;
+                cell[ ( run << 1 ) + 1 ] = term_attrib[ term ];
+            }
+            terminal_x[ term ] += run;
+            end_of_line[ term ][ terminal_y[ term ] ] = terminal_x[ term ] - 1;
+        }
+        restore_flags( flags );
 
-        /* Also add the character to the keyboard buffer and increment  */
-        /* the word_count for tracking.                                 */
-        keyboard_buffer[ display_terminal ][ word_count[ display_terminal ] ] = c;
-        word_count[ display_terminal ]++;
+        if( c == '\0' )
+        {
+            break;
+        }
     }
 
-    /* Also, update cursor */
-    terminal_print_cursor( terminal_y[ display_terminal ], terminal_x[ display_terminal ] );
+    cli_and_save( flags );
+    if( term == display_terminal )
+    {
+        if( scrolled || scrollback_view != 0 )
+        {
+            terminal_show_screen( );
+        }
+        terminal_print_cursor( terminal_y[ term ], terminal_x[ term ] );
+    }
+    restore_flags( flags );
+
+    return i;
 }
 
 /*             terminal_print_cursor                */
@@ -613,6 +1058,8 @@ void keyboard_putc( uint8_t c )
 /* pointed to by terminal_y and terminal_x. Code referenced     */
 /* from osdev.org. Link:                                        */
 /* https://wiki.osdev.org/Text_Mode_Cursor#Moving_the_Cursor    */
+/* The row is relative to the top of the display terminal's     */
+/* screen, which need not be the start of video memory.         */
 /* Inputs: target_row, target_col. Would use terminal_y and     */
 /* terminal_x instead and give the function no inputs, but this */
 /* allows the function to actually be called outside of the     */
@@ -626,7 +1073,8 @@ void terminal_print_cursor( int cur_row, int cur_col )
     /* cursor starts and ends.                                  */
     /* Find the position on the VGA that corresponds to where   */
     /* the cursor should be.                                    */
-    uint16_t cursor_position = NUM_COLS * cur_row + cur_col;
+    uint16_t cursor_position = display_terminal * TERM_REGION_CHARS
+                             + NUM_COLS * ( terminal_top[ display_terminal ] + cur_row ) + cur_col;
 
     /* Set the VGA registers accordingly using the outb         */
     /* function provided by lib.h. Make sure to connect to the  */
@@ -650,60 +1098,185 @@ void terminal_print_cursor( int cur_row, int cur_col )
     outb( cursor_position_shifted_masked, VGA_BASE2 );
 }
 
-/*              void scroll_screen( void )                  */
+/*          void scroll_screen( int32_t term )              */
 /* Scrolls the screen, adding another line to the bottom of */
 /* the screen while erasing the top line of the screen.     */
-/* Inputs: none.                                            */
+/* The top line is saved to the scrollback history. The     */
+/* screen then moves down one row of the terminal's video   */
+/* region and the VGA start address follows it, so only the */
+/* new bottom line is written. Once the screen reaches the  */
+/* end of the region it is copied back to the start, which  */
+/* happens once every REGION_ROWS - NUM_ROWS lines.         */
+/* Inputs: term -> terminal whose screen is scrolled.       */
 /* Outputs: none.                                           */
-/* Side Effects: Scrolls the screen. May erase lines from   */
-/* the top to make room for the bottom. Used in             */
-/* keyboard_putc to implement newline scrolling.            */
-void scroll_screen( void )
+/* Side Effects: Scrolls the screen.                        */
+void scroll_screen( int32_t term )
 {
-    /* Accomplish scrolling by shifting video memory up the */
-    /* screen. We do not have to account for history, nor   */
-    /* support scrolling the screen up. We only need to     */
-    /* support scrolling the screen down.                   */
+    uint32_t flags;
+
+    cli_and_save( flags );
+    scroll_region( term, terminal_video_base( term ) );
 
-    /* Scroll the video memory up */
-    int cur_row;
-    int cur_col;
-    for( cur_row = 0; cur_row < NUM_ROWS - 1; cur_row++ )
+    /* Move the screen and the cursor if it is displayed.   */
+    if( term == display_terminal )
     {
-        for( cur_col = 0; cur_col < NUM_COLS; cur_col++ )
-        {
-            /* Take on the memory of the row below the current row. */
-            *(uint8_t *)(VIDEO_MEM_LOC + ((NUM_COLS * cur_row + cur_col) << 1)) = *(uint8_t *)(terminal_video_mem + ((NUM_COLS * ( cur_row + 1 ) + cur_col) << 1));
-            *(uint8_t *)(VIDEO_MEM_LOC + ((NUM_COLS * cur_row + cur_col) << 1) + 1) = *(uint8_t *)(terminal_video_mem + ((NUM_COLS * ( cur_row + 1 ) + cur_col) << 1) + 1);
-        }
+        terminal_show_screen( );
+        terminal_print_cursor( terminal_y[ term ], terminal_x[ term ] );
     }
+    restore_flags( flags );
+}
+
+/*     void scroll_region( int32_t term, char* video )      */
+/* Does the work of scroll_screen in the video region of    */
+/* the terminal without touching the VGA registers, so a    */
+/* batch of output updates them only once.                  */
+/* Inputs: term -> terminal whose screen is scrolled.       */
+/*         video -> the terminal's video region.            */
+/* Outputs: none.                                           */
+/* Side Effects: Scrolls the screen in video memory.        */
+static void scroll_region( int32_t term, char* video )
+{
+    int i;
 
-    cur_row = NUM_ROWS - 1;
-    uint8_t c = ' ';
-    /* On the last row, set the values to blank. */
-    for( cur_col = 0; cur_col < NUM_COLS; cur_col++ )
+    /* Save the line about to disappear into the history.   */
+    memcpy( scrollback[ term ][ scrollback_head[ term ] ], SCREEN_CELL( video, term, 0, 0 ), ROW_BYTES );
+    scrollback_head[ term ] = ( scrollback_head[ term ] + 1 ) % SCROLLBACK_ROWS;
+    if( scrollback_count[ term ] < SCROLLBACK_ROWS )
     {
-        *(uint8_t *)(VIDEO_MEM_LOC + ((NUM_COLS * cur_row + cur_col) << 1)) = c;
-        *(uint8_t *)(VIDEO_MEM_LOC + ((NUM_COLS * cur_row + cur_col) << 1) + 1) = ATTRIB;
-        
+        scrollback_count[ term ]++;
     }
 
-    int i;
+    if( terminal_top[ term ] + NUM_ROWS < REGION_ROWS )
+    {
+        /* Room left below the screen, just move down a row.    */
+        terminal_top[ term ]++;
+    }
+    else
+    {
+        /* Copy the lines that stay on screen back to the start */
+        /* of the region.                                       */
+        memcpy( video, SCREEN_CELL( video, term, 1, 0 ), ( NUM_ROWS - 1 ) * ROW_BYTES );
+        terminal_top[ term ] = 0;
+    }
+
+    /* Blank the last row in the current colors, so a set   */
+    /* background fills the new line too.                   */
+    terminal_fill( term, video, NUM_ROWS - 1, 0, NUM_COLS );
+
     /* Shift the values in the end of line buffer to        */
     /* account for the scrolling                            */
     for( i = 0; i < NUM_ROWS - 1; i++ )
     {
-        end_of_line[ i ] = end_of_line[ i + 1 ];
+        end_of_line[ term ][ i ] = end_of_line[ term ][ i + 1 ];
     }
-    end_of_line[ NUM_ROWS - 1 ] = 0;
+    end_of_line[ term ][ NUM_ROWS - 1 ] = 0;
 
     /* Also reset terminal x and y values just in case... */
-    terminal_x[ display_terminal ] = 0;
-    terminal_y[ display_terminal ] = NUM_ROWS - 1;
+    terminal_x[ term ] = 0;
+    terminal_y[ term ] = NUM_ROWS - 1;
+}
 
-    /* And don't forget to update the cursor after scrolling. */
-    terminal_print_cursor( terminal_y[ display_terminal ], terminal_x[ display_terminal ] );
+/*          void scroll_reset( int32_t term )               */
+/* Copies a terminal's screen back to the start of its      */
+/* video region, for code that expects the screen to begin  */
+/* there (vidmap, kernel printf).                           */
+/* Inputs: term -> terminal to reset.                       */
+/* Outputs: none.                                           */
+/* Side Effects: Moves the screen and the cursor.           */
+void scroll_reset( int32_t term )
+{
+    uint32_t flags;
+    char* video;
+
+    cli_and_save( flags );
+    if( terminal_top[ term ] != 0 )
+    {
+        video = terminal_video_base( term );
+        memcpy( video, SCREEN_CELL( video, term, 0, 0 ), NUM_ROWS * ROW_BYTES );
+        terminal_top[ term ] = 0;
+    }
+    if( term == display_terminal )
+    {
+        terminal_show_screen( );
+        terminal_print_cursor( terminal_y[ term ], terminal_x[ term ] );
+    }
+    restore_flags( flags );
+}
+
+/*          set_display_start                               */
+/* Sets the VGA CRTC start address, the offset in           */
+/* characters from 0xB8000 of the first character shown.    */
+static void set_display_start( uint16_t offset )
+{
+    outb( VGA_HIGH_BYTE_OFF, VGA_BASE1 );
+    outb( ( offset >> HIGH_BYTE_SHIFT ) & BYTE_MASK, VGA_BASE2 );
+    outb( VGA_LOW_BYTE_OFF, VGA_BASE1 );
+    outb( offset & BYTE_MASK, VGA_BASE2 );
+}
+
+/*          void terminal_show_screen( void )               */
+/* Points the VGA at the live screen of the display         */
+/* terminal, leaving the scrollback view if it was open.    */
+/* Inputs: none.                                            */
+/* Outputs: none.                                           */
+/* Side Effects: Writes the CRTC start address.             */
+void terminal_show_screen( void )
+{
+    scrollback_view = 0;
+    set_display_start( display_terminal * TERM_REGION_CHARS + terminal_top[ display_terminal ] * NUM_COLS );
+}
+
+/*          void terminal_scrollback( int32_t lines )       */
+/* Scrolls the view of the display terminal back (lines     */
+/* positive) or forward through its history. The view is    */
+/* built in the spare VGA region after the terminals' ones  */
+/* and shown by moving the VGA start address there; the     */
+/* live screen is untouched.                                */
+/* Inputs: lines -> lines to move the view by.              */
+/* Outputs: none.                                           */
+/* Side Effects: Changes what is shown on screen.           */
+void terminal_scrollback( int32_t lines )
+{
+    int32_t term = display_terminal;
+    char* live;
+    char* view;
+    int row, line, index;
+    uint32_t flags;
+
+    cli_and_save( flags );
+
+    scrollback_view += lines;
+    if( scrollback_view > scrollback_count[ term ] )
+    {
+        scrollback_view = scrollback_count[ term ];
+    }
+    if( scrollback_view <= 0 )
+    {
+        terminal_show_screen( );
+        restore_flags( flags );
+        return;
+    }
+
+    /* Lines are numbered from the oldest history line, the     */
+    /* live screen follows the history.                         */
+    live = terminal_video_base( term );
+    view = TERM_VIEW_REGION;
+    for( row = 0; row < NUM_ROWS; row++ )
+    {
+        line = scrollback_count[ term ] - scrollback_view + row;
+        if( line < scrollback_count[ term ] )
+        {
+            index = ( scrollback_head[ term ] - scrollback_count[ term ] + line + SCROLLBACK_ROWS ) % SCROLLBACK_ROWS;
+            memcpy( view + row * ROW_BYTES, scrollback[ term ][ index ], ROW_BYTES );
+        }
+        else
+        {
+            memcpy( view + row * ROW_BYTES, SCREEN_CELL( live, term, line - scrollback_count[ term ], 0 ), ROW_BYTES );
+        }
+    }
 
+    set_display_start( ( (uint32_t)view - VIDEO_MEM_LOC ) >> 1 );
+    restore_flags( flags );
 }
 
 
@@ -733,19 +1306,19 @@ void put_string( const uint8_t* string )
 /* Resets the keyboard buffer, initializing all of its      */
 /* contents to 0, which we will use in determining whether  */
 /* we have reached the end of the buffer or not.            */
-/* Inputs: None.                                            */
+/* Inputs: term -> terminal whose input is discarded.       */
 /* Outputs: None.                                           */
 /* Side Effects: Clears keyboard_buffer and word_count.     */
-void reset_keyboard_buffer( void )
+void reset_keyboard_buffer( int32_t term )
 {
     /* Reset keyboard_buffer to 0 on request */
     int i;
     for( i = 0; i < BUFFER_SIZE; i++ )
     {
-        keyboard_buffer[ display_terminal ][ i ] = 0;
+        keyboard_buffer[ term ][ i ] = 0;
     }
     /* Also reset the word_count */
-    word_count[ display_terminal ] = 0;
+    word_count[ term ] = 0;
 
 }
 
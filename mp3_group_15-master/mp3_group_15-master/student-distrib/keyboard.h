@@ -1,3 +1,6 @@
+#ifndef _KEYBOARD_H
+#define _KEYBOARD_H
+
 /* Include statements */
 #include "i8259.h"
 #include "terminal.h"
@@ -39,6 +42,47 @@
 #define NUM_COLS    80
 #define NUM_ROWS    25
 #define ATTRIB      0x7
+#define ROW_BYTES   ( NUM_COLS * 2 )
+
+/* Parts of a VGA attribute byte */
+#define ATTRIB_FG_COLOR     0x07        /* Foreground color without the bright bit  */
+#define ATTRIB_BRIGHT       0x08        /* Bright foreground                        */
+#define ATTRIB_FG_MASK      0x0F
+#define ATTRIB_BG_SHIFT     4
+
+/* ANSI escape sequences understood by terminal_write, see      */
+/* terminal_ansi. The parser state is kept per terminal.        */
+#define ANSI_CSI            '['
+#define ANSI_MAX_PARAMS     4
+#define ANSI_PARAM_MAX      1000        /* Parameters stop growing past this        */
+#define ANSI_NUM_COLORS     8
+#define ANSI_FG_FIRST       30
+#define ANSI_FG_DEFAULT     39
+#define ANSI_BG_FIRST       40
+#define ANSI_BG_DEFAULT     49
+
+#define ANSI_NORMAL         0           /* Printing characters                      */
+#define ANSI_ESCAPE         1           /* Got ESC                                  */
+#define ANSI_PARAMS         2           /* Got ESC [, reading parameters            */
+
+typedef struct ansi_state_t {
+    int32_t state;                          /* ANSI_NORMAL, ANSI_ESCAPE or ANSI_PARAMS  */
+    int32_t nparams;                        /* Parameters seen so far                   */
+    int32_t params[ ANSI_MAX_PARAMS ];      /* Parameter values, 0 if left out          */
+    int32_t saved_x;                        /* Cursor saved by ESC [ s                  */
+    int32_t saved_y;
+} ansi_state_t;
+
+/* Rows of a terminal's 8KB video region, and the number of     */
+/* lines kept in each terminal's scrollback history.            */
+#define REGION_ROWS         ( TERM_REGION_SIZE / ROW_BYTES )
+#define SCROLLBACK_ROWS     200
+#define SCROLLBACK_STEP     ( NUM_ROWS / 2 )
+
+/* Most characters terminal_puts prints in one stretch  */
+/* with interrupts off. A stretch also ends at a line   */
+/* break, so it scrolls the screen at most once.        */
+#define PUTS_CHUNK          NUM_COLS
 
 /* Define Special Character Key Constants*/
 #define ESCAPE_PRESSED          0x01
@@ -58,6 +102,13 @@
 #define LEFT_ALT_PRESSED        0x38
 #define LEFT_ALT_RELEASED       0xB8
 
+/* Shift + Page Up / Page Down move through the scrollback */
+#define PAGE_UP_PRESSED         0x49
+#define PAGE_DOWN_PRESSED       0x51
+
+/* Ctrl + C sends SIG_INTERRUPT */
+#define C_PRESSED               0x2E
+
 /* Special keys to ignore */
 #define KEYPAD_STAR_PRESSED     0x37
 
@@ -81,38 +132,55 @@
 /* functions.                                           */
 extern int      terminal_x[ NUM_TERMINALS ];
 extern int      terminal_y[ NUM_TERMINALS ];
-extern char*    terminal_video_mem;
 extern uint8_t  keyboard_buffer[ NUM_TERMINALS ][ BUFFER_SIZE ];
 extern int      word_count[ NUM_TERMINALS ];
+extern int      terminal_top[ NUM_TERMINALS ];
 
 /* Declare functions */
 
 /* Initializes the keyboard */
 extern void keyboard_init( void );
 
-/* Handles keyboard interrupts when a keystroke is pressed to print the corresponding character to the screen */
+/* Handles keyboard interrupts: reads the scancode and defers its processing */
 extern void keyboard_handler( void );
 
+/* Deferred half of the keyboard interrupt, prints the corresponding character to the screen */
+extern void keyboard_process_scancode( uint32_t scancode );
+
 /* Helper function for keyboard handler - updates the special scancodes we're looking for. */
 extern int process_type_of_character( unsigned int scancode ); 
 
 /* Helper function to clear the screen and reset the printing location */
 extern void clear_and_reset_screen( void );
 
-/* Helper function to print character to screen. Modified version of putc. */
+/* Echoes a typed character to the display terminal and its keyboard buffer. */
 extern void keyboard_putc( uint8_t c );
 
+/* Helper function to print character to a terminal's screen. Modified version of putc. */
+extern void terminal_putc( int32_t term, uint8_t c );
+
+/* Prints a buffer to a terminal's screen in one pass, stopping at a NUL. */
+extern int32_t terminal_puts( int32_t term, const uint8_t* buf, int32_t n );
+
 /* Function to print cursor to screen */
 extern void terminal_print_cursor( int cur_row, int cur_col );
 
-/* Function to scroll the screen */
-extern void scroll_screen( void );
+/* Function to scroll the screen of a terminal */
+extern void scroll_screen( int32_t term );
 
-/* Function to print a string to the screen. Follows very closely to puts. */
-extern void put_string( const uint8_t* string );
+/* Moves a terminal's screen back to the start of its region */
+extern void scroll_reset( int32_t term );
+
+/* Points the VGA at the live screen of the display terminal */
+extern void terminal_show_screen( void );
 
-/* Function to reset the keyboard buffer. */
-extern void reset_keyboard_buffer( void );
+/* Moves the scrollback view of the display terminal by lines (up is positive) */
+extern void terminal_scrollback( int32_t lines );
 
+/* Function to print a string to the screen. Follows very closely to puts. */
+extern void put_string( const uint8_t* string );
 
+/* Function to reset the keyboard buffer of a terminal. */
+extern void reset_keyboard_buffer( int32_t term );
 
+#endif /* _KEYBOARD_H */
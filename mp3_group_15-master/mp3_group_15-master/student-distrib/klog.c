@@ -0,0 +1,198 @@
+#include "klog.h"
+#include "lib.h"
+#include "scheduling.h"
+#include "file_system.h"
+#include "serial.h"
+
+/* The log. A writer takes the next index with an       */
+/* atomic add, so every writer gets its own record even */
+/* if an interrupt handler logs in the middle of        */
+/* another klog(). The record is marked complete by     */
+/* writing its seq last; readers skip records whose seq */
+/* does not match the index they expect.                */
+static klog_record_t klog_ring[ KLOG_RECORDS ];
+volatile uint32_t klog_head = 0;
+uint32_t klog_sinks = 0;
+
+/* Compiler barrier, keeps the seq store after the rest */
+#define klog_barrier( )     asm volatile( "" : : : "memory" )
+
+/* -------------------- klog_format_line -------------- */
+/* Formats a record as a "[seconds.hundredths] <level>  */
+/* message" line.                                       */
+/* Inputs:          rec  -> the record                  */
+/*                  line -> KLOG_LINE_LEN bytes         */
+/* Outputs:         Length of the line.                 */
+static int32_t klog_format_line( const klog_record_t* rec, int8_t* line )
+{
+    uint32_t centis = ( rec->ticks % SCHED_HZ ) * 100 / SCHED_HZ;
+
+    return snprintf( line, KLOG_LINE_LEN, "[%u.%s%u] <%u> %s\n",
+                     rec->ticks / SCHED_HZ, ( centis < 10 ) ? "0" : "",
+                     centis, rec->level, rec->msg );
+}
+
+/* ------------------------- klog --------------------- */
+/* Inputs:          level  -> KLOG_* level              */
+/*                  format -> printf style format,      */
+/*                            followed by its arguments */
+/* Outputs:         None.                               */
+/* Side Effects:    Adds a record to the log, possibly  */
+/*                  overwriting the oldest one, and     */
+/*                  copies it to the enabled sinks.     */
+void klog( uint32_t level, int8_t* format, ... )
+{
+    int32_t* args = (void*)&format;
+    uint32_t index = 1;
+    klog_record_t* rec;
+    int8_t   line[ KLOG_LINE_LEN ];
+    int32_t  len;
+
+    args++;
+
+    asm volatile( "lock xaddl %0, %1"
+                  : "+r" ( index ), "+m" ( klog_head )
+                  :
+                  : "memory", "cc" );
+
+    rec = &klog_ring[ index & KLOG_RECORDS_MASK ];
+    rec->seq = 0;
+    klog_barrier( );
+
+    rec->ticks = sched_ticks;
+    rec->level = level;
+    vsnprintf( rec->msg, KLOG_MSG_LEN, format, args );
+
+    klog_barrier( );
+    rec->seq = index + 1;
+
+    if( klog_sinks & KLOG_SINK_SERIAL )
+    {
+        /* Format from the record we just wrote, which a    */
+        /* full lap of other writers could have reused, so  */
+        /* the line may rarely be someone else's message.   */
+        len = klog_format_line( rec, line );
+        serial_write_buf( (uint8_t*)line, len );
+    }
+}
+
+/* -------------------- klog_read_text ---------------- */
+/* Formats records as "[seconds.hundredths] message"    */
+/* lines. If the records at *pos were overwritten, the  */
+/* reader skips ahead to the oldest one still kept.     */
+/* Stops at a record still being written, at the end of */
+/* the log, or when buf is full. A line that does not   */
+/* fit is cut, and *offset remembers how much of it was */
+/* returned so the next read continues it.              */
+/* Inputs:          pos    -> index of the next record  */
+/*                            to read, updated          */
+/*                  offset -> bytes of that record's    */
+/*                            line already read, updated*/
+/*                  buf    -> buffer for the text       */
+/*                  nbytes -> size of buf               */
+/* Outputs:         Number of bytes stored in buf.      */
+/* Side Effects:    None.                               */
+int32_t klog_read_text( uint32_t* pos, uint32_t* offset, uint8_t* buf, int32_t nbytes )
+{
+    klog_record_t rec;
+    int8_t   line[ KLOG_LINE_LEN ];
+    int32_t  count = 0;
+    int32_t  len;
+    int32_t  part;
+    uint32_t head;
+
+    while( count < nbytes )
+    {
+        head = klog_head;
+        if( head - *pos > KLOG_RECORDS )
+        {
+            *pos = head - KLOG_RECORDS;
+            *offset = 0;
+        }
+        if( *pos == head )
+        {
+            break;
+        }
+
+        /* Copy the record, then check it was not reused while */
+        /* we copied it.                                        */
+        rec = klog_ring[ *pos & KLOG_RECORDS_MASK ];
+        klog_barrier( );
+        if( rec.seq != *pos + 1 || klog_ring[ *pos & KLOG_RECORDS_MASK ].seq != *pos + 1 )
+        {
+            if( klog_head - *pos > KLOG_RECORDS )
+            {
+                /* Overwritten, try again from the oldest one. */
+                continue;
+            }
+            /* Still being written. */
+            break;
+        }
+        rec.msg[ KLOG_MSG_LEN - 1 ] = '\0';
+
+        len = klog_format_line( &rec, line );
+        if( *offset > (uint32_t)len )
+        {
+            *offset = len;
+        }
+        part = len - *offset;
+        if( part > nbytes - count )
+        {
+            part = nbytes - count;
+        }
+        memcpy( buf + count, line + *offset, part );
+        count += part;
+        *offset += part;
+        if( *offset == (uint32_t)len )
+        {
+            *offset = 0;
+            ( *pos )++;
+        }
+    }
+
+    return count;
+}
+
+/* ----------------------- klog_open ------------------ */
+/* Inputs:          filename -> unused                  */
+/* Outputs:         0. Reading starts from the oldest   */
+/*                  record, file_position is 0.         */
+int32_t klog_open( const uint8_t* filename )
+{
+    return 0;
+}
+
+/* ----------------------- klog_read ------------------ */
+/* Reads the log as text. The file position is the      */
+/* index of the next record, and the unused inode field */
+/* holds how much of its line was read, so repeated     */
+/* reads continue where the last one stopped and return */
+/* 0 once the whole log has been read.                  */
+/* Inputs:          fd     -> file descriptor           */
+/*                  buf    -> buffer to fill            */
+/*                  nbytes -> size of buf               */
+/* Outputs:         Number of bytes read.               */
+int32_t klog_read( int32_t fd, void* buf, int32_t nbytes )
+{
+    open_file_t* file;
+
+    if( buf == NULL || nbytes <= 0 )
+    {
+        return -1;
+    }
+    file = get_open_file( fd );
+    return klog_read_text( &file->file_position, &file->index_node_num, buf, nbytes );
+}
+
+/* ---------------------- klog_write ------------------ */
+/* The log is read only.                                */
+int32_t klog_write( int32_t fd, const void* buf, int32_t nbytes )
+{
+    return -1;
+}
+
+/* ---------------------- klog_close ------------------ */
+int32_t klog_close( int32_t fd )
+{
+    return 0;
+}
@@ -0,0 +1,67 @@
+#ifndef _KLOG_H
+#define _KLOG_H
+
+#include "types.h"
+
+/* Kernel log. klog() formats a message like printf and */
+/* stores it, with the PIT tick it was logged at and a  */
+/* level, in a ring of fixed-size records instead of    */
+/* printing it. Logging never blocks or disables        */
+/* interrupts, so it can be used from interrupt         */
+/* handlers. When the ring is full the oldest records   */
+/* are overwritten. The log is read back as text        */
+/* through the "dmesg" pseudo-file. Each message can    */
+/* also be copied out as it is logged, to the sinks     */
+/* set in klog_sinks.                                   */
+
+/* Number of records kept. Must be a power of two so    */
+/* the ring indices can be masked.                      */
+#define KLOG_RECORDS        256
+#define KLOG_RECORDS_MASK   ( KLOG_RECORDS - 1 )
+#define KLOG_MSG_LEN        52              /* Message bytes per record, with the '\0'  */
+#define KLOG_LINE_LEN       80              /* Longest line dmesg produces              */
+
+/* Log levels, as in syslog */
+#define KLOG_ERR            3
+#define KLOG_WARN           4
+#define KLOG_INFO           6
+#define KLOG_DEBUG          7
+
+/* Name of the pseudo-file the log is read from */
+#define KLOG_FILE_NAME      "dmesg"
+
+/* Bits of klog_sinks. The serial sink sends each line  */
+/* to COM1 as it is logged; it briefly disables         */
+/* interrupts, and waits for the UART when its transmit */
+/* ring is full.                                        */
+#define KLOG_SINK_SERIAL    0x01
+
+typedef struct klog_record_t {
+    volatile uint32_t seq;                  /* Index + 1 once the record is complete,   */
+                                            /* 0 while it is being written              */
+    uint32_t ticks;                         /* sched_ticks when it was logged           */
+    uint32_t level;                         /* KLOG_* level                             */
+    int8_t   msg[ KLOG_MSG_LEN ];           /* Message, cut off if too long             */
+} klog_record_t;
+
+/* Records logged since boot, including overwritten ones */
+extern volatile uint32_t klog_head;
+
+/* KLOG_SINK_* bits of where new messages are copied to */
+extern uint32_t klog_sinks;
+
+/* Logs a message. Takes the conversions of printf.     */
+extern void klog( uint32_t level, int8_t* format, ... );
+
+/* Formats the records from *pos on into buf as lines   */
+/* of text, advancing *pos, and *offset within a line   */
+/* that was cut. Returns the bytes stored.              */
+extern int32_t klog_read_text( uint32_t* pos, uint32_t* offset, uint8_t* buf, int32_t nbytes );
+
+/* File operations of the dmesg pseudo-file */
+extern int32_t klog_open( const uint8_t* filename );
+extern int32_t klog_read( int32_t fd, void* buf, int32_t nbytes );
+extern int32_t klog_write( int32_t fd, const void* buf, int32_t nbytes );
+extern int32_t klog_close( int32_t fd );
+
+#endif /* _KLOG_H */
@@ -0,0 +1,271 @@
+#include "kmalloc.h"
+#include "frame.h"
+#include "lib.h"
+
+/* Objects start after the slab header, aligned to this */
+#define SLAB_OBJ_ALIGN      16
+#define SLAB_HEADER_SIZE    ( ( sizeof( slab_t ) + SLAB_OBJ_ALIGN - 1 ) & ~( SLAB_OBJ_ALIGN - 1 ) )
+
+/* kmalloc size classes, smallest first */
+static kmem_cache_t kmalloc_caches[ KMALLOC_NUM_CLASSES ] = {
+    KMEM_CACHE_INIT( "kmalloc-16",   16 ),
+    KMEM_CACHE_INIT( "kmalloc-32",   32 ),
+    KMEM_CACHE_INIT( "kmalloc-64",   64 ),
+    KMEM_CACHE_INIT( "kmalloc-128",  128 ),
+    KMEM_CACHE_INIT( "kmalloc-256",  256 ),
+    KMEM_CACHE_INIT( "kmalloc-512",  512 ),
+    KMEM_CACHE_INIT( "kmalloc-1024", 1024 ),
+};
+
+/* Every cache that has been used at least once, for    */
+/* the statistics, plus the large allocation counters.  */
+static kmem_cache_t* cache_list = NULL;
+static uint32_t large_in_use = 0;
+static uint32_t large_frames = 0;
+
+/* ----------------------- slab_new ------------------- */
+/* Takes a frame for a new slab and threads all of its  */
+/* objects onto the slab's free list.                   */
+/* Inputs:          cache -> cache the slab is for      */
+/* Outputs:         The slab, or NULL if out of memory. */
+/* Side Effects:    Links the slab onto the partial     */
+/*                  list of the cache.                  */
+static slab_t* slab_new( kmem_cache_t* cache )
+{
+    slab_t*  slab;
+    uint8_t* obj;
+    uint32_t i;
+
+    slab = (slab_t*)frame_alloc( );
+    if( slab == NULL ) {
+        return NULL;
+    }
+
+    slab->cache = cache;
+    slab->in_use = 0;
+    slab->free_list = NULL;
+
+    /* Push the objects in reverse so they are handed out in */
+    /* address order.                                         */
+    obj = (uint8_t*)slab + SLAB_HEADER_SIZE + ( cache->per_slab - 1 ) * cache->obj_size;
+    for( i = 0; i < cache->per_slab; i++, obj -= cache->obj_size ) {
+        *(void**)obj = slab->free_list;
+        slab->free_list = obj;
+    }
+
+    slab->prev = NULL;
+    slab->next = cache->partial;
+    if( cache->partial != NULL ) {
+        cache->partial->prev = slab;
+    }
+    cache->partial = slab;
+    cache->slabs++;
+
+    return slab;
+}
+
+/* --------------------- slab_unlink ------------------ */
+/* Removes a slab from its cache's partial list.        */
+static void slab_unlink( kmem_cache_t* cache, slab_t* slab )
+{
+    if( slab->prev != NULL ) {
+        slab->prev->next = slab->next;
+    } else {
+        cache->partial = slab->next;
+    }
+    if( slab->next != NULL ) {
+        slab->next->prev = slab->prev;
+    }
+    slab->next = NULL;
+    slab->prev = NULL;
+}
+
+/* ------------------- kmem_cache_alloc --------------- */
+/* Inputs:          cache -> cache to allocate from     */
+/* Outputs:         Pointer to an object, or NULL if no */
+/*                  memory is left.                     */
+/* Side Effects:    May take a new slab from the frame  */
+/*                  allocator.                          */
+void* kmem_cache_alloc( kmem_cache_t* cache )
+{
+    slab_t*  slab;
+    void*    obj;
+    uint32_t flags;
+
+    cli_and_save( flags );
+
+    /* First use of the cache: size the slabs and register it */
+    if( cache->per_slab == 0 ) {
+        if( cache->obj_size < sizeof( void* ) ) {
+            cache->obj_size = sizeof( void* );
+        }
+        cache->per_slab = ( FRAME_SIZE - SLAB_HEADER_SIZE ) / cache->obj_size;
+        cache->next_cache = cache_list;
+        cache_list = cache;
+    }
+
+    slab = cache->partial;
+    if( slab == NULL ) {
+        slab = slab_new( cache );
+        if( slab == NULL ) {
+            cache->failures++;
+            restore_flags( flags );
+            return NULL;
+        }
+    }
+
+    obj = slab->free_list;
+    slab->free_list = *(void**)obj;
+    slab->in_use++;
+
+    /* A full slab leaves the partial list until something is freed */
+    if( slab->free_list == NULL ) {
+        slab_unlink( cache, slab );
+    }
+
+    cache->in_use++;
+    cache->allocs++;
+
+    restore_flags( flags );
+    return obj;
+}
+
+/* ------------------- kmem_cache_free ---------------- */
+/* Inputs:          cache -> cache obj came from        */
+/*                  obj   -> object to free             */
+/* Outputs:         None.                               */
+/* Side Effects:    An empty slab is given back to the  */
+/*                  frame allocator, unless it is the   */
+/*                  only slab left with free objects.   */
+void kmem_cache_free( kmem_cache_t* cache, void* obj )
+{
+    slab_t*  slab;
+    uint32_t flags;
+
+    if( obj == NULL ) {
+        return;
+    }
+
+    slab = (slab_t*)( (uint32_t)obj & ~( FRAME_SIZE - 1 ) );
+
+    cli_and_save( flags );
+
+    /* A full slab has a free object again */
+    if( slab->free_list == NULL ) {
+        slab->prev = NULL;
+        slab->next = cache->partial;
+        if( cache->partial != NULL ) {
+            cache->partial->prev = slab;
+        }
+        cache->partial = slab;
+    }
+
+    *(void**)obj = slab->free_list;
+    slab->free_list = obj;
+    slab->in_use--;
+
+    cache->in_use--;
+    cache->frees++;
+
+    /* Keep one empty slab around so alternating alloc/free */
+    /* does not bounce frames in and out of the cache.      */
+    if( slab->in_use == 0 && ( slab->next != NULL || slab->prev != NULL ) ) {
+        slab_unlink( cache, slab );
+        cache->slabs--;
+        frame_free( (uint32_t)slab );
+    }
+
+    restore_flags( flags );
+}
+
+/* ------------------------ kmalloc ------------------- */
+/* Allocates size bytes from the smallest size class    */
+/* that fits. Larger requests get whole frames with a   */
+/* slab_t header in front whose cache is NULL.          */
+/* Inputs:          size -> bytes needed                */
+/* Outputs:         Pointer to the memory, or NULL.     */
+/* Side Effects:    None.                               */
+void* kmalloc( uint32_t size )
+{
+    uint32_t i;
+    uint32_t frames;
+    uint32_t flags;
+    slab_t*  slab;
+
+    if( size == 0 ) {
+        return NULL;
+    }
+
+    for( i = 0; i < KMALLOC_NUM_CLASSES; i++ ) {
+        if( size <= kmalloc_caches[ i ].obj_size ) {
+            return kmem_cache_alloc( &kmalloc_caches[ i ] );
+        }
+    }
+
+    frames = ( size + SLAB_HEADER_SIZE + FRAME_SIZE - 1 ) / FRAME_SIZE;
+    slab = (slab_t*)frame_alloc_contig( frames, 1 );
+    if( slab == NULL ) {
+        return NULL;
+    }
+    slab->cache = NULL;
+    slab->in_use = frames;
+
+    cli_and_save( flags );
+    large_in_use++;
+    large_frames += frames;
+    restore_flags( flags );
+
+    return (uint8_t*)slab + SLAB_HEADER_SIZE;
+}
+
+/* ------------------------- kfree -------------------- */
+/* Inputs:          ptr -> memory from kmalloc, or NULL */
+/* Outputs:         None.                               */
+/* Side Effects:    Returns the memory to its cache or  */
+/*                  to the frame allocator.             */
+void kfree( void* ptr )
+{
+    slab_t*  slab;
+    uint32_t flags;
+
+    if( ptr == NULL ) {
+        return;
+    }
+
+    /* Slab objects and large allocations both have their   */
+    /* header at the start of the frame they begin in.      */
+    slab = (slab_t*)( (uint32_t)ptr & ~( FRAME_SIZE - 1 ) );
+    if( slab->cache != NULL ) {
+        kmem_cache_free( slab->cache, ptr );
+        return;
+    }
+
+    cli_and_save( flags );
+    large_in_use--;
+    large_frames -= slab->in_use;
+    restore_flags( flags );
+
+    frame_free_contig( (uint32_t)slab, slab->in_use );
+}
+
+/* ------------------ kmalloc_print_stats ------------- */
+/* Prints one line per cache in use: object size, slabs */
+/* held, objects in use out of the slabs' capacity, and */
+/* the allocation counters.                             */
+/* Inputs:          None.                               */
+/* Outputs:         None.                               */
+/* Side Effects:    Prints to the screen.               */
+void kmalloc_print_stats( void )
+{
+    kmem_cache_t* cache;
+
+    printf( "cache         size slabs  used/total  allocs  frees  fail\n" );
+    for( cache = cache_list; cache != NULL; cache = cache->next_cache ) {
+        printf( "%s  %u  %u  %u/%u  %u  %u  %u\n",
+                (int8_t*)cache->name, cache->obj_size, cache->slabs,
+                cache->in_use, cache->slabs * cache->per_slab,
+                cache->allocs, cache->frees, cache->failures );
+    }
+    printf( "large  %u allocations, %u frames\n", large_in_use, large_frames );
+    printf( "frames free: %u/%u\n", frame_free_count( ), frame_total_count( ) );
+}
@@ -0,0 +1,63 @@
+#ifndef _KMALLOC_H
+#define _KMALLOC_H
+
+#include "types.h"
+
+/* Slab allocator for kernel objects. Every cache hands */
+/* out objects of one size, carved out of 4 KB slabs    */
+/* taken from the frame allocator. Each slab starts     */
+/* with a slab_t header and keeps its own free list;    */
+/* the cache keeps the slabs that still have free       */
+/* objects on a list, so allocating and freeing are     */
+/* constant time. kmalloc/kfree sit on top of a set of  */
+/* power-of-two size classes.                           */
+
+#define KMALLOC_MIN_SIZE    16              /* Smallest kmalloc size class                  */
+#define KMALLOC_MAX_SIZE    1024            /* Largest kmalloc size class; bigger requests  */
+                                            /* get whole frames                             */
+#define KMALLOC_NUM_CLASSES 7               /* 16, 32, 64, 128, 256, 512, 1024              */
+
+struct kmem_cache_t;
+
+/* Header at the start of every slab. For allocations   */
+/* larger than KMALLOC_MAX_SIZE cache is NULL and       */
+/* in_use holds the number of frames.                   */
+typedef struct slab_t {
+    struct kmem_cache_t* cache;             /* Cache the slab belongs to                    */
+    struct slab_t*       next;              /* Links on the cache's partial list            */
+    struct slab_t*       prev;
+    void*                free_list;         /* First free object in this slab               */
+    uint32_t             in_use;            /* Objects handed out from this slab            */
+} slab_t;
+
+typedef struct kmem_cache_t {
+    const char*          name;              /* Name shown in the statistics                 */
+    uint32_t             obj_size;          /* Size of one object                           */
+    uint32_t             per_slab;          /* Objects per slab, set up on first use        */
+    slab_t*              partial;           /* Slabs with at least one free object          */
+    struct kmem_cache_t* next_cache;        /* Link in the list of caches in use            */
+    /* Statistics */
+    uint32_t             slabs;             /* Slabs currently allocated                    */
+    uint32_t             in_use;            /* Objects currently allocated                  */
+    uint32_t             allocs;            /* Total successful allocations                 */
+    uint32_t             frees;             /* Total frees                                  */
+    uint32_t             failures;          /* Allocations that found no memory             */
+} kmem_cache_t;
+
+/* Static initializer for a cache, so caches need no    */
+/* init call: slabs are created on the first alloc.     */
+#define KMEM_CACHE_INIT( cache_name, size ) \
+    { (cache_name), (size), 0, NULL, NULL, 0, 0, 0, 0, 0 }
+
+/* Allocates / frees one object of a cache */
+extern void* kmem_cache_alloc( kmem_cache_t* cache );
+extern void kmem_cache_free( kmem_cache_t* cache, void* obj );
+
+/* General purpose allocation. Returns NULL on failure  */
+extern void* kmalloc( uint32_t size );
+extern void kfree( void* ptr );
+
+/* Prints the statistics of every cache in use */
+extern void kmalloc_print_stats( void );
+
+#endif /* _KMALLOC_H */
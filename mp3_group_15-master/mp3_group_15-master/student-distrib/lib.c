@@ -150,6 +150,108 @@ format_char_switch:
     return (buf - format);
 }
 
+/* int32_t vsnprintf(int8_t* buf, uint32_t size, int8_t* format, int32_t* args);
+ *   Inputs: int8_t* buf = buffer to print into
+ *           uint32_t size = size of buf, including the terminating '\0'
+ *           int8_t* format = format string, with the conversions of printf
+ *           int32_t* args = first argument on the caller's stack
+ *   Return Value: Number of characters stored, not counting the '\0'
+ *    Function: printf into a buffer. Output that does not fit is cut off;
+ *    buf is always terminated if size is not 0 */
+int32_t vsnprintf(int8_t* buf, uint32_t size, int8_t* format, int32_t* args) {
+    int8_t conv_buf[36];
+    int8_t* str;
+    uint32_t len = 0;
+    int32_t value;
+
+    if (size == 0) {
+        return 0;
+    }
+
+    while (*format != '\0' && len < size - 1) {
+        if (*format != '%') {
+            buf[len++] = *format++;
+            continue;
+        }
+        format++;
+
+        /* Alternate forms are printed like the plain ones */
+        if (*format == '#') {
+            format++;
+        }
+
+        str = conv_buf;
+        switch (*format) {
+            case 'x':
+                itoa(*((uint32_t *)args), conv_buf, 16);
+                args++;
+                break;
+            case 'u':
+                itoa(*((uint32_t *)args), conv_buf, 10);
+                args++;
+                break;
+            case 'd':
+                value = *args;
+                if (value < 0) {
+                    conv_buf[0] = '-';
+                    itoa(-value, &conv_buf[1], 10);
+                } else {
+                    itoa(value, conv_buf, 10);
+                }
+                args++;
+                break;
+            case 'c':
+                conv_buf[0] = (int8_t) *args;
+                conv_buf[1] = '\0';
+                args++;
+                break;
+            case 's':
+                str = *((int8_t **)args);
+                args++;
+                break;
+            case '%':
+                conv_buf[0] = '%';
+                conv_buf[1] = '\0';
+                break;
+            case '\0':
+                /* Format ends in a lone '%' */
+                format--;
+                conv_buf[0] = '\0';
+                break;
+            default:
+                conv_buf[0] = '\0';
+                break;
+        }
+        format++;
+
+        while (*str != '\0' && len < size - 1) {
+            buf[len++] = *str++;
+        }
+    }
+
+    buf[len] = '\0';
+    return len;
+}
+
+/* int32_t snprintf(int8_t* buf, uint32_t size, int8_t* format, ...);
+ *   Inputs: see vsnprintf, the arguments follow the format
+ *   Return Value: Number of characters stored, not counting the '\0'
+ *    Function: printf into a buffer */
+int32_t snprintf(int8_t* buf, uint32_t size, int8_t* format, ...) {
+    int32_t* esp = (void *)&format;
+    esp++;
+    return vsnprintf(buf, size, format, esp);
+}
+
+/* void set_video_mem(char* video);
+ * Inputs: char* video = start of the screen to print to
+ * Return Value: void
+ *  Function: Point printf at another screen, such as the VGA
+ *  region of a terminal */
+void set_video_mem(char* video) {
+    video_mem = video;
+}
+
 /* int32_t puts(int8_t* s);
  *   Inputs: int_8* s = pointer to a string of characters
  *   Return Value: Number of bytes written
@@ -237,15 +339,53 @@ int8_t* strrev(int8_t* s) {
     return s;
 }
 
+/* The string routines below work a 32-bit word at a time once the
+ * pointer is aligned. An aligned word never crosses a page, so reading
+ * all of the word that holds the terminating '\0' cannot fault.
+ * HAS_ZERO_BYTE is non-zero iff some byte of the word is 0. */
+typedef uint32_t __attribute__((__may_alias__)) word_t;
+#define WORD_ONES           0x01010101
+#define WORD_HIGHS          0x80808080
+#define WORD_MASK           0x3
+#define HAS_ZERO_BYTE(v)    (((v) - WORD_ONES) & ~(v) & WORD_HIGHS)
+
 /* uint32_t strlen(const int8_t* s);
  * Inputs: const int8_t* s = string to take length of
  * Return Value: length of string s
  * Function: return length of string s */
 uint32_t strlen(const int8_t* s) {
-    register uint32_t len = 0;
-    while (s[len] != '\0')
-        len++;
-    return len;
+    const int8_t* p = s;
+    const word_t* w;
+
+    while ((uint32_t)p & WORD_MASK) {
+        if (*p == '\0')
+            return p - s;
+        p++;
+    }
+    for (w = (const word_t*)p; !HAS_ZERO_BYTE(*w); w++);
+    for (p = (const int8_t*)w; *p != '\0'; p++);
+    return p - s;
+}
+
+/* uint32_t strnlen(const int8_t* s, uint32_t maxlen);
+ * Inputs: const int8_t* s = string to take length of
+ *         uint32_t maxlen = most bytes to look at
+ * Return Value: length of string s, or maxlen if there is no '\0'
+ *               in its first maxlen bytes
+ * Function: return length of a string that need not be terminated */
+uint32_t strnlen(const int8_t* s, uint32_t maxlen) {
+    const int8_t* p = s;
+    const int8_t* end = s + maxlen;
+    const word_t* w;
+
+    while (p != end && ((uint32_t)p & WORD_MASK)) {
+        if (*p == '\0')
+            return p - s;
+        p++;
+    }
+    for (w = (const word_t*)p; end - (const int8_t*)w >= 4 && !HAS_ZERO_BYTE(*w); w++);
+    for (p = (const int8_t*)w; p != end && *p != '\0'; p++);
+    return p - s;
 }
 
 /* void* memset(void* s, int32_t c, uint32_t n);
@@ -382,23 +522,51 @@ void* memcpy(void* dest, const void* src, uint32_t n) {
  *         const void* src = source of move
  *              uint32_t n = number of byets to move
  * Return Value: pointer to dest
- * Function: move n bytes of src to dest */
+ * Function: move n bytes of src to dest. Unless dest lies inside src
+ *           the areas can be copied forwards, which memcpy does a
+ *           dword at a time: each dword is read before it is written,
+ *           so a dest below src is never overwritten too early.
+ *           Otherwise copy backwards: bytes until the end of dest is
+ *           aligned, then dwords, then the bytes left at the start. */
 void* memmove(void* dest, const void* src, uint32_t n) {
+    void* d = dest;
+    const void* s = src;
+
+    if ((uint32_t)dest - (uint32_t)src >= n) {
+        return memcpy(dest, src, n);
+    }
     asm volatile ("                             \n\
             movw    %%ds, %%dx                  \n\
             movw    %%dx, %%es                  \n\
-            cld                                 \n\
-            cmp     %%edi, %%esi                \n\
-            jae     .memmove_go                 \n\
+            std                                 \n\
             leal    -1(%%esi, %%ecx), %%esi     \n\
             leal    -1(%%edi, %%ecx), %%edi     \n\
-            std                                 \n\
-            .memmove_go:                        \n\
+            .memmove_head:                      \n\
+            testl   %%ecx, %%ecx                \n\
+            jz      .memmove_done               \n\
+            leal    1(%%edi), %%eax             \n\
+            testl   $0x3, %%eax                 \n\
+            jz      .memmove_aligned            \n\
+            movsb                               \n\
+            subl    $1, %%ecx                   \n\
+            jmp     .memmove_head               \n\
+            .memmove_aligned:                   \n\
+            subl    $3, %%esi                   \n\
+            subl    $3, %%edi                   \n\
+            movl    %%ecx, %%edx                \n\
+            shrl    $2, %%ecx                   \n\
+            andl    $0x3, %%edx                 \n\
+            rep     movsl                       \n\
+            addl    $3, %%esi                   \n\
+            addl    $3, %%edi                   \n\
+            movl    %%edx, %%ecx                \n\
             rep     movsb                       \n\
+            .memmove_done:                      \n\
+            cld                                 \n\
             "
+            : "+D"(d), "+S"(s), "+c"(n)
             :
-            : "D"(dest), "S"(src), "c"(n)
-            : "edx", "memory", "cc"
+            : "eax", "edx", "memory", "cc"
     );
     return dest;
 }
@@ -416,6 +584,25 @@ void* memmove(void* dest, const void* src, uint32_t n) {
  * Function: compares string 1 and string 2 for equality */
 int32_t strncmp(const int8_t* s1, const int8_t* s2, uint32_t n) {
     int32_t i;
+
+    /* When both strings have the same alignment, skip the words that
+     * are equal and hold no '\0', then finish byte by byte. */
+    if ((((uint32_t)s1 ^ (uint32_t)s2) & WORD_MASK) == 0) {
+        while (n != 0 && ((uint32_t)s1 & WORD_MASK)) {
+            if (*s1 != *s2 || *s1 == '\0')
+                return *s1 - *s2;
+            s1++;
+            s2++;
+            n--;
+        }
+        while (n >= 4 && *(const word_t*)s1 == *(const word_t*)s2 &&
+               !HAS_ZERO_BYTE(*(const word_t*)s1)) {
+            s1 += 4;
+            s2 += 4;
+            n -= 4;
+        }
+    }
+
     for (i = 0; i < n; i++) {
         if ((s1[i] != s2[i]) || (s1[i] == '\0') /* || s2[i] == '\0' */) {
 
@@ -437,6 +624,20 @@ int32_t strncmp(const int8_t* s1, const int8_t* s2, uint32_t n) {
  * Function: copy the source string into the destination string */
 int8_t* strcpy(int8_t* dest, const int8_t* src) {
     int32_t i = 0;
+    const word_t* w;
+
+    /* Once src is aligned, copy whole words until the one holding
+     * the '\0'. dest may stay unaligned, which x86 allows. */
+    while (((uint32_t)&src[i] & WORD_MASK) && src[i] != '\0') {
+        dest[i] = src[i];
+        i++;
+    }
+    if (src[i] != '\0') {
+        for (w = (const word_t*)&src[i]; !HAS_ZERO_BYTE(*w); w++) {
+            *(word_t*)&dest[i] = *w;
+            i += 4;
+        }
+    }
     while (src[i] != '\0') {
         dest[i] = src[i];
         i++;
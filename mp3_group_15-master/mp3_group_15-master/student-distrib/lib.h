@@ -16,11 +16,15 @@ extern int screen_y;
 /* in the header file, and were subsequently defined by the     */
 /* team.                                                        */
 int32_t printf(int8_t *format, ...);
+int32_t snprintf(int8_t* buf, uint32_t size, int8_t* format, ...);
+int32_t vsnprintf(int8_t* buf, uint32_t size, int8_t* format, int32_t* args);
 void putc(uint8_t c);
+void set_video_mem(char* video);
 int32_t puts(int8_t *s);
 int8_t *itoa(uint32_t value, int8_t* buf, int32_t radix);
 int8_t *strrev(int8_t* s);
 uint32_t strlen(const int8_t* s);
+uint32_t strnlen(const int8_t* s, uint32_t maxlen);
 void clear(void);
 
 void* memset(void* s, int32_t c, uint32_t n);
@@ -162,4 +166,17 @@ do {                                    \
     );                                  \
 } while (0)
 
+/* Reads the processor's time-stamp counter. Returns the full 64-bit
+ * cycle count; callers measuring short intervals may keep only the
+ * low word and subtract modulo 2^32 */
+static inline uint64_t rdtsc(void) {
+    uint64_t val;
+    asm volatile ("rdtsc"
+            : "=A"(val)
+            :
+            : "memory"
+    );
+    return val;
+}
+
 #endif /* _LIB_H */
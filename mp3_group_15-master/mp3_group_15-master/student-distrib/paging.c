@@ -1,12 +1,13 @@
 #include "lib.h"
 #include "paging.h"
 #include "types.h"
+#include "frame.h"
 
 /* Define as "1" for CP5. Define as "0" for else.               */
 #define CP5 1
 #if CP5
     #define ALT_VID_PAGE_START  0xB8
-    #define NUM_ALT_VID_PAGES   5
+    #define NUM_ALT_VID_PAGES   8
 #endif
 
 
@@ -44,7 +45,7 @@ void page_init( void ) {
         page_directory[i].accessed        = 0;
         page_directory[i].available_1     = 0;
         page_directory[i].page_size       = 1;
-        page_directory[i].global          = 1;
+        page_directory[i].global          = 0;
         page_directory[i].available_3     = 0;
         
         /* Initializes the first entry of the page directory to be present and broken into 4KB pages */
@@ -58,8 +59,17 @@ void page_init( void ) {
         /* the starting address of the kernel (4MB Page)                               */
         else if (i == 1) {
             page_directory[i].present         = 1;
+            page_directory[i].global          = 1;
             page_directory[i].virtual_address = ( (uint32_t) KERNEL_START_ADDR ) >> SHIFT_12_VIRTUAL_ADDR;
         } 
+        /* Identity maps the rest of the memory managed by the frame    */
+        /* allocator (8 MB up to at most 128 MB) as supervisor 4MB      */
+        /* pages, so the kernel can use any frame it allocates.         */
+        else if (i * FOUR_MB < frame_mem_end()) {
+            page_directory[i].present         = 1;
+            page_directory[i].global          = 1;
+            page_directory[i].virtual_address = ( i * FOUR_MB ) >> SHIFT_12_VIRTUAL_ADDR;
+        }
     }
     
     /* Loops through and initializes all pages in the page table, enables both read and write */
@@ -73,7 +83,7 @@ void page_init( void ) {
         page_table[i].accessed             = 0;
         page_table[i].dirty                = 0;
         page_table[i].page_attribute_table = 0;
-        page_table[i].global               = 0;
+        page_table[i].global               = 1;
         page_table[i].available_3          = 0;
         page_table[i].virtual_address      = i;
 
@@ -85,7 +95,8 @@ void page_init( void ) {
 
     #if CP5
         /* CP3.5: Sets the pages for Video Memory. Sets pages for   */
-        /* B8, B9, BA, BB, BC for alternative video memory storage. */
+        /* B8 - BF, the whole VGA text window: the displayed screen */
+        /* and the saved screen of each terminal.                   */
         for( i = ALT_VID_PAGE_START; i < ALT_VID_PAGE_START + NUM_ALT_VID_PAGES; i++ )
         {
             page_table[i].present              = 1;
@@ -96,33 +107,85 @@ void page_init( void ) {
             page_table[i].accessed             = 0;
             page_table[i].dirty                = 0;
             page_table[i].page_attribute_table = 0;
-            page_table[i].global               = 0;
+            page_table[i].global               = 1;
             page_table[i].available_3          = 0;
             page_table[i].virtual_address      = i;
         }
     #endif
 
     
-    loadPageDirectory((unsigned int*) page_directory);
+    load_kernel_page_directory();
     enablePaging();
 }
 
 /* void loadPageDirectory(unsigned int *arg);
  *   Inputs: unsigned int *arg --> A pointer to a given page directory
  *   Return Value: none
- *   Function: Loads a given page directory */
+ *   Function: Loads a given page directory. Does nothing if it is already
+ *             loaded, since reloading CR3 drops every non-global TLB entry */
 void loadPageDirectory(unsigned int *arg) {
+    if ((unsigned int) arg == cr3) {
+        return;
+    }
+    cr3 = (unsigned int) arg;
     asm volatile 
     (
-        "mov 8(%%esp), %%eax    ;"
-        "mov %%eax, %%cr3       ;"
-        : "=r"(cr3)
+        "mov %0, %%cr3          ;"
+        :
         : "r"(cr3)
-        : "%eax"
+        : "memory"
     );
     return;
 }
 
+/* void load_kernel_page_directory( void );
+ *   Inputs: none
+ *   Return Value: none
+ *   Function: Loads the kernel's own page directory, which has no user
+ *             pages. Used while a process' directory is being freed */
+void load_kernel_page_directory( void ) {
+    loadPageDirectory((unsigned int*) page_directory);
+}
+
+/* void page_map_mmio( uint32_t phys_addr );
+ *   Inputs: uint32_t phys_addr --> address of memory mapped device registers
+ *   Return Value: none
+ *   Function: Identity maps the 4MB page holding phys_addr as a global,
+ *             supervisor, cache-disabled page. Must be called before any
+ *             process directory is made, since those copy page_directory */
+void page_map_mmio( uint32_t phys_addr ) {
+    uint32_t i = phys_addr / FOUR_MB;
+
+    page_directory[i].present         = 1;
+    page_directory[i].read_write      = 1;
+    page_directory[i].user_supervisor = 0;
+    page_directory[i].write_through   = 1;
+    page_directory[i].cache_disable   = 1;
+    page_directory[i].page_size       = 1;
+    page_directory[i].global          = 1;
+    page_directory[i].virtual_address = ( i * FOUR_MB ) >> SHIFT_12_VIRTUAL_ADDR;
+    invlpg( i * FOUR_MB );
+}
+
+/* void page_directory_init( page_directory_entry_t* dir, uint32_t user_page );
+ *   Inputs: page_directory_entry_t* dir --> 4KB page for the new directory
+ *           uint32_t user_page --> physical address of the process' 4MB page
+ *   Return Value: none
+ *   Function: Sets up the page directory of a new process. The kernel
+ *             entries are copied from page_directory and are global, so
+ *             they stay in the TLB across CR3 reloads; the user page is
+ *             mapped at 128MB and is not global */
+void page_directory_init( page_directory_entry_t* dir, uint32_t user_page ) {
+    memcpy(dir, page_directory, sizeof(page_directory));
+
+    dir[USER_PAGE].present         = 1;
+    dir[USER_PAGE].read_write      = 1;
+    dir[USER_PAGE].user_supervisor = 1;
+    dir[USER_PAGE].page_size       = 1;
+    dir[USER_PAGE].global          = 0;
+    dir[USER_PAGE].virtual_address = user_page >> SHIFT_12_VIRTUAL_ADDR;
+}
+
 /* void enablePaging( void );
  *   Inputs: none
  *   Return Value: none
@@ -133,6 +196,7 @@ void enablePaging( void ) {
     (
         "mov %%cr4, %%eax           ;"  /* eax <-- cr4, Stores cr4 in eax */
         "or $0x00000010, %%eax      ;"  /* Sets CR4 Bit 4: If bit set --> Enable 4MB Paging */
+        "or $0x00000080, %%eax      ;"  /* Sets CR4 Bit 7: If bit set --> Enable Global Pages */
         "mov %%eax, %%cr4           ;"  /* cr4 <-- eax, Saves eax back into cr4 */                  
         : "=r"(cr4)      
     );
@@ -146,6 +210,11 @@ void enablePaging( void ) {
     return;
 }
 
+/* void flush_tlb( void );
+ *   Inputs: none
+ *   Return Value: none
+ *   Function: Drops every non-global TLB entry. Single page changes should
+ *             use invlpg instead */
 void flush_tlb( void )
 {
     /* Flush the TLB by reloading the Page Directory Base Addr  */
@@ -1,6 +1,8 @@
 #ifndef _PAGING_H
 #define _PAGING_H
 
+#include "types.h"
+
 #define NUM_PAGES               1024
 #define STRUCT_SIZE             4
 #define SHIFT_12_VIRTUAL_ADDR   12
@@ -56,4 +58,19 @@ extern void enablePaging( void );
 /* Clears the tlb by reloading Directory Base Address into register CR3 */
 extern void flush_tlb( void );
 
+/* Loads the kernel page directory (no user pages) */
+extern void load_kernel_page_directory( void );
+
+/* Identity maps the 4MB page holding a device's registers, uncached */
+extern void page_map_mmio( uint32_t phys_addr );
+
+/* Sets up a process page directory: global kernel entries plus its user page */
+extern void page_directory_init( page_directory_entry_t* dir, uint32_t user_page );
+
+/* Drops the TLB entry of a single page */
+static inline void invlpg( uint32_t addr )
+{
+    asm volatile( "invlpg (%0)" : : "r"(addr) : "memory" );
+}
+
 #endif /* PAGING_H */
@@ -7,17 +7,25 @@
 #include "lib.h"
 #include "types.h"
 #include "tests.h"
+#include "scheduling.h"
+#include "syscall.h"
+#include "signal.h"
 
 /* Turn on Macro to test RTC */
 #define TEST_RTC 0
 
+/* Virtual timers of the open RTC file descriptors, and the number   */
+/* of hardware interrupts since boot.                                 */
+static rtc_vtimer_t rtc_vtimers[RTC_NUM_VTIMERS];
+volatile uint32_t rtc_hw_ticks = 0;
+
 /* void rtc_init();
 *  Inputs: None  
 *  Return Value: None
 *  Function: Initializes the RTC and maps to IRQ on PIC
 *   also ensures that periodic interrupts are allowed
+*   at the fastest rate, which the virtual timers divide down
 */
-volatile int rtc_interrupt_occured;
 
 int rtc_init(){
     /* Turning on periodic interrupts (from https://wiki.osdev.org/RTC)                             */    
@@ -26,11 +34,11 @@ int rtc_init(){
     outb((DISABLE_NMI | REGISTER_B), RTC_PORT);             /* Select register B again              */
     outb((prev | PERIODIC_INTERRUPT_ENABLE), CMOS_PORT);    /* Set the PIE bit to 1                 */
 
-    /* Setting the rate of the periodc interrupts to 2 hz                                           */
+    /* Setting the rate of the periodc interrupts to 1024 hz                                        */
     outb((DISABLE_NMI | REGISTER_A), RTC_PORT);             /* Select register A                    */
     prev = inb(CMOS_PORT);                                  /* Get the contents of reg A            */
     prev = prev & FREQ_MASK;                                /* Clear the bottom 4 bits              */
-    prev = prev | HZ_RATE_2;                                /* Set the bottom 4 bits to 0x0F = 2Hz  */ 
+    prev = prev | HZ_RATE_1024;                             /* Set the bottom 4 bits to 0x06=1024Hz */ 
     outb((DISABLE_NMI | REGISTER_A), RTC_PORT);             /* Select register A                    */
     outb(prev, CMOS_PORT);                                  /* Write the bits to the memory         */
     enable_irq(RTC_IRQ_NUM);                                /* Unmask the IRQ input                 */
@@ -41,10 +49,13 @@ int rtc_init(){
 *  Inputs: None  
 *  Return Value: None
 *  Function: Handler for when an interrupt is invoked by the RTC
-*            currently calls the test_interrupt function to make the
-*            screen go crazy
+*            advances every virtual timer and wakes the process
+*            owning each timer that ticked
 */
 void rtc_handler(){
+    int i;
+    rtc_vtimer_t* vt;
+
     /* first 2 lines from https://wiki.osdev.org/RTC                                                                */
     cli();
     outb(REGISTER_C, RTC_PORT);                         /* Select register C                                        */
@@ -55,7 +66,21 @@ void rtc_handler(){
     #endif
     
     send_eoi(RTC_IRQ_NUM);                              /* Send eoi signal                                          */
-    rtc_interrupt_occured = 1;                          /* Set the interrupt flag for the read command              */                                      
+    rtc_hw_ticks++;
+
+    for (i = 0; i < RTC_NUM_VTIMERS; i++){
+        vt = &rtc_vtimers[i];
+        if (!vt->in_use || --vt->count != 0){           /* Not open, or not yet its turn                            */
+            continue;
+        }
+        vt->count = vt->divider;                        /* Start counting down to the next tick                     */
+        vt->ticks++;
+        vt->pending = 1;                                /* Set the interrupt flag for the read command              */
+        sched_wake_pid(vt->pid, WAIT_RTC);              /* Only the owner can be blocked in rtc_read on this fd     */
+        if (signal_has_handler(vt->pid, SIG_ALARM)){    /* An owner with an alarm handler is told without blocking  */
+            signal_raise(vt->pid, SIG_ALARM);
+        }
+    }
     sti();
 }
 
@@ -103,34 +128,88 @@ int rtc_set_freq(uint32_t rate){
     }
 }
 
+/* static int rtc_freq_valid(uint32_t freq);
+*  Inputs: freq: virtual frequency in Hz
+*  Return Value: 1 if it is a power of 2 within [2, 1024], else 0
+*/
+static int rtc_freq_valid(uint32_t freq){
+    return freq >= RTC_MIN_FREQ && freq <= RTC_MAX_FREQ && (freq & (freq - 1)) == 0;
+}
+
+/* static rtc_vtimer_t* rtc_get_vtimer(int32_t fd);
+*  Inputs: fd of the current process
+*  Return Value: its virtual timer, or NULL if all are taken
+*  Function: Finds the virtual timer of the fd, and gives the fd a new
+*            one at 2 Hz the first time it is read or written
+*/
+static rtc_vtimer_t* rtc_get_vtimer(int32_t fd){
+    int i;
+    uint32_t flags;
+    rtc_vtimer_t* vt;
+    rtc_vtimer_t* free_vt = NULL;
+
+    cli_and_save(flags);
+    for (i = 0; i < RTC_NUM_VTIMERS; i++){
+        vt = &rtc_vtimers[i];
+        if (vt->in_use && vt->pid == curr_pid && vt->fd == fd){
+            restore_flags(flags);
+            return vt;
+        }
+        if (!vt->in_use && free_vt == NULL){
+            free_vt = vt;
+        }
+    }
+    if (free_vt != NULL){
+        free_vt->pid = curr_pid;
+        free_vt->fd = fd;
+        free_vt->divider = RTC_MAX_FREQ / RTC_DEFAULT_FREQ;
+        free_vt->count = free_vt->divider;
+        free_vt->ticks = 0;
+        free_vt->pending = 0;
+        free_vt->in_use = 1;
+    }
+    restore_flags(flags);
+    return free_vt;
+}
+
 /* int32_t rtc_open(const uint8_t* filename);
 *  Inputs: the filename that we are opening  
 *  Return Value: always 0
-*  Function: Opens the rtc and initializes the clock to 2Hz
+*  Function: Opens the rtc. The fd gets a virtual timer running at 2Hz
+*            when it is first read or written.
 */
 int32_t rtc_open(const uint8_t* filename){
     if (filename == NULL){                              /* If the file is NULL then just return -1                      */
         return -1;
     }
-    rtc_init();                                         /* Just have to init the RTC, sets rate to 2Hz and enable irq   */
+    rtc_init();                                         /* Make sure the RTC runs and its irq is enabled                */
     return 0;                                           /* Return 0 on success                                          */
 }
 
 /* int32_t rtc_read(int32_t fd, void* buf, int32_t nbytes);
 *  Inputs: fd, buf, and nbytes  
-*  Return Value: always 0
-*  Function: Reads the state of the RTC and returns when an interrupt has occured
+*  Return Value: 0, or -1 if no virtual timer is free or a signal
+*                ended the wait
+*  Function: Returns when the virtual timer of the fd has ticked
 */
 int32_t rtc_read(int32_t fd, void* buf, int32_t nbytes){
-    while (!rtc_interrupt_occured) {}                   /* While loop to wait for next interrupt                        */
-    rtc_interrupt_occured = 0;                          /* Reset the flag back to 0                                     */
+    rtc_vtimer_t* vt = rtc_get_vtimer(fd);
+    if (vt == NULL){
+        return -1;
+    }
+    sched_wait_event(WAIT_RTC, vt->pending || signal_interrupted());  /* Block until a tick of this fd or a signal      */
+    if (!vt->pending){                                  /* A signal is taken on the way out instead                     */
+        return -1;
+    }
+    vt->pending = 0;                                    /* Reset the flag back to 0                                     */
     return 0;                                           /* Should alwauys return zero as specified in documentation     */
 }
 
 /* int32_t rtc_write(int32_t fd, const void* buf, int32_t nbytes);
 *  Inputs: fd, buf, and nbytes  
 *  Return Value: 0 on success, -1 on failure
-*  Function: Set the interrupt rte of the RTC to the number specified by the buffer
+*  Function: Set the rate of the virtual timer of the fd to the number specified
+*            by the buffer. The hardware RTC keeps running at 1024 Hz.
 */
 int32_t rtc_write(int32_t fd, const void* buf, int32_t nbytes){
     /* The buffer will contain the 4 bytes that we will use to set the clock rate */
@@ -142,18 +221,47 @@ int32_t rtc_write(int32_t fd, const void* buf, int32_t nbytes){
     if (nbytes != 4){
         return -1;
     }
-    cli();                                              /* Block interrupts when writing to RTC (from doc)              */
-    rtc_set_freq( *(( uint32_t *)buf) );                /* Pass the uint32_t from the buffer as the arg for the set_freq*/
-    sti();                                              /* Allow interrupts again (from doc)                            */
+    uint32_t freq = *(( uint32_t *)buf);
+    if (!rtc_freq_valid(freq)){
+        return -1;
+    }
+    rtc_vtimer_t* vt = rtc_get_vtimer(fd);
+    if (vt == NULL){
+        return -1;
+    }
+    uint32_t flags;
+    cli_and_save(flags);                                /* The handler must not see a half updated timer                */
+    vt->divider = RTC_MAX_FREQ / freq;
+    vt->count = vt->divider;
+    restore_flags(flags);
     return 0;                                           /* Return 0 on success                                          */
 }
 
 /* int32_t rtc_close(int32_t fd);
 *  Inputs: fd  
 *  Return Value: 0 always
-*  Function: Does not do anything just returns 0
+*  Function: Frees the virtual timer of the fd, if it has one
 */
 int32_t rtc_close(int32_t fd){
-    rtc_set_freq(HZ_RATE_2);                            /* Set the interrupt rate back to 0                             */
+    int i;
+    for (i = 0; i < RTC_NUM_VTIMERS; i++){
+        if (rtc_vtimers[i].in_use && rtc_vtimers[i].pid == curr_pid && rtc_vtimers[i].fd == fd){
+            rtc_vtimers[i].in_use = 0;
+        }
+    }
     return 0;                                           /* Return 0 on success                                          */
 }
+
+/* uint32_t rtc_virtual_ticks(int32_t fd);
+*  Inputs: fd of the current process
+*  Return Value: ticks of its virtual timer, 0 if it has none
+*/
+uint32_t rtc_virtual_ticks(int32_t fd){
+    int i;
+    for (i = 0; i < RTC_NUM_VTIMERS; i++){
+        if (rtc_vtimers[i].in_use && rtc_vtimers[i].pid == curr_pid && rtc_vtimers[i].fd == fd){
+            return rtc_vtimers[i].ticks;
+        }
+    }
+    return 0;
+}
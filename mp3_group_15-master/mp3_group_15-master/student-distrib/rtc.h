@@ -125,6 +125,28 @@
 #define HZ_RATE_1024                    0x06   
 #define POWER_2_MASK                    0x0001  
 
+/* The hardware RTC always runs at its fastest rate. Every open    */
+/* RTC file descriptor gets a virtual timer with its own rate,     */
+/* which counts hardware interrupts down to its own ticks, so      */
+/* programs on different terminals can use different rates.        */
+#define RTC_MAX_FREQ                    1024
+#define RTC_MIN_FREQ                    2
+#define RTC_DEFAULT_FREQ                2
+#define RTC_NUM_VTIMERS                 16
+
+typedef struct rtc_vtimer_t {
+    uint32_t          in_use;           /* 1 while an open fd owns it           */
+    int32_t           pid;              /* Owning process                       */
+    int32_t           fd;               /* File descriptor in that process      */
+    uint32_t          divider;          /* Hardware interrupts per virtual tick */
+    uint32_t          count;            /* Hardware interrupts left until next  */
+    volatile uint32_t ticks;            /* Virtual ticks since the fd opened    */
+    volatile uint32_t pending;          /* A tick happened since the last read  */
+} rtc_vtimer_t;
+
+/* Hardware RTC interrupts since boot */
+extern volatile uint32_t rtc_hw_ticks;
+
 /* Initilize the rtc device, map to PIC, and enable interrupts */
 int rtc_init();
 
@@ -143,7 +165,10 @@ int32_t rtc_read(int32_t fd, void* buf, int32_t nbytes);
 /* Writes a new periodic interrupt value to the rtc from a buffer */
 int32_t rtc_write(int32_t fd, const void* buf, int32_t nbytes);
 
-/* Resets the value of the periodic intterrupt when a file is closed */
+/* Releases the virtual timer of a file descriptor when it is closed */
 int32_t rtc_close(int32_t fd);
 
+/* Returns the virtual ticks counted for an RTC fd of the current process */
+uint32_t rtc_virtual_ticks(int32_t fd);
+
 #endif
@@ -3,9 +3,13 @@
 #include "terminal.h"
 #include "syscall.h"
 #include "paging.h"
+#include "deferred.h"
+#include "apic.h"
 
 int32_t curr_pid;
 uint32_t startUpInitialized = 0;
+uint32_t sched_ticks = 0;
+uint32_t sched_idle_ticks = 0;
 
 /*              General Notes about Scheduling              */
 /* 1) Need to support up to 3 terminals and use             */
@@ -54,9 +58,15 @@ uint32_t startUpInitialized = 0;
 /* Inputs:          None.                               */
 /* Outputs:         None.                               */
 /* Side Effects:    Initializes the PIT to usage in     */
-/*                  scheduling.                         */
+/*                  scheduling. With a local APIC, its  */
+/*                  timer is used instead of the PIT,   */
+/*                  on the same vector and rate.        */
 void PIT_init( void )
 {
+    if( apic_timer_start( SCHED_HZ ) ) {
+        return;
+    }
+
     /* Set the PIT Command Register to Square Wave Mode */
     /* to enable the PIT to generate Square Waves for   */
     /* timings. Command register number located under   */
@@ -67,40 +77,87 @@ void PIT_init( void )
     /* the high and low bytes of the channel.           */
     uint16_t reload = RELOAD_VAL;
     outb( reload & RELOAD_MASK_LOWER, CHANNEL_0 );
-    outb( reload & RELOAD_MASK_UPPER, CHANNEL_0 );
+    outb( ( reload & RELOAD_MASK_UPPER ) >> 8, CHANNEL_0 );
 
     /* Now setup the PIT with PIC to enable interrupts  */
     enable_irq(PIT_IRQ_NUM);
 }
 
 /* Called whenever an interrupt is generated by the PIT */
+/* (or the local APIC timer standing in for it).        */
 /* Will cause the next task in the round robin          */
 /* scheduling to occur                                  */
 /* Inputs:          None.                               */
 /* Outputs:         None.                               */
-/* Side effects:    Switches to next task in the round  */
-/*                  robin schedule                      */
+/* Side effects:    Charges the tick to the running     */
+/*                  process (or idle) and switches to   */
+/*                  next task in the round robin        */
 void pit_handler( void ){
     cli();                          /* Disable interrupts   */
-    scheduler();                    /* Call the scheduler   */
+
+    /* Sample who owns the CPU on this tick. A process  */
+    /* that is blocked here is only idling in its wait  */
+    /* loop, so the tick is charged to idle instead.    */
+    sched_ticks++;
+    if( curr_pid >= 0 && get_pcb( curr_pid )->sched_state == SCHED_RUNNABLE ) {
+        get_pcb( curr_pid )->cpu_ticks++;
+    } else {
+        sched_idle_ticks++;
+    }
+
+    /* Run the kernel timers that are now due.           */
+    timer_advance( sched_ticks );
+
+    /* Deferred work runs with interrupts enabled on     */
+    /* the stack of whichever process it interrupted;    */
+    /* let it finish before switching away.              */
+    if( !deferred_work_running( ) ) {
+        scheduler();                /* Call the scheduler   */
+    }
     send_eoi(PIT_IRQ_NUM);          /* Send EOI to the PIC  */
-    /* RESUME: Check send_eoi stuff */
     sti();                          /* Enable interrupts    */
 }
 
+/* ----------------- sched_next_terminal -------------- */
+/* Picks the terminal to run next in the round robin,   */
+/* Terminal 2 --> 1 --> 0 --> 2, etc. Terminals that    */
+/* still need a shell are always picked, initialized    */
+/* ones only if their process is runnable.              */
+/* Inputs:          None.                               */
+/* Outputs:         Next terminal, or sched_terminal if */
+/*                  no other terminal can run.          */
+/* Side Effects:    None.                               */
+static int32_t sched_next_terminal( void )
+{
+    int32_t i;
+    int32_t term;
+    for( i = 1; i <= NUM_TERMINALS; i++ ) {
+        term = ( sched_terminal + NUM_TERMINALS - i ) % NUM_TERMINALS;
+        if( terminals[term].initialized == 0 ) {
+            return term;
+        }
+        if( terminals[term].pid >= 0 &&
+            get_pcb( terminals[term].pid )->sched_state == SCHED_RUNNABLE ) {
+            return term;
+        }
+    }
+    return sched_terminal;
+}
+
 /* Called by pit_handler whenever an interrupt is       */
-/* generated by the PIT.                                */
+/* generated by the PIT, and by sched_yield when a      */
+/* process blocks. Must be called with interrupts off.  */
 /* Causes the next task in the round robin              */
 /* Inputs:          None.                               */
 /* Outputs:         None.                               */
 /* Side effects:    Causes switch to next task in round */
 /*                  robin schedule                      */
 void scheduler( void ){
-    // cli();
-
     /* Store the ESP and the EBP so that we can return to it later */
     uint32_t saved_esp;
     uint32_t saved_ebp;
+    int32_t  next_terminal;
+    pcb_t*   prev_pcb;
     asm volatile( "movl     %%esp, %[saved_esp];"
                   "movl     %%ebp, %[saved_ebp];"
                   : /* Output operands. C variables that the asm code   */
@@ -120,15 +177,33 @@ void scheduler( void ){
     terminals[sched_terminal].saved_esp = saved_esp;
     terminals[sched_terminal].saved_ebp = saved_ebp;
 
-    /* If the current terminal is not initialized, set up   */
+    /* Stay on the current process if nothing else can run */
+    next_terminal = sched_next_terminal( );
+    if( next_terminal == sched_terminal ) {
+        return;
+    }
+
+    /* Charge the switch to the process giving up the CPU. A    */
+    /* blocked process gave it up voluntarily, while a runnable */
+    /* one was preempted by the PIT.                            */
+    if( curr_pid >= 0 ) {
+        prev_pcb = get_pcb( curr_pid );
+        if( prev_pcb->sched_state == SCHED_BLOCKED ) {
+            prev_pcb->nvcsw++;
+        } else {
+            prev_pcb->nivcsw++;
+        }
+    }
+    sched_terminal = next_terminal;
+
+    /* If the next terminal is not initialized, set up      */
     /* and execute shell                                    */
     if (terminals[sched_terminal].initialized == 0) {
         /* Sets the terminal to be marked as initialized    */
         terminals[sched_terminal].initialized = 1;
 
-        /* Properly switches the memory of the old terminal to be that of   */
-        /* the next scheduled terminal                                      */
-        switch_terminal(sched_terminal);     
+        /* Point the user video page at the new terminal    */
+        set_video_page( sched_terminal );
 
         /* Need to send the end-of-interrupt signal before execute is called */
         send_eoi(PIT_IRQ_NUM);    
@@ -138,45 +213,24 @@ void scheduler( void ){
 
         return;
     }  
-    
-    /* Switch to the next terminal in a round robin loop */
-    /* Terminal 2 --> 1 --> 0 --> 2 , etc.               */
-    sched_terminal -= 1;
-    if (sched_terminal < 0) {
-        sched_terminal = 2;
-    }     
-
-    #if 0
-    /* Return early if the next terminal in the round robin is not initialized */
-    if (terminals[sched_terminal].initialized == 0) {
-        return;
-    }
 
-    if (sched_terminal == display_terminal) {
-        set_video_page_to_reg( );
-    } else {
-        set_non_displayed_video_page( sched_terminal );
-    }
+    set_video_page( sched_terminal );
 
     /* Gets the current process ID and the saved values for ESP and EBP */
-    int32_t next_pid = terminals[sched_terminal].pid;
+    curr_pid = terminals[sched_terminal].pid;
     saved_esp = terminals[sched_terminal].saved_esp;
     saved_ebp = terminals[sched_terminal].saved_ebp;
 
-    if (next_pid > 2) {
-        /* Remaps the corresponding program based off of the program ID to the user page */
-        map_prog_to_page(next_pid);
-    }
-    
+    /* Remaps the corresponding program based off of the program ID to the user page */
+    map_prog_to_page( curr_pid );
   
     /* Updates tss parameters to prepare for context switch */
     tss.ss0 = KERNEL_DS;
-    tss.esp0 = EIGHT_MB - EIGHT_KB * curr_pid - 4;
+    tss.esp0 = get_kernel_stack( curr_pid );
 
-    /* Send end-of-interrupt signal for PIT to the PIC */
-    // send_eoi(PIT_IRQ_NUM);
-
-    /* Context switch to the next program in the scheduling queue */
+    /* Context switch to the next program in the scheduling queue.  */
+    /* The saved ESP/EBP point into this same function on the next  */
+    /* process' kernel stack, so returning below resumes it.        */
     asm volatile( 
                     "movl     %0, %%esp;" /* Move arg one into reg ESP    */
                     "movl     %1, %%ebp;" /* Move arg two into reg EBP    */
@@ -187,47 +241,241 @@ void scheduler( void ){
                       /* Input 1: Saved EBP.      */
                       "r" ( saved_ebp )
                 ); 
-    
-
-    // sti();
-    #endif
     return;
 } 
 
-/* PAGING FUNCTIONS RELEVANT TO SCHEDULER */
-/* ---------------- set_video_page -------------------- */
-/* Sets characteristics and virtual memory address of   */
-/* page to point to the video memory                    */
+/* -------------------- sched_yield ------------------- */
+/* Gives up the CPU. Switches to the next runnable      */
+/* terminal, and if there is none while the current     */
+/* process is blocked, halts until the next interrupt   */
+/* so that the wait loop can re-check its condition.    */
 /* Inputs:          None.                               */
 /* Outputs:         None.                               */
-/* Side Effects:    Sets the virtual adress of the      */
-/*                  vid_page_table to vid_mem           */
-void set_video_page_to_reg( void ) {
-    
-    vid_page_table[0].present = 1;
-    vid_page_table[0].read_write = 1;
-    vid_page_table[0].user_supervisor = 1;
-    vid_page_table[0].virtual_address = VIDEO_START_ADDR / FOUR_KB;
+/* Side Effects:    May context switch.                 */
+void sched_yield( void )
+{
+    uint32_t flags;
+    cli_and_save( flags );
+
+    if( curr_pid >= 0 ) {
+        scheduler( );
+    }
+
+    /* Back on the CPU, or nobody else could run. Idle  */
+    /* until an interrupt if we are still blocked. STI  */
+    /* holds off interrupts for one instruction, so no  */
+    /* wakeup can slip in before the HLT.               */
+    if( curr_pid < 0 || get_pcb( curr_pid )->sched_state == SCHED_BLOCKED ) {
+        asm volatile( "sti; hlt; cli" : : : "memory" );
+    }
+
+    restore_flags( flags );
+}
+
+/* -------------------- sched_block ------------------- */
+/* Marks the current process as blocked on a channel.   */
+/* Used by sched_wait_event with interrupts disabled.   */
+/* Inputs:          channel -> WAIT_* channel           */
+/* Outputs:         None.                               */
+/* Side Effects:    Round robin skips the process until */
+/*                  sched_wake is called on channel.    */
+void sched_block( int32_t channel )
+{
+    pcb_t* pcb;
+    if( curr_pid < 0 ) {
+        return;
+    }
+    pcb = get_pcb( curr_pid );
+    pcb->sched_state = SCHED_BLOCKED;
+    pcb->wait_channel = channel;
+    pcb->wake_tsc = 0;
+}
+
+/* -------------------- sched_wake -------------------- */
+/* Wakes every process blocked on the given channel and */
+/* stamps the time so the wake-to-run latency can be    */
+/* measured when it next runs.                          */
+/* Inputs:          channel -> WAIT_* channel           */
+/* Outputs:         None.                               */
+/* Side Effects:    Makes blocked processes runnable.   */
+void sched_wake( int32_t channel )
+{
+    int32_t  pid;
+
+    for( pid = 0; pid <= MAX_NUM_PROGS; pid++ ) {
+        sched_wake_pid( pid, channel );
+    }
+}
+
+/* ------------------ sched_wake_pid ------------------ */
+/* Wakes a single process if it is blocked on the given */
+/* channel, for drivers that know which process waits.  */
+/* Inputs:          pid     -> process to wake          */
+/*                  channel -> WAIT_* channel           */
+/* Outputs:         None.                               */
+/* Side Effects:    Makes the process runnable.         */
+void sched_wake_pid( int32_t pid, int32_t channel )
+{
+    uint32_t now;
+    pcb_t*   pcb;
+
+    if( pid < 0 || pid > MAX_NUM_PROGS || pid_array[ pid ] != PID_IN_USE ) {
+        return;
+    }
+    pcb = get_pcb( pid );
+    if( pcb->sched_state != SCHED_BLOCKED || pcb->wait_channel != channel ) {
+        return;
+    }
 
-    flush_tlb();
+    now = (uint32_t)rdtsc( );
+    /* Zero means "not woken", never use it as a stamp  */
+    if( now == 0 ) {
+        now = 1;
+    }
+    pcb->sched_state = SCHED_RUNNABLE;
+    pcb->wait_channel = WAIT_NONE;
+    pcb->wake_tsc = now;
 }
 
-/* --------- set_alternative_video_page --------------- */
+/* --------------- sched_account_wakeup --------------- */
+/* Called once a wait condition is met. If the process  */
+/* was woken by an interrupt, the time since sched_wake */
+/* is its wake-to-run latency. The average is a moving  */
+/* average with weight 1/8, to avoid a 64-bit divide.   */
+/* Inputs:          None.                               */
+/* Outputs:         None.                               */
+/* Side Effects:    Updates the current PCB statistics. */
+void sched_account_wakeup( void )
+{
+    pcb_t*   pcb;
+    uint32_t latency;
+
+    if( curr_pid < 0 ) {
+        return;
+    }
+    pcb = get_pcb( curr_pid );
+    pcb->sched_state = SCHED_RUNNABLE;
+    pcb->wait_channel = WAIT_NONE;
+    if( pcb->wake_tsc == 0 ) {
+        return;
+    }
+
+    latency = (uint32_t)rdtsc( ) - pcb->wake_tsc;
+    pcb->wake_tsc = 0;
+    if( pcb->wakeups == 0 ) {
+        pcb->wake_lat_avg = latency;
+    } else {
+        pcb->wake_lat_avg = pcb->wake_lat_avg - ( pcb->wake_lat_avg >> 3 ) + ( latency >> 3 );
+    }
+    if( latency > pcb->wake_lat_max ) {
+        pcb->wake_lat_max = latency;
+    }
+    pcb->wakeups++;
+}
+
+/* ----------------- sched_reset_stats ---------------- */
+/* Gives a freshly executed process a clean scheduler   */
+/* state on the terminal it is being started on.        */
+/* Inputs:          pid -> process being created        */
+/* Outputs:         None.                               */
+/* Side Effects:    Clears the PCB scheduler fields.    */
+void sched_reset_stats( int32_t pid )
+{
+    pcb_t* pcb = get_pcb( pid );
+    pcb->terminal = sched_terminal;
+    pcb->sched_state = SCHED_RUNNABLE;
+    pcb->wait_channel = WAIT_NONE;
+    pcb->wake_tsc = 0;
+    pcb->cpu_ticks = 0;
+    pcb->nvcsw = 0;
+    pcb->nivcsw = 0;
+    pcb->wakeups = 0;
+    pcb->wake_lat_avg = 0;
+    pcb->wake_lat_max = 0;
+}
+
+/* ----------------- syscall_schedstat ---------------- */
+/* Copies the scheduler statistics to a user buffer.    */
+/* The first record is the idle entry (PID -1), then    */
+/* one record per live process. The sum of cpu_ticks    */
+/* over all records is the number of elapsed ticks.     */
+/* Inputs:          buf -> array of sched_stat_t        */
+/*                  nbytes -> size of buf in bytes      */
+/* Outputs:         Number of records written, or -1 if */
+/*                  buf cannot hold a single record.    */
+/* Side Effects:    None.                               */
+int32_t syscall_schedstat( sched_stat_t* buf, int32_t nbytes )
+{
+    int32_t  max_records;
+    int32_t  count;
+    int32_t  pid;
+    int32_t  i;
+    uint32_t flags;
+    pcb_t*   pcb;
+
+    if( buf == NULL || nbytes < (int32_t)sizeof( sched_stat_t ) ) {
+        return FAILURE;
+    }
+    max_records = nbytes / sizeof( sched_stat_t );
+
+    /* Take a consistent snapshot against the PIT handler */
+    cli_and_save( flags );
+
+    memset( &buf[ 0 ], 0, sizeof( sched_stat_t ) );
+    buf[ 0 ].pid = SCHED_IDLE_PID;
+    buf[ 0 ].terminal = -1;
+    buf[ 0 ].cpu_ticks = sched_idle_ticks;
+    strncpy( buf[ 0 ].name, (int8_t*)"idle", SCHED_NAME_LEN );
+    count = 1;
+
+    for( pid = 0; pid <= MAX_NUM_PROGS && count < max_records; pid++ ) {
+        if( pid_array[ pid ] != PID_IN_USE ) {
+            continue;
+        }
+        pcb = get_pcb( pid );
+        buf[ count ].pid = pid;
+        buf[ count ].terminal = pcb->terminal;
+        buf[ count ].state = pcb->sched_state;
+        buf[ count ].cpu_ticks = pcb->cpu_ticks;
+        buf[ count ].nvcsw = pcb->nvcsw;
+        buf[ count ].nivcsw = pcb->nivcsw;
+        buf[ count ].wakeups = pcb->wakeups;
+        buf[ count ].wake_lat_avg = pcb->wake_lat_avg;
+        buf[ count ].wake_lat_max = pcb->wake_lat_max;
+
+        /* The program name is the first word of the command */
+        for( i = 0; i < SCHED_NAME_LEN - 1; i++ ) {
+            if( pcb->saved_command[ i ] == ' ' || pcb->saved_command[ i ] == '\0' ) {
+                break;
+            }
+            buf[ count ].name[ i ] = pcb->saved_command[ i ];
+        }
+        buf[ count ].name[ i ] = '\0';
+        count++;
+    }
+
+    restore_flags( flags );
+    return count;
+}
+
+/* PAGING FUNCTIONS RELEVANT TO SCHEDULER */
+/* ---------------- set_video_page -------------------- */
 /* Sets characteristis and virtual memory address of    */
-/* page to point to the saved video memory coorsponding */
-/* to the passed terminal                               */
-/* Inputs:          Serminal we are writing to.         */
+/* page to point to the VGA region of the passed        */
+/* terminal. The region is the same whether or not the  */
+/* terminal is displayed.                               */
+/* Inputs:          Terminal we are writing to.         */
 /* Outputs:         None.                               */
 /* Side Effects:    Sets the virtual adress of the      */
-/*                  vid_page_table to vid_mem + offset  */
-/*                  to terminal we are updating         */
-void set_non_displayed_video_page( int terminal )
+/*                  vid_page_table to the terminal's    */
+/*                  region                              */
+void set_video_page( int terminal )
 {
 
     vid_page_table[0].present = 1;
     vid_page_table[0].read_write = 1;
     vid_page_table[0].user_supervisor = 1;
-    vid_page_table[0].virtual_address = ((VIDEO_ALT_START + (terminal)) * SCHED_FOUR_MB) / FOUR_KB;
+    vid_page_table[0].virtual_address = ((uint32_t) TERM_REGION( terminal )) / FOUR_KB;
 
-    flush_tlb();
+    invlpg( VIRT_VID_MEM );
 }
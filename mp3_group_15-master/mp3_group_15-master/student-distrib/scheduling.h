@@ -27,9 +27,12 @@
 /* to obtain a slower frequency that is still accurate  */
 /* enough for timekeeping.                              */
 /* Frequency = 1193182 / (Reload Value) Hz              */
-/* Set the Reload Value to get an acceptable frequency, */
-/* rounded up.                                          */
-#define RELOAD_VAL              11931        
+/* Set the Reload Value to get an acceptable frequency. */
+/* The klog, clock and timer code count time in these   */
+/* ticks, so their rates all follow SCHED_HZ.           */
+#define PIT_BASE_HZ             1193182
+#define SCHED_HZ                100
+#define RELOAD_VAL              ( PIT_BASE_HZ / SCHED_HZ )
 #define RELOAD_MASK_LOWER       0x00FF
 #define RELOAD_MASK_UPPER       0xFF00
 
@@ -40,11 +43,67 @@
 
 #define VIDEO_PAGE_NUM   0x8800000 >> 22
 #define VIDEO_TABLE_NUM  0xB8
-#define VIDEO_ALT_START  0xBA
 #define VIDEO_VIRT_ADDR  0xB8
 #define SCHED_FOUR_KB    0x1000
 #define SCHED_FOUR_MB    0x00400000
 
+/* Scheduling states of a process, kept in its PCB. A  */
+/* blocked process is skipped by the round robin until  */
+/* an interrupt handler wakes its wait channel.         */
+#define SCHED_RUNNABLE   0
+#define SCHED_BLOCKED    1
+
+/* Wait channels a process can block on. Each interrupt */
+/* handler that produces input wakes its own channel.   */
+#define WAIT_NONE        0
+#define WAIT_RTC         1
+#define WAIT_KEYBOARD    2
+#define WAIT_SERIAL      3
+#define WAIT_TIMER       4
+
+/* The idle entry reported by syscall_schedstat carries */
+/* this PID, and accounts ticks where nothing could run */
+#define SCHED_IDLE_PID   -1
+#define SCHED_NAME_LEN   32
+
+/* Per-process scheduler statistics as exported to user */
+/* programs (see syscall_schedstat and "top"). Latency  */
+/* values are in TSC cycles.                            */
+typedef struct sched_stat_t {
+    int32_t  pid;                       /* Process ID, -1 for idle          */
+    int32_t  terminal;                  /* Terminal the process runs on     */
+    uint32_t state;                     /* SCHED_RUNNABLE or SCHED_BLOCKED  */
+    uint32_t cpu_ticks;                 /* PIT ticks spent on the CPU       */
+    uint32_t nvcsw;                     /* Voluntary context switches       */
+    uint32_t nivcsw;                    /* Involuntary context switches     */
+    uint32_t wakeups;                   /* Wakeups that led to running      */
+    uint32_t wake_lat_avg;              /* Moving average wake-to-run time  */
+    uint32_t wake_lat_max;              /* Worst wake-to-run time seen      */
+    int8_t   name[ SCHED_NAME_LEN ];    /* Program the process is running   */
+} sched_stat_t;
+
+/* Total PIT ticks since boot, and how many of those    */
+/* found no runnable process                            */
+extern uint32_t sched_ticks;
+extern uint32_t sched_idle_ticks;
+
+/* Blocks the current process on a wait channel until   */
+/* condition holds. The condition is re-checked with    */
+/* interrupts off, so a wakeup between the check and    */
+/* the block cannot be lost. Replaces the busy loops in */
+/* the blocking read paths.                             */
+#define sched_wait_event(channel, condition)    \
+do {                                            \
+    uint32_t _wait_flags;                       \
+    cli_and_save(_wait_flags);                  \
+    while (!(condition)) {                      \
+        sched_block(channel);                   \
+        sched_yield();                          \
+    }                                           \
+    sched_account_wakeup();                     \
+    restore_flags(_wait_flags);                 \
+} while (0)
+
 /* Initializes the PIT (Programmable Interval Timer)    */
 void PIT_init( void );
 
@@ -58,14 +117,36 @@ void pit_handler( void );
 /* for multipell concurrent tasks                       */
 void scheduler( void );
 
-/* Sets characteristics and virtual memory address of   */
-/* page to point to the video memory                    */
-void set_video_page_to_reg( void );
+/* Gives up the CPU to the next runnable terminal, or   */
+/* idles until the next interrupt if none can run       */
+void sched_yield( void );
+
+/* Marks the current process blocked on a wait channel  */
+void sched_block( int32_t channel );
+
+/* Called from interrupt handlers, makes every process  */
+/* blocked on the channel runnable again                */
+void sched_wake( int32_t channel );
+
+/* Wakes one process if it is blocked on the channel    */
+void sched_wake_pid( int32_t pid, int32_t channel );
+
+/* Records the wake-to-run latency of the current       */
+/* process once its wait condition has been met         */
+void sched_account_wakeup( void );
+
+/* Resets the scheduler state and statistics of a new   */
+/* process and ties it to the scheduled terminal        */
+void sched_reset_stats( int32_t pid );
+
+/* System call: copies scheduler statistics of the idle */
+/* entry and every live process into a user buffer      */
+int32_t syscall_schedstat( sched_stat_t* buf, int32_t nbytes );
 
 /* Sets characteristis and virtual memory address of    */
-/* page to point to the saved video memory coorsponding */
-/* to the passed terminal                               */
-void set_non_displayed_video_page( int terminal );
+/* page to point to the VGA region of the passed        */
+/* terminal                                             */
+void set_video_page( int terminal );
 
 
 #endif
@@ -0,0 +1,253 @@
+#include "serial.h"
+#include "lib.h"
+#include "i8259.h"
+#include "scheduling.h"
+#include "signal.h"
+
+/* Transmit ring. Indices run freely and are masked on  */
+/* access. Only touched with interrupts disabled.       */
+static uint8_t  tx_ring[ SERIAL_TX_SIZE ];
+static uint32_t tx_head = 0;
+static uint32_t tx_tail = 0;
+
+/* Receive ring, and the number of '\n' in it */
+static uint8_t  rx_ring[ SERIAL_RX_SIZE ];
+static uint32_t rx_head = 0;
+static uint32_t rx_tail = 0;
+static volatile uint32_t rx_lines = 0;
+
+static int32_t  uart_found = 0;
+
+/* A read returns once a line is in, or the ring is full */
+#define SERIAL_READ_READY( ) \
+    ( rx_lines != 0 || rx_tail - rx_head == SERIAL_RX_SIZE )
+
+/* -------------------- serial_tx_fill ---------------- */
+/* Moves bytes from the transmit ring into the UART's   */
+/* FIFO if the FIFO is empty, and enables the transmit  */
+/* interrupt for as long as bytes are left in the ring. */
+/* Must be called with interrupts disabled.             */
+static void serial_tx_fill( void )
+{
+    int32_t i;
+
+    if( inb( COM1_PORT + UART_LSR ) & UART_LSR_THRE )
+    {
+        for( i = 0; i < UART_FIFO_SIZE && tx_head != tx_tail; i++ )
+        {
+            outb( tx_ring[ tx_head & SERIAL_TX_MASK ], COM1_PORT + UART_DATA );
+            tx_head++;
+        }
+    }
+
+    outb( ( tx_head != tx_tail ) ? ( UART_IER_RX | UART_IER_TX ) : UART_IER_RX, COM1_PORT + UART_IER );
+}
+
+/* ---------------------- serial_init ----------------- */
+/* Programs COM1 for 115200 baud 8N1 with FIFOs, checks */
+/* that a UART answers through the scratch register,    */
+/* and unmasks its IRQ.                                 */
+/* Inputs:          None.                               */
+/* Outputs:         1 if a UART was found, else 0.      */
+/* Side Effects:    Enables the receive interrupt.      */
+int32_t serial_init( void )
+{
+    outb( UART_SCRATCH_TEST, COM1_PORT + UART_SCR );
+    if( inb( COM1_PORT + UART_SCR ) != UART_SCRATCH_TEST )
+    {
+        uart_found = 0;
+        return 0;
+    }
+
+    outb( 0, COM1_PORT + UART_IER );
+    outb( UART_LCR_DLAB, COM1_PORT + UART_LCR );
+    outb( SERIAL_BAUD_DIVISOR & 0xFF, COM1_PORT + UART_DLL );
+    outb( ( SERIAL_BAUD_DIVISOR >> 8 ) & 0xFF, COM1_PORT + UART_DLM );
+    outb( UART_LCR_8N1, COM1_PORT + UART_LCR );
+    outb( UART_FCR_ENABLE, COM1_PORT + UART_FCR );
+    outb( UART_MCR_IRQ, COM1_PORT + UART_MCR );
+    outb( UART_IER_RX, COM1_PORT + UART_IER );
+
+    uart_found = 1;
+    enable_irq( SERIAL_IRQ_NUM );
+    return 1;
+}
+
+/* --------------------- serial_present --------------- */
+int32_t serial_present( void )
+{
+    return uart_found;
+}
+
+/* --------------------- serial_handler --------------- */
+/* Services every pending UART interrupt: moves the     */
+/* received bytes into the receive ring (CR becomes LF, */
+/* bytes are dropped when it is full) and refills the   */
+/* transmit FIFO.                                       */
+/* Inputs:          None.                               */
+/* Outputs:         None.                               */
+/* Side Effects:    Wakes readers when a line arrived.  */
+void serial_handler( void )
+{
+    uint32_t iir;
+    uint8_t  c;
+    int32_t  wake = 0;
+
+    while( !( ( iir = inb( COM1_PORT + UART_IIR ) ) & UART_IIR_NO_INT ) )
+    {
+        switch( iir & UART_IIR_ID_MASK )
+        {
+            case UART_IIR_RX:
+            case UART_IIR_TIMEOUT:
+                while( inb( COM1_PORT + UART_LSR ) & UART_LSR_DATA )
+                {
+                    c = inb( COM1_PORT + UART_DATA );
+                    if( c == '\r' )
+                    {
+                        c = '\n';
+                    }
+                    if( rx_tail - rx_head < SERIAL_RX_SIZE )
+                    {
+                        rx_ring[ rx_tail & SERIAL_RX_MASK ] = c;
+                        rx_tail++;
+                        if( c == '\n' )
+                        {
+                            rx_lines++;
+                        }
+                        wake = 1;
+                    }
+                }
+                break;
+            case UART_IIR_TX:
+                serial_tx_fill( );
+                break;
+            case UART_IIR_LINE:
+                inb( COM1_PORT + UART_LSR );
+                break;
+            default:
+                inb( COM1_PORT + UART_MSR );
+                break;
+        }
+    }
+
+    send_eoi( SERIAL_IRQ_NUM );
+    if( wake )
+    {
+        sched_wake( WAIT_SERIAL );
+    }
+}
+
+/* -------------------- serial_write_buf -------------- */
+/* Inputs:          buf -> bytes to send                */
+/*                  n   -> number of bytes              */
+/* Outputs:         Number of bytes queued, 0 if there  */
+/*                  is no UART.                         */
+/* Side Effects:    If the ring fills up, sends bytes   */
+/*                  from it by polling until there is   */
+/*                  room again.                         */
+int32_t serial_write_buf( const uint8_t* buf, int32_t n )
+{
+    uint32_t flags;
+    int32_t  i;
+
+    if( !uart_found || buf == NULL )
+    {
+        return 0;
+    }
+
+    cli_and_save( flags );
+    for( i = 0; i < n; i++ )
+    {
+        while( tx_tail - tx_head == SERIAL_TX_SIZE )
+        {
+            /* Wait for the FIFO to empty; with interrupts  */
+            /* off the transmit interrupt cannot do it.     */
+            while( !( inb( COM1_PORT + UART_LSR ) & UART_LSR_THRE ) ) {}
+            serial_tx_fill( );
+        }
+        tx_ring[ tx_tail & SERIAL_TX_MASK ] = buf[ i ];
+        tx_tail++;
+    }
+    serial_tx_fill( );
+    restore_flags( flags );
+
+    return n;
+}
+
+/* ----------------------- serial_puts ---------------- */
+void serial_puts( const int8_t* s )
+{
+    serial_write_buf( (const uint8_t*)s, strlen( s ) );
+}
+
+/* ----------------------- serial_open ---------------- */
+/* Outputs:         0, or -1 if there is no UART.       */
+int32_t serial_open( const uint8_t* filename )
+{
+    return uart_found ? 0 : -1;
+}
+
+/* ----------------------- serial_read ---------------- */
+/* Waits for a line from the serial port and returns    */
+/* it, including the '\n', or as much of it as fits.    */
+/* Inputs:          fd     -> unused                    */
+/*                  buf    -> buffer to fill            */
+/*                  nbytes -> size of buf               */
+/* Outputs:         Number of bytes read, -1 on error   */
+/*                  or if a signal ended the wait.      */
+int32_t serial_read( int32_t fd, void* buf, int32_t nbytes )
+{
+    uint8_t* read_buf = buf;
+    int32_t  count = 0;
+    uint32_t flags;
+    uint8_t  c;
+
+    if( buf == NULL || nbytes < 0 || !uart_found )
+    {
+        return -1;
+    }
+
+    sched_wait_event( WAIT_SERIAL, SERIAL_READ_READY( ) || signal_interrupted( ) );
+    if( !SERIAL_READ_READY( ) )
+    {
+        return -1;
+    }
+
+    cli_and_save( flags );
+    while( count < nbytes && rx_head != rx_tail )
+    {
+        c = rx_ring[ rx_head & SERIAL_RX_MASK ];
+        rx_head++;
+        read_buf[ count ] = c;
+        count++;
+        if( c == '\n' )
+        {
+            rx_lines--;
+            break;
+        }
+    }
+    restore_flags( flags );
+
+    return count;
+}
+
+/* ---------------------- serial_write ---------------- */
+/* Queues the bytes for transmission.                   */
+/* Inputs:          fd     -> unused                    */
+/*                  buf    -> bytes to send             */
+/*                  nbytes -> number of bytes           */
+/* Outputs:         nbytes, or -1 on error.             */
+int32_t serial_write( int32_t fd, const void* buf, int32_t nbytes )
+{
+    if( buf == NULL || nbytes < 0 || !uart_found )
+    {
+        return -1;
+    }
+    return serial_write_buf( buf, nbytes );
+}
+
+/* ---------------------- serial_close ---------------- */
+int32_t serial_close( int32_t fd )
+{
+    return 0;
+}
@@ -0,0 +1,85 @@
+#ifndef _SERIAL_H
+#define _SERIAL_H
+
+#include "types.h"
+
+/* Interrupt-driven driver for the 16550 UART on COM1.  */
+/* Output is queued on a transmit ring and fed to the   */
+/* UART's 16-byte FIFO from the transmit interrupt, so  */
+/* writers do not wait for the line. Input is kept in a */
+/* receive ring and read a line at a time, like the     */
+/* terminal. The port is opened as the "serial"         */
+/* pseudo-file, and can be used as a sink for the       */
+/* kernel log (see klog.h). Under QEMU, -serial stdio   */
+/* connects it to the host.                             */
+
+#define SERIAL_IRQ_NUM          4
+#define COM1_PORT               0x3F8
+
+/* UART registers, as offsets from the base port */
+#define UART_DATA               0       /* Receive / transmit holding register      */
+#define UART_IER                1       /* Interrupt enable                         */
+#define UART_IIR                2       /* Interrupt identification (read)          */
+#define UART_FCR                2       /* FIFO control (write)                     */
+#define UART_LCR                3       /* Line control                             */
+#define UART_MCR                4       /* Modem control                            */
+#define UART_LSR                5       /* Line status                              */
+#define UART_MSR                6       /* Modem status                             */
+#define UART_SCR                7       /* Scratch                                  */
+#define UART_DLL                0       /* Divisor latch, while LCR.DLAB is set     */
+#define UART_DLM                1
+
+#define UART_IER_RX             0x01    /* Received data available                  */
+#define UART_IER_TX             0x02    /* Transmit holding register empty          */
+#define UART_IIR_NO_INT         0x01    /* No interrupt pending                     */
+#define UART_IIR_ID_MASK        0x0E
+#define UART_IIR_MODEM          0x00
+#define UART_IIR_TX             0x02
+#define UART_IIR_RX             0x04
+#define UART_IIR_LINE           0x06
+#define UART_IIR_TIMEOUT        0x0C    /* Data left in the receive FIFO            */
+#define UART_FCR_ENABLE         0xC7    /* Enable and clear FIFOs, 14 byte trigger  */
+#define UART_LCR_8N1            0x03    /* 8 data bits, no parity, 1 stop bit       */
+#define UART_LCR_DLAB           0x80
+#define UART_MCR_IRQ            0x0B    /* DTR, RTS, and OUT2 to route the IRQ      */
+#define UART_LSR_DATA           0x01    /* Receive data ready                       */
+#define UART_LSR_THRE           0x20    /* Transmit holding register empty          */
+#define UART_FIFO_SIZE          16
+#define UART_SCRATCH_TEST       0x5A    /* Written to SCR to see if a UART exists   */
+
+/* 115200 baud (115200 / divisor) */
+#define SERIAL_BAUD_DIVISOR     1
+
+/* Ring sizes, must be powers of two */
+#define SERIAL_TX_SIZE          4096
+#define SERIAL_TX_MASK          ( SERIAL_TX_SIZE - 1 )
+#define SERIAL_RX_SIZE          256
+#define SERIAL_RX_MASK          ( SERIAL_RX_SIZE - 1 )
+
+/* Name of the pseudo-file for the port */
+#define SERIAL_FILE_NAME        "serial"
+
+/* Sets up COM1. Returns 1 if a UART was found, else 0 */
+extern int32_t serial_init( void );
+
+/* Non-zero once serial_init found a UART */
+extern int32_t serial_present( void );
+
+/* Handles the COM1 interrupt */
+extern void serial_handler( void );
+
+/* Queues bytes for transmission, for kernel use. When  */
+/* the ring is full it waits for room, so nothing is    */
+/* lost. Returns the number of bytes queued.            */
+extern int32_t serial_write_buf( const uint8_t* buf, int32_t n );
+
+/* Queues a string for transmission */
+extern void serial_puts( const int8_t* s );
+
+/* File operations of the serial pseudo-file */
+extern int32_t serial_open( const uint8_t* filename );
+extern int32_t serial_read( int32_t fd, void* buf, int32_t nbytes );
+extern int32_t serial_write( int32_t fd, const void* buf, int32_t nbytes );
+extern int32_t serial_close( int32_t fd );
+
+#endif /* _SERIAL_H */
@@ -0,0 +1,252 @@
+#include "signal.h"
+#include "syscall.h"
+#include "exceptions.h"
+#include "scheduling.h"
+#include "klog.h"
+
+/* movl $10, %eax; int $0x80; nop */
+static const uint8_t sigreturn_code[ SIGRETURN_CODE_SIZE ] = {
+    0xB8, 0x0A, 0x00, 0x00, 0x00, 0xCD, 0x80, 0x90
+};
+
+/* Returns 1 if [addr, addr + size) lies in the user page */
+static inline int32_t user_range_ok( uint32_t addr, uint32_t size )
+{
+    return addr >= USER_START_ADDR && addr + size >= addr &&
+           addr + size <= USER_START_ADDR + FOUR_MB;
+}
+
+/* ------------------ signal_process_init ------------- */
+/* Inputs:          pid -> the new process              */
+/* Outputs:         None.                               */
+/* Side Effects:    Every signal takes its default.     */
+void signal_process_init( int32_t pid )
+{
+    pcb_t* pcb = get_pcb( pid );
+
+    memset( pcb->signal_handlers, 0, sizeof( pcb->signal_handlers ) );
+    pcb->signal_mask = 0;
+}
+
+/* --------------------- signal_raise ----------------- */
+/* A blocked process is woken on its own channel; only  */
+/* waits that check for signals (terminal_read and      */
+/* sleep) end early, the rest go back to sleep.         */
+/* Inputs:          pid    -> process to signal         */
+/*                  signum -> SIG_*                     */
+/* Outputs:         None.                               */
+/* Side Effects:    Sets the pending bit.               */
+void signal_raise( int32_t pid, int32_t signum )
+{
+    pcb_t*   pcb;
+    uint32_t flags;
+
+    if( pid < 0 || pid > MAX_NUM_PROGS || pid_array[ pid ] != PID_IN_USE ||
+        signum < 0 || signum >= NUM_SIGNALS )
+    {
+        return;
+    }
+    pcb = get_pcb( pid );
+
+    cli_and_save( flags );
+    pcb->pending_signals |= SIGNAL_BIT( signum );
+    sched_wake_pid( pid, pcb->wait_channel );
+    restore_flags( flags );
+}
+
+/* ------------------- signal_interrupted ------------- */
+/* For blocking reads that a signal should end: an      */
+/* unmasked SIG_INTERRUPT, which kills by default, or   */
+/* any unmasked signal with a handler to run. Others    */
+/* are ignored by default and leave the read waiting.   */
+/* Inputs:          None.                               */
+/* Outputs:         1 if the current process has such   */
+/*                  a signal pending, else 0            */
+/* Side Effects:    None.                               */
+int32_t signal_interrupted( void )
+{
+    pcb_t*   pcb;
+    uint32_t ends = SIGNAL_BIT( SIG_INTERRUPT );
+    int32_t  signum;
+
+    if( curr_pid < 0 )
+    {
+        return 0;
+    }
+    pcb = get_pcb( curr_pid );
+    for( signum = 0; signum < NUM_SIGNALS; signum++ )
+    {
+        if( pcb->signal_handlers[ signum ] != NULL )
+        {
+            ends |= SIGNAL_BIT( signum );
+        }
+    }
+    return ( pcb->pending_signals & ~pcb->signal_mask & ends ) != 0;
+}
+
+/* ------------------ signal_has_handler -------------- */
+/* Inputs:          pid    -> process to look at        */
+/*                  signum -> SIG_*                     */
+/* Outputs:         1 if it installed a handler, else 0 */
+/* Side Effects:    None.                               */
+int32_t signal_has_handler( int32_t pid, int32_t signum )
+{
+    if( pid < 0 || pid > MAX_NUM_PROGS || pid_array[ pid ] != PID_IN_USE ||
+        signum < 0 || signum >= NUM_SIGNALS )
+    {
+        return 0;
+    }
+    return get_pcb( pid )->signal_handlers[ signum ] != NULL;
+}
+
+/* --------------------- signal_check ----------------- */
+/* Delivers the lowest numbered pending signal that is  */
+/* not masked. The user stack gets, from the top down:  */
+/* the sigreturn stub, a copy of the saved context, the */
+/* signal number, and a return address pointing at the  */
+/* stub, so the handler sees a normal cdecl call.       */
+/* Inputs:          regs -> context the linkage saved   */
+/* Outputs:         None.                               */
+/* Side Effects:    May redirect the return to user     */
+/*                  mode, or halt the program.          */
+void signal_check( hw_context_t* regs )
+{
+    pcb_t*   pcb;
+    uint32_t ready;
+    uint32_t esp;
+    uint32_t code;
+    int32_t  signum;
+    void*    handler;
+
+    /* Signals only go to user mode */
+    if( ( regs->cs & 3 ) != 3 || curr_pid < 0 )
+    {
+        return;
+    }
+    pcb = get_pcb( curr_pid );
+    ready = pcb->pending_signals & ~pcb->signal_mask;
+    if( ready == 0 )
+    {
+        return;
+    }
+    for( signum = 0; !( ready & SIGNAL_BIT( signum ) ); signum++ ) {}
+    pcb->pending_signals &= ~SIGNAL_BIT( signum );
+
+    handler = pcb->signal_handlers[ signum ];
+    if( handler == NULL )
+    {
+        if( signum == SIG_DIV_ZERO || signum == SIG_SEGFAULT || signum == SIG_INTERRUPT )
+        {
+            klog( KLOG_INFO, "signal: %d killed pid %d", signum, curr_pid );
+            syscall_halt( HALT_ERROR );
+        }
+        return;
+    }
+
+    /* Build the frame, 4 byte aligned */
+    esp = ( regs->esp - SIGRETURN_CODE_SIZE ) & ~3;
+    code = esp;
+    esp -= sizeof( hw_context_t ) + 2 * sizeof( uint32_t );
+    if( !user_range_ok( esp, regs->esp - esp ) )
+    {
+        klog( KLOG_WARN, "signal: bad user stack 0x%x in pid %d", regs->esp, curr_pid );
+        syscall_halt( HALT_ERROR );
+    }
+    memcpy( (void*)code, sigreturn_code, SIGRETURN_CODE_SIZE );
+    memcpy( (void*)( esp + 2 * sizeof( uint32_t ) ), regs, sizeof( hw_context_t ) );
+    ( (uint32_t*)esp )[ 1 ] = signum;
+    ( (uint32_t*)esp )[ 0 ] = code;
+
+    pcb->signal_mask = ( 1 << NUM_SIGNALS ) - 1;
+    regs->esp = esp;
+    regs->eip = (uint32_t)handler;
+}
+
+/* ------------------ exception_dispatch -------------- */
+/* A fault in a user program that installed a handler   */
+/* for it becomes a signal: DIV_ZERO for #DE, SEGFAULT  */
+/* for the rest. Every other exception is reported and  */
+/* the program halted, as before.                       */
+/* Inputs:          regs -> context the linkage saved   */
+/* Outputs:         None.                               */
+/* Side Effects:    Signals or halts the program.       */
+void exception_dispatch( hw_context_t* regs )
+{
+    int32_t signum;
+
+    signum = ( regs->irq_exc_num == EXCEPTION_VECTOR_DE ) ? SIG_DIV_ZERO : SIG_SEGFAULT;
+    if( ( regs->cs & 3 ) == 3 && signal_has_handler( curr_pid, signum ) &&
+        !( get_pcb( curr_pid )->signal_mask & SIGNAL_BIT( signum ) ) )
+    {
+        signal_raise( curr_pid, signum );
+        signal_check( regs );
+        return;
+    }
+    exception_handler_general( regs->irq_exc_num );
+}
+
+/* ------------------ syscall_set_handler ------------- */
+/* Inputs:          signum          -> SIG_*            */
+/*                  handler_address -> user function,   */
+/*                                     NULL for the     */
+/*                                     default action   */
+/* Outputs:         0 on success, -1 for a bad signal   */
+/*                  or a handler outside the program    */
+/* Side Effects:    Replaces the handler.               */
+int32_t syscall_set_handler( int32_t signum, void* handler_address )
+{
+    if( curr_pid < 0 || signum < 0 || signum >= NUM_SIGNALS )
+    {
+        return FAILURE;
+    }
+    if( handler_address != NULL && !user_range_ok( (uint32_t)handler_address, 1 ) )
+    {
+        return FAILURE;
+    }
+    get_pcb( curr_pid )->signal_handlers[ signum ] = handler_address;
+    return 0;
+}
+
+/* ------------------- syscall_sigreturn -------------- */
+/* Called by the stub once a handler returns. The user  */
+/* stack then holds the signal number with the saved    */
+/* context above it, which replaces the context of this */
+/* system call. Segments come from the kernel's own     */
+/* frame and only the arithmetic flags are taken, so a  */
+/* handler cannot raise its privileges.                 */
+/* Inputs:          None.                               */
+/* Outputs:         EAX of the restored context, so the */
+/*                  linkage writes it back unchanged    */
+/* Side Effects:    Unmasks signals.                    */
+int32_t syscall_sigreturn( void )
+{
+    hw_context_t* regs;
+    hw_context_t* saved;
+    hw_context_t  ctx;
+
+    if( curr_pid < 0 )
+    {
+        return FAILURE;
+    }
+    regs = (hw_context_t*)( get_kernel_stack( curr_pid ) - sizeof( hw_context_t ) );
+    saved = (hw_context_t*)( regs->esp + sizeof( uint32_t ) );
+    if( !user_range_ok( (uint32_t)saved, sizeof( hw_context_t ) ) )
+    {
+        return FAILURE;
+    }
+    memcpy( &ctx, saved, sizeof( hw_context_t ) );
+
+    regs->ebx = ctx.ebx;
+    regs->ecx = ctx.ecx;
+    regs->edx = ctx.edx;
+    regs->esi = ctx.esi;
+    regs->edi = ctx.edi;
+    regs->ebp = ctx.ebp;
+    regs->eax = ctx.eax;
+    regs->eip = ctx.eip;
+    regs->esp = ctx.esp;
+    regs->eflags = ( regs->eflags & ~SIGRETURN_EFLAGS ) | ( ctx.eflags & SIGRETURN_EFLAGS ) | IF_ENABLE;
+
+    get_pcb( curr_pid )->signal_mask = 0;
+    return regs->eax;
+}
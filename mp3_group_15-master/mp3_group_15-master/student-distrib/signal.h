@@ -0,0 +1,111 @@
+#ifndef _SIGNAL_H
+#define _SIGNAL_H
+
+/* Signal delivery. Every entry from user mode (system  */
+/* call, interrupt or exception) saves the registers as */
+/* a hw_context_t at the top of the kernel stack. On    */
+/* the way back, signal_check looks for a pending       */
+/* signal: with a handler installed it copies the       */
+/* context onto the user stack below a small sigreturn  */
+/* stub and redirects the iret to the handler, so the   */
+/* handler's return runs the stub and sigreturn puts    */
+/* the context back. Signals without a handler take     */
+/* their default action: DIV_ZERO, SEGFAULT and         */
+/* INTERRUPT kill the program, ALARM and USER1 are      */
+/* dropped. All signals are masked while a handler      */
+/* runs.                                                */
+
+/* Byte offsets into hw_context_t, for the linkage      */
+#define HW_CONTEXT_EAX      24
+#define HW_CONTEXT_SIZE     68
+
+/* Pushes the registers of a hw_context_t below the     */
+/* vector number and error code (or dummy) already on   */
+/* the stack.                                           */
+#define SAVE_CONTEXT    \
+    pushl %fs          ;\
+    pushl %es          ;\
+    pushl %ds          ;\
+    pushl %eax         ;\
+    pushl %ebp         ;\
+    pushl %edi         ;\
+    pushl %esi         ;\
+    pushl %edx         ;\
+    pushl %ecx         ;\
+    pushl %ebx
+
+/* Pops them again and drops the vector number and      */
+/* error code, leaving the iret frame on top.           */
+#define RESTORE_CONTEXT \
+    popl %ebx          ;\
+    popl %ecx          ;\
+    popl %edx          ;\
+    popl %esi          ;\
+    popl %edi          ;\
+    popl %ebp          ;\
+    popl %eax          ;\
+    popl %ds           ;\
+    popl %es           ;\
+    popl %fs           ;\
+    addl $8, %esp
+
+#ifndef ASM
+
+#include "types.h"
+
+/* Registers saved on entry to the kernel, in the order */
+/* the ECE391 signal handlers expect to find them.      */
+typedef struct hw_context_t {
+    uint32_t ebx;
+    uint32_t ecx;
+    uint32_t edx;
+    uint32_t esi;
+    uint32_t edi;
+    uint32_t ebp;
+    uint32_t eax;
+    uint32_t ds;
+    uint32_t es;
+    uint32_t fs;
+    uint32_t irq_exc_num;                   /* Exception vector, IRQ line, or 0x80      */
+    uint32_t error_code;                    /* CPU error code, 0 if there is none       */
+    uint32_t eip;                           /* Pushed by the CPU from here on           */
+    uint32_t cs;
+    uint32_t eflags;
+    uint32_t esp;                           /* Only when entered from user mode         */
+    uint32_t ss;
+} hw_context_t;
+
+/* Stub copied onto the user stack for a handler to     */
+/* return into: movl $10, %eax; int $0x80               */
+#define SIGRETURN_CODE_SIZE 8
+
+/* Flags a restored context may change: CF PF AF ZF SF  */
+/* DF OF. Everything else stays as the kernel had it.   */
+#define SIGRETURN_EFLAGS    0x00000CD5
+
+#define SIGNAL_BIT( signum ) ( 1 << ( signum ) )
+
+/* Clears the handlers and mask of a new process */
+extern void signal_process_init( int32_t pid );
+
+/* Marks a signal pending for a process and wakes it    */
+/* if it is blocked. Safe from interrupt handlers.      */
+extern void signal_raise( int32_t pid, int32_t signum );
+
+/* Returns 1 if the current process has an unmasked     */
+/* signal pending that should end a blocking read       */
+extern int32_t signal_interrupted( void );
+
+/* Returns 1 if the process has a handler for signum */
+extern int32_t signal_has_handler( int32_t pid, int32_t signum );
+
+/* Called by the linkage with interrupts off, just      */
+/* before returning to user mode.                       */
+extern void signal_check( hw_context_t* regs );
+
+/* Called by the exception linkage */
+extern void exception_dispatch( hw_context_t* regs );
+
+#endif /* ASM */
+
+#endif /* _SIGNAL_H */
@@ -1,4 +1,11 @@
 #include "syscall.h"
+#include "scheduling.h"
+#include "kmalloc.h"
+#include "klog.h"
+#include "serial.h"
+#include "rtc.h"
+#include "irqstat.h"
+#include "signal.h"
 
 /* Define a function pointer type so that our code is   */
 /* easier to read! Defines a pointer to a function with */
@@ -13,6 +20,29 @@ int32_t curr_pid = -1;
 int32_t active_pid;
 int32_t prev_pid;
 int32_t pid_array[MAX_NUM_FILES - 2] = { 0, 0, 0, 0, 0, 0};
+pcb_t* pcb_table[MAX_NUM_FILES - 2] = { NULL, NULL, NULL, NULL, NULL, NULL };
+
+/* PCBs are allocated from their own slab cache */
+static kmem_cache_t pcb_cache = KMEM_CACHE_INIT( "pcb", sizeof( pcb_t ) );
+
+static int32_t alloc_process_memory( int32_t pid );
+static void free_process_memory( int32_t pid );
+static void halt_finish( void );
+
+/* Halt frees the process's kernel stack while it is    */
+/* still running on it, so it finishes on this stack    */
+/* instead. Interrupts stay off from the switch until   */
+/* the jump to the parent (or the iret into a new       */
+/* shell), so one stack is enough.                      */
+static uint8_t halt_stack[ EIGHT_KB ] __attribute__((aligned(16)));
+
+/* What halt_finish needs, saved before the switch      */
+static struct {
+    int32_t  pid;
+    uint32_t parent_esp;
+    uint32_t parent_ebp;
+    int32_t  close_status;
+} halting;
 
 
 #define SYSCALL_HEADER      \
@@ -36,12 +66,6 @@ int32_t pid_array[MAX_NUM_FILES - 2] = { 0, 0, 0, 0, 0, 0};
 /* Side Effects: halts the task specified               */
 int32_t syscall_halt( uint8_t status )
 {
-    /* Parent EBP and ESP will be stored later in the   */
-    /* function, stored within the PCB of the           */
-    /* corresponding PID.                               */
-    uint32_t parent_ebp;
-    uint32_t parent_esp;
-
     /* Store the status of the halt. If the halt status */
     /* is 37, then the call indicates that an error     */
     /* occurred, and that we should return 256 to       */
@@ -57,45 +81,74 @@ int32_t syscall_halt( uint8_t status )
     /* to identify the corresponding PCB.               */
     pcb_t* program_pcb = get_pcb( curr_pid );
 
-    /* Regardless, set the PID in the PID Array to be   */
-    /* free, since the Process will be quashed either   */
-    /* way.                                             */
-    pid_array[ curr_pid ] = PID_FREE;
+    /* Its sleep and alarm timers must not run once the */
+    /* PCB is freed.                                    */
+    timer_process_exit( curr_pid );
 
     /* Iterate through the file array of the process    */
     /* and set all the files to closed (flags = 0 )     */
     close_all_files( );
 
+    /* Leave the terminal in canonical mode for the parent.         */
+    terminals[ sched_terminal ].mode = TERM_MODE_CANON;
+
+    /* From here on the scheduler must not run: the PID, the PCB    */
+    /* and the stack we are on all change hands below.              */
+    cli( );
+
     /* Also, set the PID being serviced to the PID of   */
     /* the previous process, since we aim to halt this  */
     /* process and want to return to the previous one.  */
     prev_pid = curr_pid;
-    curr_pid = program_pcb->parent_id;  
-    
-    /* Parent process is NOT "shell", reset the PCB's   */
-    /* fields and get the needed parent information to  */
-    /* return to the parent process. Update the current */
-    /* PID to be the parent's PID, get the EBP and ESP  */
-    /* information, set the PCB's PID and Parent PID to */
-    /* -1, and mark the PCB's process as inactive.      */
-    parent_ebp = program_pcb->saved_ebp;
-    parent_esp = program_pcb->saved_esp;
-    program_pcb->saved_ebp = 0;
-    program_pcb->saved_esp = 0;
-    program_pcb->parent_id = -1;
-    program_pcb->pid = -1;
-    program_pcb->active = 0;
+    curr_pid = program_pcb->parent_id;
+
+    /* Keep what is needed to return to the parent, as  */
+    /* the PCB is about to be freed.                    */
+    halting.pid = prev_pid;
+    halting.parent_ebp = program_pcb->saved_ebp;
+    halting.parent_esp = program_pcb->saved_esp;
+    halting.close_status = close_status;
+
+    /* Move onto the kernel directory and the halt      */
+    /* stack, then free the process there.              */
+    load_kernel_page_directory( );
+    asm volatile(   "movl     %0, %%esp;"
+                    "call     *%1;"
+                    :
+                    : "r" ( halt_stack + EIGHT_KB ), "r" ( halt_finish )
+                    : "memory"
+                );
+
+    return 0;
+}
+
+/* --------------------- halt_finish ------------------ */
+/* The rest of halt, run on halt_stack with interrupts  */
+/* off. Gives the PCB, kernel stack, user page and page */
+/* directory back before the PID, so an execute on      */
+/* another terminal cannot take the PID while its old   */
+/* memory is still in use. Then returns to the parent,  */
+/* or starts a new shell if there is none.              */
+/* Inputs:          None, see halting.                  */
+/* Outputs:         Does not return.                    */
+/* Side Effects:    Frees the halted process.           */
+static void halt_finish( void )
+{
+    free_process_memory( halting.pid );
+    pid_array[ halting.pid ] = PID_FREE;
 
     /* Reset printf coordinates to be consistent w terminal's. Since    */
     /* we may be returning from a halt we want to print onto the next   */
     /* line as a means of making the terminal look cleaner. Update      */
     /* screen_x/y and determine if we want to add a newline.            */
-    if( terminal_x[ display_terminal ] != 0 )
+    if( terminal_x[ sched_terminal ] != 0 )
     {
-        keyboard_putc( '\n' );
-        reset_keyboard_buffer( );
+        terminal_putc( sched_terminal, '\n' );
     }
 
+    /* The parent is now the process running on this terminal.          */
+    terminals[ sched_terminal ].pid = curr_pid;
+
     /* If the previous PID was -1, then run the program */
     /* "shell", since we always want to have at least   */
     /* one program running at all times.                */
@@ -121,8 +174,8 @@ int32_t syscall_halt( uint8_t status )
     /* details on the TSS.                                              */
     /* Update the TSS to load in the parent task.                       */
     tss.ss0 = KERNEL_DS;
-    /* 8 MB - 8KB * curr_pid, -4 for safety.                            */
-    tss.esp0 = EIGHT_MB - EIGHT_KB * curr_pid;
+    /* Top of the parent's kernel stack.                                */
+    tss.esp0 = get_kernel_stack( curr_pid );
 
     /* Jump to the parent process, resetting the stack  */
     /* and base pointer registers as well as calling    */
@@ -133,10 +186,8 @@ int32_t syscall_halt( uint8_t status )
                     "leave;"
                     "ret;"
                     : 
-                    : "r" ( parent_esp ), "r" ( parent_ebp ), "r" ( close_status )
+                    : "r" ( halting.parent_esp ), "r" ( halting.parent_ebp ), "r" ( halting.close_status )
                 ); 
-
-    return 0;
 }
 
 /*-------------------syscall_execute--------------------*/
@@ -177,14 +228,14 @@ int32_t syscall_execute( const uint8_t* command )
 {
 
     int i;
+    uint32_t flags;
     /* Reset printf coordinates to be consistent w terminal's. Since    */
     /* we may be returning from a halt we want to print onto the next   */
     /* line as a means of making the terminal look cleaner. Update      */
     /* screen_x/y and determine if we want to add a newline.            */
-    if( terminal_x[ display_terminal ] != 0 )
+    if( terminal_x[ sched_terminal ] != 0 )
     {
-        keyboard_putc( '\n' );
-        reset_keyboard_buffer( );
+        terminal_putc( sched_terminal, '\n' );
     }
     screen_x = terminal_x[ display_terminal ];
     screen_y = terminal_y[ display_terminal ];
@@ -278,25 +329,44 @@ int32_t syscall_execute( const uint8_t* command )
     
     /* Get a new PID for the new process. Loop through the PID array    */
     /* since our programs won't necessarily be executed and halted in   */
-    /* order, as they all have different runtimes.                      */
+    /* order, as they all have different runtimes. Interrupts stay off  */
+    /* until the new PCB is complete: a PIT tick runs the scheduler on  */
+    /* curr_pid's PCB, so curr_pid is only set once that PCB is ready.  */
     prev_pid = curr_pid;
+    cli_and_save( flags );
     for( i = 0; i < 6; i++ )
     {
         if( pid_array[ i ] == PID_FREE )
         {
-            pid_array[ i ] = 1;
-            curr_pid = i;
-            pid_array[ i ] = PID_IN_USE;
             break;
         }
     }
     /* If no PIDs are free, return FAILURE. */
     if( i > MAX_NUM_PROGS )
     {
+        restore_flags( flags );
+        return FAILURE;
+    }
+
+    /* Take the kernel stack / PCB and the user page for the new    */
+    /* process from the frame allocator. If memory is exhausted,    */
+    /* fail the execute; the PID was never taken.                   */
+    if( alloc_process_memory( i ) == FAILURE )
+    {
+        restore_flags( flags );
+        klog( KLOG_WARN, "execute: out of memory for pid %d", i );
         return FAILURE;
     }
+    pid_array[ i ] = PID_IN_USE;
+
+    /* Start the new process runnable with clean statistics.        */
+    sched_reset_stats( i );
+    timer_process_init( i );
+    signal_process_init( i );
 
+    curr_pid = i;
     terminals[sched_terminal].pid = curr_pid;
+    restore_flags( flags );
 
     /* Get the PCB (Process Control Block) of the current process,  */
     /* which will hold all the relevant information to our process. */
@@ -346,6 +416,13 @@ int32_t syscall_execute( const uint8_t* command )
         prev_pid = -1;
     }
 
+    /* The parent now waits for the child, which counts as giving   */
+    /* up the CPU voluntarily.                                      */
+    if( prev_pid >= 0 )
+    {
+        get_pcb( prev_pid )->nvcsw++;
+    }
+
     new_pcb->parent_id = prev_pid;
     new_pcb->pid = curr_pid;
     new_pcb->saved_ebp = parent_ebp;
@@ -384,8 +461,8 @@ int32_t syscall_execute( const uint8_t* command )
     /* Refer to: https://wiki.osdev.org/Task_State_Segment for more     */
     /* details on the TSS.                                              */
     tss.ss0 = KERNEL_DS;
-    /* 8 MB - 8KB * curr_pid, -4 for safety.                            */
-    tss.esp0 = EIGHT_MB - EIGHT_KB * curr_pid - 4; 
+    /* Top of the new process' kernel stack.                            */
+    tss.esp0 = get_kernel_stack( curr_pid ); 
 
     /* Load the return address ( given as a label ) into our PCB, so    */
     /* that we can return to the appropriate place later.               */
@@ -490,19 +567,6 @@ int32_t syscall_read( int32_t fd, void* buf, int32_t nbytes )
         return FAILURE;
     }
 
-    /* Synchronize the file_system global file array    */
-    /* with the PCB's local file array so that we don't */
-    /* get issues with opening and reading files or     */
-    /* writing files.                                   */
-    int i;
-    for( i = 0; i < MAX_NUM_FILES; i++ )
-    {
-        file_array[ i ].fops_ptr = program_pcb->fd_array[ i ].fops_ptr;
-        file_array[ i ].index_node_num = program_pcb->fd_array[ i ].index_node_num;
-        file_array[ i ].file_position = program_pcb->fd_array[ i ].file_position;
-        file_array[ i ].flags = program_pcb->fd_array[ i ].flags;
-    }
-
     /* Call the corresponding function based on the     */
     /* file type. Use its return value as the return    */
     /* value for this function.                         */
@@ -530,26 +594,34 @@ int32_t syscall_read( int32_t fd, void* buf, int32_t nbytes )
             program_pcb->fd_array[ fd ].fops_ptr = get_terminal_table( );
             break;
 
+        /* Case 4: Kernel Log Type */
+        case KLOG_FILE_TYPE:
+            program_pcb->fd_array[ fd ].fops_ptr = get_klog_table( );
+            break;
+
+        /* Case 5: Serial Port Type */
+        case SERIAL_FILE_TYPE:
+            program_pcb->fd_array[ fd ].fops_ptr = get_serial_table( );
+            break;
+
+        /* Case 6: Interrupt Statistics Type */
+        case IRQSTAT_FILE_TYPE:
+            program_pcb->fd_array[ fd ].fops_ptr = get_irqstat_table( );
+            break;
+
         /* If program type does not match any of these, */
         /* then an error occurred. Return FAILURE.      */
         default:
             return FAILURE;
     } 
     
+    /* The driver works on this process's own fd_array  */
+    /* entry (see get_open_file), so another process    */
+    /* reading while this one blocks cannot touch it.   */
     function func_read = (void*)program_pcb->fd_array[ fd ].fops_ptr->read;
     /* Read result returns the # of bytes read.         */
     int read_result = (func_read)( fd, buf, nbytes );
-    /* However, since the pcb and filesys file entries  */
-    /* are separate we need to update the pcb's file    */
-    /* entries with the filesys's file entries.         */
-    for( i = 0; i < MAX_NUM_FILES; i++ )
-    {
-        program_pcb->fd_array[ i ].fops_ptr = file_array[ i ].fops_ptr;
-        program_pcb->fd_array[ i ].index_node_num = file_array[ i ].index_node_num;
-        program_pcb->fd_array[ i ].file_position = file_array[ i ].file_position;
-        program_pcb->fd_array[ i ].flags = file_array[ i ].flags; 
-    }
-    
+
     return read_result;
 }
 
@@ -605,19 +677,6 @@ int32_t syscall_write( int32_t fd, const void* buf, int32_t nbytes )
         return FAILURE;
     }
 
-    /* Synchronize the file_system global file array    */
-    /* with the PCB's local file array so that we don't */
-    /* get issues with opening and reading files or     */
-    /* writing files.                                   */
-    int i;
-    for( i = 0; i < MAX_NUM_FILES; i++ )
-    {
-        file_array[ i ].fops_ptr = program_pcb->fd_array[ i ].fops_ptr;
-        file_array[ i ].index_node_num = program_pcb->fd_array[ i ].index_node_num;
-        file_array[ i ].file_position = program_pcb->fd_array[ i ].file_position;
-        file_array[ i ].flags = program_pcb->fd_array[ i ].flags;
-    }
-
     /* Call the corresponding function based on the     */
     /* file type. Use its return value as the return    */
     /* value for this function. Due to the fops         */
@@ -644,21 +703,25 @@ int32_t syscall_write( int32_t fd, const void* buf, int32_t nbytes )
         case TERMINAL_FILE_TYPE:
             program_pcb->fd_array[ fd ].fops_ptr = get_terminal_table( );
             break;
+        /* Case 4: Kernel Log Type */
+        case KLOG_FILE_TYPE:
+            program_pcb->fd_array[ fd ].fops_ptr = get_klog_table( );
+            break;
+        /* Case 5: Serial Port Type */
+        case SERIAL_FILE_TYPE:
+            program_pcb->fd_array[ fd ].fops_ptr = get_serial_table( );
+            break;
+
+        /* Case 6: Interrupt Statistics Type */
+        case IRQSTAT_FILE_TYPE:
+            program_pcb->fd_array[ fd ].fops_ptr = get_irqstat_table( );
+            break;
     }   
 
     function func_write = (void*)program_pcb->fd_array[ fd ].fops_ptr->write;
     /* Read result returns the # of bytes read.         */
     int read_result = (func_write)( fd, buf, nbytes );
-    /* However, since the pcb and filesys file entries  */
-    /* are separate we need to update the pcb's file    */
-    /* entries with the filesys's file entries.         */
-    for( i = 0; i < MAX_NUM_FILES; i++ )
-    {
-        program_pcb->fd_array[ i ].fops_ptr = file_array[ i ].fops_ptr;
-        program_pcb->fd_array[ i ].index_node_num = file_array[ i ].index_node_num;
-        program_pcb->fd_array[ i ].file_position = file_array[ i ].file_position;
-        program_pcb->fd_array[ i ].flags = file_array[ i ].flags; 
-    }
+
     return read_result; 
 }
 
@@ -692,11 +755,32 @@ int32_t syscall_open( const uint8_t* filename )
     /* read_dentry_by_name returns 1 if it fails, and 0 */
     /* if it passes, while passing the dentry instance  */
     /* to the second argument.                          */
+    /* The kernel log, the serial port and the          */
+    /* interrupt statistics are pseudo-files that are   */
+    /* not in the file system image.                    */
     dentry_t dentry;
-    int dentry_pass = read_dentry_by_name( filename, &dentry );
-    if( dentry_pass == FAILURE )
+    if( strncmp( (int8_t*)filename, (int8_t*)KLOG_FILE_NAME, sizeof( KLOG_FILE_NAME ) ) == 0 )
     {
-        return FAILURE;
+        dentry.file_type = KLOG_FILE_TYPE;
+        dentry.index_node_num = 0;
+    }
+    else if( strncmp( (int8_t*)filename, (int8_t*)SERIAL_FILE_NAME, sizeof( SERIAL_FILE_NAME ) ) == 0 )
+    {
+        dentry.file_type = SERIAL_FILE_TYPE;
+        dentry.index_node_num = 0;
+    }
+    else if( strncmp( (int8_t*)filename, (int8_t*)IRQSTAT_FILE_NAME, sizeof( IRQSTAT_FILE_NAME ) ) == 0 )
+    {
+        dentry.file_type = IRQSTAT_FILE_TYPE;
+        dentry.index_node_num = 0;
+    }
+    else
+    {
+        int dentry_pass = read_dentry_by_name( filename, &dentry );
+        if( dentry_pass == FAILURE )
+        {
+            return FAILURE;
+        }
     }
 
     /* Next, get the pCB corresponding to the current   */
@@ -755,6 +839,24 @@ int32_t syscall_open( const uint8_t* filename )
             program_pcb->fd_array[ fd ].fops_ptr = get_file_table( );
             break;
 
+        /* The kernel log. Initialize pcb file array    */
+        /* entry as such.                               */
+        case KLOG_FILE_TYPE:
+            program_pcb->fd_array[ fd ].fops_ptr = get_klog_table( );
+            break;
+
+        /* The COM1 serial port. Initialize pcb file    */
+        /* array entry as such.                         */
+        case SERIAL_FILE_TYPE:
+            program_pcb->fd_array[ fd ].fops_ptr = get_serial_table( );
+            break;
+
+        /* The interrupt statistics. Initialize pcb     */
+        /* file array entry as such.                    */
+        case IRQSTAT_FILE_TYPE:
+            program_pcb->fd_array[ fd ].fops_ptr = get_irqstat_table( );
+            break;
+
         /* File type not recognized, return failure.    */
         default:
             return FAILURE;
@@ -815,6 +917,13 @@ int32_t syscall_close( int32_t fd )
         return FAILURE;
     }
 
+    /* The RTC keeps a virtual timer for each of its    */
+    /* descriptors, release it.                         */
+    if( program_pcb->filetype_array[ fd ] == RTC_TYPE )
+    {
+        rtc_close( fd );
+    }
+
     /* Both checks passed, close the file by resetting  */
     /* the file descriptor's elements to zero.          */
     program_pcb->fd_array[ fd ].fops_ptr = NULL;
@@ -918,7 +1027,7 @@ int32_t syscall_vidmap( uint8_t** screen_start )
     /* Checks if the passed in screen_start is valid and is in the correct address range */
     if (screen_start == NULL) {
         return FAILURE;
-    } else if ((uint32_t) screen_start >= FOUR_MB && (uint32_t) screen_start < EIGHT_MB) { // no sneaky kernel moves
+    } else if ((uint32_t) screen_start < USER_START_ADDR) { // no sneaky kernel moves, all memory below 128MB is the kernel's
         return FAILURE;
     }
 
@@ -929,61 +1038,37 @@ int32_t syscall_vidmap( uint8_t** screen_start )
     /* since there are 1024 total page directory entries */
     uint32_t PDE_index = VIRT_VID_MEM >> 22;
 
-    /* Sets the necessary page directory parameters */
-    page_directory[PDE_index].present = 1;
-    page_directory[PDE_index].read_write = 1;
-    page_directory[PDE_index].user_supervisor = 1;
-    page_directory[PDE_index].page_size = 0;
-    page_directory[PDE_index].virtual_address = ((int)(vid_page_table)) / FOUR_KB;
+    /* Sets the necessary page directory parameters in the process' own directory */
+    page_directory_entry_t* directory = get_pcb( curr_pid )->page_directory;
+    directory[PDE_index].present = 1;
+    directory[PDE_index].read_write = 1;
+    directory[PDE_index].user_supervisor = 1;
+    directory[PDE_index].page_size = 0;
+    directory[PDE_index].global = 0;
+    directory[PDE_index].virtual_address = ((int)(vid_page_table)) / FOUR_KB;
 
-    /* Sets the necessary video page table parameter */
-    vid_page_table[0].present = 1;
-    vid_page_table[0].read_write = 1;
-    vid_page_table[0].user_supervisor = 1;
-    vid_page_table[0].virtual_address = VIDEO_MEM_START_ADDR / FOUR_KB; // 0xB8000
+    /* User programs draw to the page as a flat 80x25 screen, so move */
+    /* the terminal's screen back to the start of its video region.   */
+    scroll_reset( sched_terminal );
 
-    /* Flushes the TLB */
-    flush_tlb();
+    /* Points the video page at the VGA region of the process'        */
+    /* terminal, invalidating the single page with invlpg.            */
+    set_video_page( sched_terminal );
 
     return 0;
 }
 
-/*---------------- syscall_set_handler----------------------*/
-int32_t syscall_set_handler( int32_t signum, void* handler_address )
-{
-    return FAILURE;    
-}
-
-/*-------------------syscall_sigreturn----------------------*/
-int32_t syscall_sigreturn( void )
-{
-    return FAILURE;    
-}
-
 
 /* ----------------- HELPER FUNCTIONS --------------------- */
 /* ----------------- map_prog_to_page --------------------- */
-/* Maps the program to a page in the page table. Maps the   */
-/* user to page 32, defined to be the user page.            */
+/* Switches to the address space of the program, whose page */
+/* directory maps its user page at page 32.                 */
 void map_prog_to_page( int32_t pid )
 {
-    /* Set up new page. Set the entries as appropriate. Also, set   */
-    /* the virtual address according to the PID.                    */
-    page_directory[ USER_PAGE ].present         = 1;
-    page_directory[ USER_PAGE ].read_write      = 1;
-    page_directory[ USER_PAGE ].user_supervisor = 1;
-    page_directory[ USER_PAGE ].write_through   = 0;
-    page_directory[ USER_PAGE ].cache_disable   = 0;
-    page_directory[ USER_PAGE ].accessed        = 0;
-    page_directory[ USER_PAGE ].available_1     = 0;
-    page_directory[ USER_PAGE ].page_size       = 1;
-    page_directory[ USER_PAGE ].global          = 1;
-    page_directory[ USER_PAGE ].available_3     = 0;
-    page_directory[ USER_PAGE ].virtual_address = ( (uint32_t)( EIGHT_MB + ( pid * FOUR_MB ) ) ) >> 12;
-
-    /* Flush the TLB since a new page has been set and old entries  */
-    /* are not irrelevant.                                          */
-    flush_tlb( );
+    /* Each process has its own page directory with its user page  */
+    /* already in place, so switching is just loading it into CR3.  */
+    /* Kernel pages are global and survive the reload.              */
+    loadPageDirectory( (unsigned int*) get_pcb( pid )->page_directory );
 }
 
 /* ------------------ get_fname ----------------------- */
@@ -1111,9 +1196,86 @@ int get_args( const uint8_t* command ) {
 
 /* ------------------ get_pcb ------------------------- */
 /* Gets the PCB corresponding to the PID passed in.     */
-/* Takes in the PID and maps it accordingly.            */
+/* Looks the PID up in the PCB table filled by execute. */
 pcb_t* get_pcb(uint32_t pid) {
-    return (pcb_t*)( EIGHT_MB - EIGHT_KB*( 1 + pid ) );
+    return pcb_table[ pid ];
+}
+
+/* ------------------ get_kernel_stack ---------------- */
+/* Gets the initial kernel stack pointer for a PID, the */
+/* top of its 8KB stack (-4 for safety).                */
+uint32_t get_kernel_stack( int32_t pid )
+{
+    return pcb_table[ pid ]->kernel_stack + EIGHT_KB - 4;
+}
+
+/* ---------------- alloc_process_memory -------------- */
+/* Allocates the memory a new process needs: its PCB    */
+/* from the PCB slab cache, an 8KB kernel stack, a 4MB  */
+/* aligned 4MB page for its program image, and a frame  */
+/* for its page directory.                              */
+/* Inputs: pid -> PID of the new process                */
+/* Outputs: 0 on success, FAILURE if out of memory      */
+static int32_t alloc_process_memory( int32_t pid )
+{
+    pcb_t*   pcb;
+    uint32_t kernel_stack;
+    uint32_t user_page;
+    uint32_t directory;
+
+    pcb = kmem_cache_alloc( &pcb_cache );
+    if( pcb == NULL )
+    {
+        return FAILURE;
+    }
+
+    kernel_stack = frame_alloc_contig( EIGHT_KB / FRAME_SIZE, EIGHT_KB / FRAME_SIZE );
+    if( kernel_stack == 0 )
+    {
+        kmem_cache_free( &pcb_cache, pcb );
+        return FAILURE;
+    }
+
+    user_page = frame_alloc_contig( FRAMES_PER_4MB, FRAMES_PER_4MB );
+    if( user_page == 0 )
+    {
+        frame_free_contig( kernel_stack, EIGHT_KB / FRAME_SIZE );
+        kmem_cache_free( &pcb_cache, pcb );
+        return FAILURE;
+    }
+
+    directory = frame_alloc( );
+    if( directory == 0 )
+    {
+        frame_free_contig( user_page, FRAMES_PER_4MB );
+        frame_free_contig( kernel_stack, EIGHT_KB / FRAME_SIZE );
+        kmem_cache_free( &pcb_cache, pcb );
+        return FAILURE;
+    }
+    page_directory_init( (page_directory_entry_t*)directory, user_page );
+
+    pcb->kernel_stack = kernel_stack;
+    pcb->user_page = user_page;
+    pcb->page_directory = (page_directory_entry_t*)directory;
+    pcb_table[ pid ] = pcb;
+    return 0;
+}
+
+/* ---------------- free_process_memory --------------- */
+/* Returns the memory of a halted process to the frame  */
+/* allocator and the PCB cache, and clears its PCB      */
+/* table entry so nothing can reach the freed PCB.      */
+/* Inputs: pid -> PID of the halted process             */
+/* Outputs: None.                                       */
+static void free_process_memory( int32_t pid )
+{
+    pcb_t* pcb = pcb_table[ pid ];
+
+    frame_free( (uint32_t)pcb->page_directory );
+    frame_free_contig( pcb->user_page, FRAMES_PER_4MB );
+    frame_free_contig( pcb->kernel_stack, EIGHT_KB / FRAME_SIZE );
+    kmem_cache_free( &pcb_cache, pcb );
+    pcb_table[ pid ] = NULL;
 }
 
 /* ------------------ close_all_files ----------------- */
@@ -10,6 +10,8 @@
 #include "syscall_wrapper.h"
 #include "keyboard.h"
 #include "tests.h"
+#include "frame.h"
+#include "timer.h"
 
 
 /* Constants relevant to System Calls */
@@ -58,6 +60,14 @@
                                         /* Takes the top 10 bits of user virtual start  */
                                         /* address 0x8000000 */
 
+/* Signal numbers, the same as in ece391syscall.h */
+#define SIG_DIV_ZERO    0
+#define SIG_SEGFAULT    1
+#define SIG_INTERRUPT   2
+#define SIG_ALARM       3
+#define SIG_USER1       4
+#define NUM_SIGNALS     5
+
 /* Struct for Process Control Block (PCB) */
 typedef struct pcb_t {
         int32_t         pid;                             /* Process ID # for the current process */
@@ -74,6 +84,29 @@ typedef struct pcb_t {
         uint32_t        ss0;                             /* SS0 of process, passed down by TSS   */
         /* Also store args and size of for later use (like syscall_getargs)                      */
         uint8_t         saved_command[ BUFFER_SIZE ];    /* Saved command for get_args           */  
+        /* Scheduler state and accounting, maintained by scheduling.c                            */
+        int32_t         terminal;                        /* Terminal the process runs on         */
+        uint32_t        sched_state;                     /* SCHED_RUNNABLE or SCHED_BLOCKED      */
+        uint32_t        wait_channel;                    /* WAIT_* channel while blocked         */
+        uint32_t        wake_tsc;                        /* Low TSC word when woken, 0 if not    */
+        uint32_t        cpu_ticks;                       /* PIT ticks spent running              */
+        uint32_t        nvcsw;                           /* Voluntary context switches           */
+        uint32_t        nivcsw;                          /* Involuntary context switches         */
+        uint32_t        wakeups;                         /* Wakeups followed by a run            */
+        uint32_t        wake_lat_avg;                    /* Average wake-to-run cycles           */
+        uint32_t        wake_lat_max;                    /* Worst wake-to-run cycles             */
+        /* Physical memory taken from the frame allocator                                        */
+        uint32_t        kernel_stack;                    /* Base of the 8KB kernel stack         */
+        uint32_t        user_page;                       /* Physical 4MB frame of the program    */
+        page_directory_entry_t* page_directory;          /* The process' own page directory      */
+        /* Timers, maintained by timer.c                                                         */
+        ktimer_t        sleep_timer;                     /* Ends syscall_sleep                   */
+        ktimer_t        alarm_timer;                     /* One-shot timer of syscall_alarm      */
+        volatile uint32_t sleep_done;                    /* Set when sleep_timer ran             */
+        volatile uint32_t pending_signals;               /* Bit per SIG_* raised, not yet taken  */
+        /* Signal handling, maintained by signal.c                                               */
+        void*           signal_handlers[ NUM_SIGNALS ];  /* User handler per SIG_*, NULL default */
+        uint32_t        signal_mask;                     /* SIG_* bits held back while handling  */
 
 } pcb_t;
 
@@ -85,6 +118,9 @@ extern int32_t active_pid;
 /* Can only have 6 processes open outside of STDIN/OUT   */
 extern int32_t pid_array[MAX_NUM_FILES - 2];
 
+/* PCB of each PID, allocated from the PCB slab cache.   */
+extern pcb_t* pcb_table[MAX_NUM_FILES - 2];
+
 /* Define System Call Functions. Prototypes provided by  */
 /* Appendix B of MP3 Documentation                       */
 int32_t syscall_halt( uint8_t status );
@@ -95,6 +131,8 @@ int32_t syscall_open( const uint8_t* filename );
 int32_t syscall_close( int32_t fd );
 int32_t syscall_getargs( uint8_t* buf, int32_t nbytes );
 int32_t syscall_vidmap( uint8_t** screen_start );
+
+/* Signal system calls, in signal.c                      */
 int32_t syscall_set_handler( int32_t signum, void* handler_address );
 int32_t syscall_sigreturn( void );
 
@@ -103,6 +141,7 @@ int32_t syscall_sigreturn( void );
 int get_fname( const uint8_t* command );
 int get_args( const uint8_t* command );
 pcb_t* get_pcb(uint32_t pid);
+uint32_t get_kernel_stack( int32_t pid );
 void switch_context(uint32_t pid);
 void map_prog_to_page( int32_t pid );
 void close_all_files( void );
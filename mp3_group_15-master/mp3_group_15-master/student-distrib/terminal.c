@@ -3,10 +3,7 @@
 #include "terminal.h"
 #include "paging.h"
 #include "scheduling.h"
-
-uint8_t     terminal_buffer[ BUFFER_SIZE ];
-uint32_t    read_ready;
-uint32_t    terminal_vid_mem[ NUM_TERMINALS ][ TERMINAL_MEMORY_SIZE ];
+#include "signal.h"
 
 /* Implemented as a part of the scheduler, initializes  */
 /* the 3 terminal instances with intial bootup method   */
@@ -16,6 +13,8 @@ uint32_t    terminal_vid_mem[ NUM_TERMINALS ][ TERMINAL_MEMORY_SIZE ];
 
 void terminals_init( void ){
     int i;
+    int j;
+    char* video;
     for (i = 0; i < NUM_TERMINALS; i++ ) {
         /* Since there are no current processes running */
         terminals[i].num_processes = 0;
@@ -23,12 +22,35 @@ void terminals_init( void ){
         terminals[i].pid = -1;
         terminals[i].saved_esp = 0;
         terminals[i].saved_ebp = 0;
-        /* Set the buffers to null just to be safe      */
-        memset(terminals[i].terminal_buffer, '\0', BUFFER_SIZE);
+        terminals[i].input_head = 0;
+        terminals[i].input_tail = 0;
+        terminals[i].input_lines = 0;
+        terminals[i].mode = TERM_MODE_CANON;
+
+        /* Blank the screen, since processes on hidden          */
+        /* terminals print to it before it is ever displayed.   */
+        video = TERM_REGION( i );
+        for (j = 0; j < REGION_ROWS * NUM_COLS; j++) {
+            video[j << 1] = ' ';
+            video[(j << 1) + 1] = ATTRIB;
+        }
+        terminal_top[i] = 0;
     }
 
-    sched_terminal = 2;
-    display_terminal = 2;    
+    sched_terminal = 0;
+    display_terminal = 0;    
+}
+
+/*                terminal_video_base                   */
+/* Returns the VGA region holding the screen of a       */
+/* terminal. The screen stays there whether or not the  */
+/* terminal is displayed.                               */
+/* Inputs: term -> terminal index.                      */
+/* Outputs: Address of the terminal's screen.           */
+/* Side Effects: None.                                  */
+char* terminal_video_base( int32_t term )
+{
+    return TERM_REGION( term );
 }
 
 
@@ -79,90 +101,151 @@ int32_t terminal_close( int32_t fd )
 
 
 /*                     terminal_read                    */
-/* Reads data from the keyboard. Read should return the */
-/* data from one line by pressing Enter, or as much as  */
-/* fits in the buffer from one such line. The line read */
-/* SHOULD INCLUDE the line feed ('\n') character.       */
+/* Reads data from the keyboard. In canonical mode read */
+/* returns the data from one line by pressing Enter, or */
+/* as much as fits in the buffer from one such line.    */
+/* The line read SHOULD INCLUDE the line feed ('\n')    */
+/* character. In raw mode read returns whatever has     */
+/* been typed, up to nbytes, as soon as there is any.   */
+/* With TERM_MODE_NONBLOCK set, read returns 0 instead  */
+/* of waiting when there is nothing to return.          */
 /* Inputs: fd -> File Descriptor. Unused in terminal    */
 /*               driver.                                */
 /*         buf -> buffer to be filled.                  */
-/*         nbytes -> num of bytes to be read. Unused in */
-/*                   terminal driver.                   */
+/*         nbytes -> num of bytes to be read.           */
 /* Outputs: Num of bytes read from the keyboard.        */
-/* Side Effects: Fills the Terminal Buffer with the     */
-/* data read from the keyboard.                         */
+/* Side Effects: Takes the data read from the input     */
+/* ring of the terminal.                                */
 int32_t terminal_read( int32_t fd, void* buf, int32_t nbytes )
 {
-    /* word_count and keyboard_buffer provided in       */
-    /* keyboard.c. Both are kept track of, and can be   */
-    /* used here to read to the terminal.               */
-
+    /* Input only goes to the displayed terminal, so    */
+    /* read from the terminal this process runs on.     */
+    terminal_t* term = &terminals[ sched_terminal ];
 
-    /* Wait for the signal to read. Will use a global   */
-    /* flag to do so, which will be updated by the      */
-    /* keyboards driver. Set to 0 on start, but wait    */
-    /* for other program to set.                        */
-    read_ready = 0;
-
-    /* Loop while ready flag not raised, or the "Enter" */
-    /* key has not been pressed yet...                  */
-    while( !read_ready ){ }
-
-    /* Reset the read_ready signal in case we try to    */
-    /* run terminal_read again.                         */
-    read_ready = 0;
+    /* We also need to cast buf as a uint8_t type in    */
+    /* order to function properly, as we cannot do      */
+    /* anything with a void pointer.                    */
+    uint8_t* read_buf = buf;
+    int32_t  count = 0;
+    uint8_t  c;
+    uint32_t flags;
 
     /* Check if the buffer is NULL. If so, then return. */
-    if( buf == NULL )
+    if( buf == NULL || nbytes <= 0 )
     {
-        reset_keyboard_buffer( );
         return 0;
     }
 
-    /* We also need to cast buf as a uint8_t type in    */
-    /* order to function properly, as we cannot do      */
-    /* anything with a void pointer.                    */
-    uint8_t* read_buf = buf;
-
-    /* Reset the terminal buffer so that we can make    */
-    /* sure that commands don't get repeated/input      */
-    /* doesn't get super weird or anything...           */
-    int i;
-    for( i = 0; i < BUFFER_SIZE; i++ )
+    /* Block until a whole line has been entered, or in */
+    /* raw mode until anything has been typed. The      */
+    /* keyboard driver wakes us when it queues input.   */
+    /* Ctrl + C, or a signal with a handler, ends the   */
+    /* wait with nothing read, so the signal is taken   */
+    /* on the way out.                                  */
+    if( term->mode & TERM_MODE_NONBLOCK )
     {
-        read_buf[ i ] = 0;
+        if( !TERMINAL_INPUT_READY( term ) )
+        {
+            return 0;
+        }
+    }
+    else
+    {
+        sched_wait_event( WAIT_KEYBOARD, TERMINAL_INPUT_READY( term ) || signal_interrupted( ) );
+        if( !TERMINAL_INPUT_READY( term ) )
+        {
+            return -1;
+        }
     }
 
-    /* Now copy the contents of the keyboard buffer     */
-    /* into the terminal buffer. The buffer should      */
-    /* include the line feed character at the end of    */
-    /* the sequence of characters.                      */
-    int count;
-    count = 0;
-    for( i = 0; i < BUFFER_SIZE; i++ )
+    /* Now copy the contents of the input ring into the */
+    /* buffer. In canonical mode we stop after the line */
+    /* feed character, so one read returns one line.    */
+    cli_and_save( flags );
+    while( count < nbytes && term->input_head != term->input_tail )
     {
-        /* We have reached the end of the keyboard buffer   */
-        /* if we hit the character '\n'. Thus, we can       */
-        /* keep looping until we get to '\n', in which case */
-        /* we can break the loop and return the number of   */
-        /* characters written.                              */
-        read_buf[ i ] = keyboard_buffer[ display_terminal ][ i ];
+        c = term->input[ term->input_head & INPUT_RING_MASK ];
+        term->input_head++;
+        read_buf[ count ] = c;
         count++;
-        if( read_buf[ i ] == '\n' )
+        if( c == '\n' )
         {
-            break;
+            term->input_lines--;
+            if( !( term->mode & TERM_MODE_RAW ) )
+            {
+                break;
+            }
         }
     }
-
-    /* Clear the keyboard buffer and word_count now that we */
-    /* have taken the data passed through                   */
-    reset_keyboard_buffer( );
+    restore_flags( flags );
 
     /* Since each character is one byte, we can just return the */
     /* number of characters written to the buffer!              */
     return count;
 }
 
+/*                    terminal_input                    */
+/* Queues characters on the input ring of a terminal    */
+/* and wakes the processes waiting to read. Called by   */
+/* the keyboard driver with a finished line, or with    */
+/* single keystrokes in raw mode.                       */
+/* Inputs: term -> terminal the input belongs to.       */
+/*         buf -> characters to queue.                  */
+/*         n -> number of characters.                   */
+/* Outputs: n, or 0 if the ring does not have room for  */
+/*          all of them, in which case none are queued  */
+/*          so a line is never split.                   */
+/* Side Effects: Wakes readers of the keyboard.         */
+int32_t terminal_input( int32_t term, const uint8_t* buf, int32_t n )
+{
+    terminal_t* t = &terminals[ term ];
+    uint32_t flags;
+    int32_t  i;
+
+    cli_and_save( flags );
+    if( n <= 0 || INPUT_RING_SIZE - ( t->input_tail - t->input_head ) < (uint32_t)n )
+    {
+        restore_flags( flags );
+        return 0;
+    }
+    for( i = 0; i < n; i++ )
+    {
+        t->input[ t->input_tail & INPUT_RING_MASK ] = buf[ i ];
+        t->input_tail++;
+        if( buf[ i ] == '\n' )
+        {
+            t->input_lines++;
+        }
+    }
+    restore_flags( flags );
+
+    sched_wake( WAIT_KEYBOARD );
+    return n;
+}
+
+/*                   syscall_termmode                   */
+/* Sets the line discipline of the terminal the calling */
+/* process runs on. halt puts the terminal back into    */
+/* canonical mode, so a program that exits in raw mode  */
+/* does not leave the shell without line editing.       */
+/* Inputs: mode -> TERM_MODE_* bits.                    */
+/* Outputs: The previous mode, or -1 if mode has        */
+/*          unknown bits set.                           */
+/* Side Effects: Changes how the terminal is read.      */
+int32_t syscall_termmode( int32_t mode )
+{
+    int32_t old;
+
+    if( mode & ~TERM_MODE_MASK )
+    {
+        return -1;
+    }
+
+    old = terminals[ sched_terminal ].mode;
+    terminals[ sched_terminal ].mode = mode;
+    return old;
+}
+
 
 
 /*                   terminal_write                     */
@@ -203,26 +286,9 @@ int32_t terminal_write( int32_t fd, const void* buf, int32_t nbytes )
     /* the number of bytes is less than the number of           */
     /* characters in the buffer, then the function will only    */
     /* print out as many characters as specified by nbytes.     */
-    int i;
-    uint8_t c;
-    uint32_t num_bytes = 0;
-    for( i = 0; i < nbytes; i++ )
-    {
-        c = write_buf[ i ];
-        /* If character is not valid, then break.   */
-        if( c == '\0' || c == 0 )
-        {
-            break;
-        }
-        keyboard_putc( c );
-        reset_keyboard_buffer( );
-        num_bytes++;
-    }
-
-    /* Because we used the put_string function, our keyboard    */
-    /* buffer gets filled, thus we need to reset it in order    */
-    /* for our functions to work properly again.                */
-    reset_keyboard_buffer( );
+    /* Print to the terminal of the writing process, which need */
+    /* not be the one on screen, in a single batch.             */
+    uint32_t num_bytes = terminal_puts( sched_terminal, write_buf, nbytes );
 
     /* Return the number of bytes read.                         */
     return num_bytes;
@@ -241,17 +307,15 @@ void switch_terminal( uint32_t terminal_target_index )
         return;
     }
 
-    
-    /* Copy current physical video memory into an alternate     */
-    /* location in virtual memory                               */
-    memcpy((void*) ((VIDEO_ALT_START + display_terminal) * SCHED_FOUR_KB), (void*) VIDEO_MEM_LOC, SCHED_FOUR_KB);  
 
     /* Update the new display terminal */
     display_terminal = terminal_target_index;     
 
-    /* Copy video memory from alternate virtual address to      */
-    /* physical address to be displayed on screen               */
-    memcpy((void*) VIDEO_MEM_LOC, (void*) ((VIDEO_ALT_START + display_terminal) * SCHED_FOUR_KB), SCHED_FOUR_KB);
+    /* Every terminal keeps its screen in its own VGA region,   */
+    /* so switching only points the VGA at the new terminal's   */
+    /* region. Nothing is copied, and the video page of the     */
+    /* running process still maps its own terminal's region.    */
+    terminal_show_screen( );
 
     /* Print the cursor at the corresponding location.*/
     terminal_print_cursor( terminal_y[ display_terminal ], terminal_x[ display_terminal ] );    
@@ -10,22 +10,50 @@
 #define BYTE_0_MASK             0xFF    /* Mask used to mask Byte 0.                */
 #define HIGH_BYTE_SHIFT         8       /* Used to shift high byte into lower byte. */
 
-#define TERMINAL_MEMORY_START   0xB9000
-#define TERMINAL_MEMORY_SIZE    0x1000
+/* The 32KB VGA text window (0xB8000-0xBFFFF) is split into 8KB */
+/* regions: one resident region per terminal, and a spare one   */
+/* after them where the scrollback view is built. Switching     */
+/* terminals only points the CRTC start address at another      */
+/* region. Each region holds more rows than the screen so       */
+/* scrolling only moves the start address (see scroll_screen).  */
+#define TERM_REGION_SIZE        0x2000
+#define TERM_REGION_START       0xB8000
+#define TERM_REGION_CHARS       ( TERM_REGION_SIZE >> 1 )
+#define TERM_REGION( term )     ( (char*)( TERM_REGION_START + ( term ) * TERM_REGION_SIZE ) )
+#define TERM_VIEW_REGION        TERM_REGION( NUM_TERMINALS )
 
-extern uint8_t  terminal_buffer[ BUFFER_SIZE ];
-extern uint32_t terminal_vid_mem[ NUM_TERMINALS ][ TERMINAL_MEMORY_SIZE ];
-extern uint32_t read_ready;
+/* Keyboard input waiting to be read, per terminal. In         */
+/* canonical mode the keyboard driver edits a line in its own   */
+/* buffer and queues it here when Enter is pressed; in raw mode */
+/* every keystroke is queued as soon as it is typed.            */
+#define INPUT_RING_SIZE         512     /* Must be a power of two.                  */
+#define INPUT_RING_MASK         ( INPUT_RING_SIZE - 1 )
+
+/* Line discipline mode bits, set with the termmode system call */
+#define TERM_MODE_CANON         0x0     /* Line editing and echo, read whole lines  */
+#define TERM_MODE_RAW           0x1     /* No echo, read returns single keystrokes  */
+#define TERM_MODE_NONBLOCK      0x2     /* Read returns 0 instead of waiting        */
+#define TERM_MODE_MASK          0x3
+
+/* Whether a read of the terminal has something to return       */
+#define TERMINAL_INPUT_READY( t ) \
+    ( ( (t)->mode & TERM_MODE_RAW ) ? (t)->input_head != (t)->input_tail : (t)->input_lines != 0 )
 
 /* Struct of terminal and contains necessary info for scheduler  */
 typedef struct terminal_t {
     uint32_t num_processes;                         /* Keep track of num current processes to make sure no more than 6  */
-    uint8_t  terminal_buffer[ TERMINAL_MEMORY_SIZE ];    /* Instance of a terminal buffer for each of the terminals          */
     
     uint32_t initialized;                     /* Flag to determine if a terminal has already been initialized */
     int32_t  pid;                             /* Process ID # for the current process */
     uint32_t saved_esp;                       /* ESP of parent to return to           */
     uint32_t saved_ebp;                       /* EBP of parent to return to           */
+
+    /* Input ring. Indices run freely and are masked on access. */
+    uint8_t  input[ INPUT_RING_SIZE ];        /* Characters waiting to be read        */
+    uint32_t input_head;                      /* Next character to read               */
+    uint32_t input_tail;                      /* Where the next character is queued   */
+    uint32_t input_lines;                     /* Number of '\n' in the ring           */
+    uint32_t mode;                            /* TERM_MODE_* bits                     */
 } terminal_t;
 
 terminal_t terminals[NUM_TERMINALS];
@@ -39,6 +67,13 @@ extern int32_t terminal_close( int32_t fd );
 extern int32_t terminal_read( int32_t fd, void* buf, int32_t nbytes );
 extern int32_t terminal_write( int32_t fd, const void* buf, int32_t nbytes );
 extern  void   switch_terminal( uint32_t terminal_target_index );
+extern  char*  terminal_video_base( int32_t term );
 extern  void   terminals_init( void );
 
+/* Queues typed characters on the input ring of a terminal */
+extern int32_t terminal_input( int32_t term, const uint8_t* buf, int32_t n );
+
+/* Sets the line discipline of the calling process' terminal */
+extern int32_t syscall_termmode( int32_t mode );
+
 #endif
@@ -8,6 +8,17 @@
 #include "terminal.h"
 #include "syscall.h"
 #include "paging.h"
+#include "klog.h"
+#include "frame.h"
+#include "kmalloc.h"
+#include "serial.h"
+#include "clock.h"
+#include "timer.h"
+#include "i8259.h"
+#include "apic.h"
+#include "irqstat.h"
+#include "signal.h"
+#include "idt.h"
 
 #define PASS 1
 #define FAIL 0
@@ -20,13 +31,16 @@
 #define RUN_CHECKPOINT4_TESTS 0
 #define RUN_CHECKPOINT5_TESTS 0
 
+/* Runs only the benchmark suite (see run_benchmarks) */
+#define RUN_BENCHMARKS 0
+
 
 
 /* format these macros as you see fit */
 #define TEST_HEADER 	\
 	printf("[TEST %s] Running %s at %s:%d\n", __FUNCTION__, __FUNCTION__, __FILE__, __LINE__)
 #define TEST_OUTPUT(name, result)	\
-	printf("[TEST %s] Result = %s\n", name, (result) ? "PASS" : "FAIL");
+	test_output(name, result);
 
 static inline void assertion_failure(){
 	/* Use exception #15 for assertions, otherwise
@@ -34,6 +48,17 @@ static inline void assertion_failure(){
 	asm volatile("int $15");
 }
 
+/* Prints a test result on the screen, and also on COM1 so the	*/
+/* results can be collected with qemu -serial stdio.			*/
+static void test_output(int8_t* name, int32_t result){
+	int8_t line[80];
+	int32_t len;
+
+	len = snprintf(line, sizeof(line), "[TEST %s] Result = %s\n", name, (result) ? "PASS" : "FAIL");
+	printf("%s", line);
+	serial_write_buf((uint8_t*)line, len);
+}
+
 /* Test suite entry point */
 void launch_tests( void ){
 	unsigned int i;
@@ -54,6 +79,11 @@ void launch_tests( void ){
 	screen_y = 0;
 	// printf("Running tests!\n");
 
+#if RUN_BENCHMARKS
+	run_benchmarks( );
+	return;
+#endif
+
 #if RUN_CHECKPOINT1_TESTS
 	/* //////////////////////////////////////////////////////////// */
 	/* -------------------- CHECKPOINT 1 TESTS -------------------- */
@@ -84,6 +114,46 @@ void launch_tests( void ){
     TEST_OUTPUT("paging_init_test", paging_init_test( ));
 	printf("\n");
 
+	/* Allocates, checks alignment of and frees page frames			*/
+    TEST_OUTPUT("frame_alloc_test", frame_alloc_test( ));
+	printf("\n");
+
+	/* Allocates and frees kernel objects, then dumps the caches	*/
+    TEST_OUTPUT("kmalloc_test", kmalloc_test( ));
+	printf("\n");
+
+	/* Logs to the kernel log and reads it back as dmesg does		*/
+    TEST_OUTPUT("klog_test", klog_test( ));
+	printf("\n");
+
+	/* Sends more than a ring of output to COM1					*/
+    TEST_OUTPUT("serial_test", serial_test( ));
+	printf("\n");
+
+	/* Checks the TSC calibration and the nanosecond clock			*/
+    TEST_OUTPUT("clock_test", clock_test( ));
+	printf("\n");
+
+	/* Runs timers on every level of the timer wheel				*/
+    TEST_OUTPUT("timer_wheel_test", timer_wheel_test( ));
+	printf("\n");
+
+	/* Checks the word-at-a-time string routines at odd offsets	*/
+    TEST_OUTPUT("string_routines_test", string_routines_test( ));
+	printf("\n");
+
+	/* Masks and unmasks an IRQ at the I/O APIC, if in use			*/
+    TEST_OUTPUT("apic_irq_test", apic_irq_test( ));
+	printf("\n");
+
+	/* Waits for RTC interrupts and prints the irqstat report		*/
+    TEST_OUTPUT("irqstat_test", irqstat_test( ));
+	printf("\n");
+
+	/* Checks the signal frame layout and argument checks			*/
+    TEST_OUTPUT("signal_test", signal_test( ));
+	printf("\n");
+
 	/* The paging bounds tests accepst an integer from 1-4 to test  */
 	/* the upper and lower bounds of the kernel and video page      */
 	/* initialization (SHOULD CAUSE PAGE FAULT)						*/
@@ -159,6 +229,9 @@ void launch_tests( void ){
 	screen_y = 0;
 
 	TEST_OUTPUT("rtc_read_write_test", rtc_read_write_test( ));
+
+	/* Two descriptors at different rates share the RTC			*/
+	TEST_OUTPUT("rtc_virtual_test", rtc_virtual_test( ));
 	
 
 	printf("Testing File Systems Next...\n");
@@ -244,6 +317,20 @@ void launch_tests( void ){
 	/* the argument. 												*/
 	TEST_OUTPUT("terminal_write_size_test", terminal_write_size_test( ));	
 
+	/* -------------------- TERMINAL INPUT TEST ------------------- */
+	/* Tests that typed lines are queued on the input ring and read	*/
+	/* back one at a time, and that raw mode returns keystrokes.	*/
+	TEST_OUTPUT("terminal_input_ring_test", terminal_input_ring_test( ));
+
+	/* -------------------- TERMINAL ANSI TEST -------------------- */
+	/* Tests cursor positioning, erase-line and color escapes.		*/
+	TEST_OUTPUT("terminal_ansi_test", terminal_ansi_test( ));
+
+	/* ------------------ TERMINAL WRITE CELLS TEST --------------- */
+	/* Tests the count terminal_write returns and the characters	*/
+	/* it leaves in video memory, across a line break and a NUL.	*/
+	TEST_OUTPUT("terminal_write_cells_test", terminal_write_cells_test( ));
+
 	/* -------------------- TERMINAL DRIVER TEST ------------------ */
 	/* Function that tests that the terminal driver works. Type		*/
 	/* keys into the keyboard when the test is being run, and press	*/
@@ -267,7 +354,15 @@ void launch_tests( void ){
 #endif
 
 #if RUN_CHECKPOINT5_TESTS
+	/* Times printing the large text file through terminal_write,	*/
+	/* which is dominated by scrolling.								*/
+	TEST_OUTPUT("terminal_scroll_benchmark", terminal_scroll_benchmark( ));
+
+	/* Bytes per cycle of the lib.c string and memory routines		*/
+	TEST_OUTPUT("string_benchmark", string_benchmark( ));
 
+	/* Cycles to mask, unmask and EOI on the 8259s and the APIC		*/
+	TEST_OUTPUT("irq_controller_benchmark", irq_controller_benchmark( ));
 #endif
 
 
@@ -605,6 +700,563 @@ int paging_init_test( void )
 	return PASS;
 }
 
+/* FRAME ALLOC TEST */
+/* Allocates single frames and a 4MB aligned run from the      */
+/* frame allocator, checks the addresses are usable and        */
+/* aligned, and that freeing returns every frame.              */
+/* Inputs: None. 											   */
+/* Outputs: PASS/FAIL										   */
+/* Side Effects: Will page fault if a frame is not mapped      */
+/* Coverage: frame_alloc, frame_alloc_contig, frame_free       */
+int frame_alloc_test( void )
+{
+	TEST_HEADER;
+	uint32_t free_before = frame_free_count( );
+	uint32_t frame_a, frame_b, big;
+
+	frame_a = frame_alloc( );
+	frame_b = frame_alloc( );
+	if( frame_a == 0 || frame_b == 0 || frame_a == frame_b )
+		return FAIL;
+	if( ( frame_a & ( FRAME_SIZE - 1 ) ) || ( frame_b & ( FRAME_SIZE - 1 ) ) )
+		return FAIL;
+
+	/* Frames must be mapped for the kernel to use them */
+	memset( (void*)frame_a, 0, FRAME_SIZE );
+	memset( (void*)frame_b, 0, FRAME_SIZE );
+
+	big = frame_alloc_contig( FRAMES_PER_4MB, FRAMES_PER_4MB );
+	if( big == 0 || ( big & ( FRAMES_PER_4MB * FRAME_SIZE - 1 ) ) )
+		return FAIL;
+	if( frame_free_count( ) != free_before - 2 - FRAMES_PER_4MB )
+		return FAIL;
+
+	frame_free_contig( big, FRAMES_PER_4MB );
+	frame_free( frame_b );
+	frame_free( frame_a );
+
+	if( frame_free_count( ) != free_before )
+		return FAIL;
+
+	/* The lowest free frame is handed out first */
+	if( frame_alloc( ) != frame_a )
+		return FAIL;
+	frame_free( frame_a );
+
+	return PASS;
+}
+
+/* KMALLOC TEST */
+/* Allocates objects of several sizes from kmalloc, checks     */
+/* they are distinct and writable, frees them and checks the   */
+/* frame allocator got every slab back. Prints the statistics  */
+/* of every cache before and after freeing.                    */
+/* Inputs: None. 											   */
+/* Outputs: PASS/FAIL										   */
+/* Side Effects: Prints the cache statistics				   */
+/* Coverage: kmalloc, kfree, kmem_cache_alloc/free             */
+#define KMALLOC_TEST_OBJS	64
+int kmalloc_test( void )
+{
+	TEST_HEADER;
+	uint32_t free_before = frame_free_count( );
+	uint8_t* small[ KMALLOC_TEST_OBJS ];
+	uint8_t* medium;
+	uint8_t* large;
+	int i;
+
+	for( i = 0; i < KMALLOC_TEST_OBJS; i++ ) {
+		small[ i ] = kmalloc( 24 );
+		if( small[ i ] == NULL )
+			return FAIL;
+		memset( small[ i ], i, 24 );
+	}
+	medium = kmalloc( 300 );
+	large = kmalloc( 3 * FRAME_SIZE );
+	if( medium == NULL || large == NULL )
+		return FAIL;
+	memset( medium, 0xAA, 300 );
+	memset( large, 0x55, 3 * FRAME_SIZE );
+
+	/* No object may overlap another */
+	for( i = 0; i < KMALLOC_TEST_OBJS; i++ ) {
+		if( small[ i ][ 0 ] != i || small[ i ][ 23 ] != i )
+			return FAIL;
+	}
+
+	kmalloc_print_stats( );
+
+	for( i = 0; i < KMALLOC_TEST_OBJS; i++ )
+		kfree( small[ i ] );
+	kfree( medium );
+	kfree( large );
+
+	kmalloc_print_stats( );
+
+	/* Each cache keeps at most one empty slab */
+	if( frame_free_count( ) + 2 < free_before )
+		return FAIL;
+
+	return PASS;
+}
+
+/* KLOG TEST */
+/* Logs a few messages and reads them back as text, checks that	*/
+/* a reader that fell behind by more than the ring skips to the	*/
+/* oldest record still kept, that a full read returns 0, and	*/
+/* that reads smaller than a line return it in pieces.			*/
+/* Inputs: None. 											   */
+/* Outputs: PASS/FAIL										   */
+/* Side Effects: Adds records to the kernel log				   */
+/* Coverage: klog, klog_read_text, vsnprintf                   */
+int klog_test( void )
+{
+	uint8_t  buf[ KLOG_LINE_LEN * 2 ];
+	uint32_t pos = klog_head;
+	uint32_t offset = 0;
+	int32_t  len;
+	int32_t  part;
+	int      i;
+	int      result = PASS;
+
+	klog( KLOG_INFO, "klog_test %d %s %x", -5, "abc", 0x1F );
+	len = klog_read_text( &pos, &offset, buf, sizeof( buf ) );
+	buf[ len ] = '\0';
+	printf( "%s", (int8_t*)buf );
+	if( len == 0 || pos != klog_head || buf[ len - 1 ] != '\n' )
+	{
+		result = FAIL;
+	}
+	for( i = 0; i + 19 < len; i++ )
+	{
+		if( strncmp( (int8_t*)&buf[ i ], "klog_test -5 abc 1f", 19 ) == 0 )
+		{
+			break;
+		}
+	}
+	if( i + 19 >= len )
+	{
+		result = FAIL;
+	}
+
+	/* Nothing new to read. */
+	if( klog_read_text( &pos, &offset, buf, sizeof( buf ) ) != 0 )
+	{
+		result = FAIL;
+	}
+
+	/* A buffer smaller than a line gets the line in pieces. */
+	klog( KLOG_INFO, "klog_test small reads" );
+	len = 0;
+	while( len + 7 <= (int32_t)sizeof( buf ) &&
+		   ( part = klog_read_text( &pos, &offset, buf + len, 7 ) ) > 0 )
+	{
+		len += part;
+	}
+	if( len < 22 || pos != klog_head || offset != 0 || buf[ len - 1 ] != '\n' ||
+		strncmp( (int8_t*)&buf[ len - 22 ], "klog_test small reads\n", 22 ) != 0 )
+	{
+		result = FAIL;
+	}
+
+	/* Lap the reader; it continues from the oldest record. */
+	pos = klog_head;
+	for( i = 0; i < KLOG_RECORDS + 3; i++ )
+	{
+		klog( KLOG_DEBUG, "lap %d", i );
+	}
+	offset = 0;
+	len = klog_read_text( &pos, &offset, buf, KLOG_LINE_LEN );
+	if( pos <= klog_head - KLOG_RECORDS || pos > klog_head )
+	{
+		result = FAIL;
+	}
+	for( i = 0; i < len && buf[ i ] != '\n'; i++ ) {}
+	if( i < 6 || strncmp( (int8_t*)&buf[ i - 6 ], " lap 3", 6 ) != 0 )
+	{
+		result = FAIL;
+	}
+
+	return result;
+}
+
+/* SERIAL TEST */
+/* Writes more than the transmit ring holds to COM1, so the 	*/
+/* writer has to wait for the UART, and checks the argument 	*/
+/* checks of the file operations. Without a UART the port must	*/
+/* refuse to open.											   */
+/* Inputs: None. 											   */
+/* Outputs: PASS/FAIL										   */
+/* Side Effects: Sends text out of COM1						   */
+/* Coverage: serial_open, serial_read, serial_write			   */
+int serial_test( void )
+{
+	int8_t  line[] = "serial_test: 0123456789abcdefghijklmnopqrstuvwxyz\n";
+	int32_t len = strlen( line );
+	int32_t sent = 0;
+	int     result = PASS;
+
+	if( !serial_present( ) )
+	{
+		return ( serial_open( (uint8_t*)SERIAL_FILE_NAME ) == -1 ) ? PASS : FAIL;
+	}
+
+	if( serial_open( (uint8_t*)SERIAL_FILE_NAME ) != 0 )
+	{
+		result = FAIL;
+	}
+	while( sent < SERIAL_TX_SIZE + len )
+	{
+		if( serial_write( 0, line, len ) != len )
+		{
+			result = FAIL;
+			break;
+		}
+		sent += len;
+	}
+	if( serial_write( 0, NULL, len ) != -1 || serial_read( 0, NULL, len ) != -1 )
+	{
+		result = FAIL;
+	}
+
+	return result;
+}
+
+/* CLOCK TEST */
+/* Checks that the TSC was calibrated, that a millisecond worth	*/
+/* of cycles converts to a millisecond, and that the clock and	*/
+/* the gettime system call never run backwards.				   */
+/* Inputs: None. 											   */
+/* Outputs: PASS/FAIL										   */
+/* Side Effects: None.										   */
+/* Coverage: clock_init, clock_cycles_to_ns, syscall_gettime   */
+int clock_test( void )
+{
+	uint64_t ms;
+	uint64_t t0;
+	uint64_t t1;
+	int      i;
+	int      result = PASS;
+
+	printf( "TSC at %u kHz\n", tsc_khz );
+	if( tsc_khz == 0 )
+	{
+		return FAIL;
+	}
+
+	/* Rounding in the multiplier is far below 1 ppm.			*/
+	ms = clock_cycles_to_ns( tsc_khz );
+	if( ms < NS_PER_MS - 1000 || ms > NS_PER_MS + 1000 )
+	{
+		result = FAIL;
+	}
+
+	t0 = clock_ns( );
+	for( i = 0; i < 1000; i++ )
+	{
+		if( syscall_gettime( &t1 ) != 0 || t1 < t0 )
+		{
+			result = FAIL;
+			break;
+		}
+		t0 = t1;
+	}
+	if( syscall_gettime( NULL ) != -1 )
+	{
+		result = FAIL;
+	}
+
+	return result;
+}
+
+/* Tick each timer of timer_wheel_test ran at, and how often */
+#define TIMER_TEST_NUM 6
+static uint32_t timer_test_tick[ TIMER_TEST_NUM ];
+static uint32_t timer_test_runs[ TIMER_TEST_NUM ];
+
+static void timer_test_func( uint32_t i )
+{
+	timer_test_tick[ i ] = timer_jiffies - 1;
+	timer_test_runs[ i ]++;
+}
+
+/* TIMER WHEEL TEST */
+/* Sets timers that land on each level of the wheel and one	*/
+/* that is already due, cancels one, and moves one, then runs	*/
+/* the wheel a tick at a time. Every timer must run once, at	*/
+/* exactly its tick. This moves the wheel about 45 minutes	*/
+/* ahead, so it relies on launch_tests running without the PIT.*/
+/* Inputs: None. 											   */
+/* Outputs: PASS/FAIL										   */
+/* Side Effects: Advances timer_jiffies						   */
+/* Coverage: timer_add, timer_del, timer_advance, cascading    */
+int timer_wheel_test( void )
+{
+	ktimer_t timers[ TIMER_TEST_NUM ];
+	uint32_t base = timer_jiffies;
+	uint32_t expires[ TIMER_TEST_NUM ];
+	uint32_t t;
+	int      i;
+	int      result = PASS;
+
+	expires[ 0 ] = base - 5;			/* Already due				*/
+	expires[ 1 ] = base + 63;			/* Level 0					*/
+	expires[ 2 ] = base + 64;			/* Level 1					*/
+	expires[ 3 ] = base + 5000;			/* Level 2					*/
+	expires[ 4 ] = base + 270000;		/* Level 3					*/
+	expires[ 5 ] = base + 100;			/* Cancelled				*/
+	for( i = 0; i < TIMER_TEST_NUM; i++ )
+	{
+		timer_test_runs[ i ] = 0;
+		timer_init( &timers[ i ], timer_test_func, i );
+		timer_add( &timers[ i ], expires[ i ] );
+	}
+	expires[ 0 ] = base;
+	if( timer_del( &timers[ 5 ] ) != 1 || timer_pending( &timers[ 5 ] ) )
+	{
+		result = FAIL;
+	}
+
+	/* Moving a pending timer takes it out of its old slot.		*/
+	expires[ 3 ] = base + 4100;
+	timer_add( &timers[ 3 ], expires[ 3 ] );
+
+	for( t = base; t != base + 270001; t++ )
+	{
+		timer_advance( t );
+	}
+
+	for( i = 0; i < TIMER_TEST_NUM - 1; i++ )
+	{
+		if( timer_test_runs[ i ] != 1 || timer_test_tick[ i ] != expires[ i ] )
+		{
+			printf( "timer %d: ran %d times, at %d, due %d\n", i,
+					timer_test_runs[ i ], timer_test_tick[ i ], expires[ i ] );
+			result = FAIL;
+		}
+	}
+	if( timer_test_runs[ 5 ] != 0 )
+	{
+		result = FAIL;
+	}
+
+	return result;
+}
+
+/* STRING ROUTINES TEST */
+/* Compares strlen, strnlen, strncmp, strcpy and memmove with	*/
+/* plain byte loops, for every alignment of source and			*/
+/* destination and lengths around the word size, including		*/
+/* overlapping moves in both directions.						*/
+/* Inputs: None. 											   */
+/* Outputs: PASS/FAIL										   */
+/* Side Effects: None.										   */
+/* Coverage: lib.c string and memory routines				   */
+#define STR_TEST_LEN	40
+int string_routines_test( void )
+{
+	int8_t a[ STR_TEST_LEN + 8 ];
+	int8_t b[ STR_TEST_LEN + 8 ];
+	int8_t move[ 2 * STR_TEST_LEN ];
+	int8_t ref[ 2 * STR_TEST_LEN ];
+	int    off1, off2, len, i, d;
+	int    result = PASS;
+
+	for( off1 = 0; off1 < 4; off1++ )
+	{
+		for( off2 = 0; off2 < 4; off2++ )
+		{
+			for( len = 0; len < STR_TEST_LEN; len++ )
+			{
+				for( i = 0; i < len; i++ )
+					a[ off1 + i ] = 'a' + ( i % 26 );
+				a[ off1 + len ] = '\0';
+
+				if( strlen( &a[ off1 ] ) != len ||
+					strnlen( &a[ off1 ], len / 2 ) != len / 2 ||
+					strnlen( &a[ off1 ], len + 3 ) != len )
+					result = FAIL;
+
+				memset( b, 'x', sizeof( b ) );
+				strcpy( &b[ off2 ], &a[ off1 ] );
+				if( strncmp( &b[ off2 ], &a[ off1 ], len + 1 ) != 0 || b[ off2 + len + 1 ] != 'x' )
+					result = FAIL;
+
+				/* A difference in the last byte must be found. */
+				if( len > 0 )
+				{
+					b[ off2 + len - 1 ]++;
+					if( strncmp( &b[ off2 ], &a[ off1 ], len ) <= 0 ||
+						strncmp( &b[ off2 ], &a[ off1 ], len - 1 ) != 0 )
+						result = FAIL;
+				}
+
+				/* Overlapping moves, forwards and backwards. */
+				for( d = -5; d <= 5; d++ )
+				{
+					for( i = 0; i < 2 * STR_TEST_LEN; i++ )
+						move[ i ] = ref[ i ] = i;
+					for( i = 0; i < len; i++ )
+						ref[ 10 + off1 + d + i ] = 10 + off1 + i;
+					memmove( &move[ 10 + off1 + d ], &move[ 10 + off1 ], len );
+					for( i = 0; i < 2 * STR_TEST_LEN; i++ )
+						if( move[ i ] != ref[ i ] )
+							result = FAIL;
+				}
+			}
+		}
+	}
+
+	return result;
+}
+
+/* APIC IRQ TEST */
+/* With the APIC in use, checks that the 8259s stay masked and	*/
+/* that disable_irq / enable_irq reach the I/O APIC redirection	*/
+/* entry of the RTC, then puts the entry back as it was.		*/
+/* Inputs: None. 											   */
+/* Outputs: PASS/FAIL										   */
+/* Side Effects: Briefly masks the RTC IRQ					   */
+/* Coverage: apic_init, enable_irq, disable_irq				   */
+int apic_irq_test( void )
+{
+	TEST_HEADER;
+	uint32_t flags;
+	int32_t  was_masked;
+	int      result = PASS;
+
+	if( !apic_active )
+	{
+		printf( "\nAPIC not in use, IRQs on the 8259s\n" );
+		return PASS;
+	}
+	if( master_mask != MASK_ALL || slave_mask != MASK_ALL )
+	{
+		result = FAIL;
+	}
+
+	cli_and_save( flags );
+	was_masked = ioapic_irq_masked( RTC_IRQ_NUM );
+	disable_irq( RTC_IRQ_NUM );
+	if( !ioapic_irq_masked( RTC_IRQ_NUM ) )
+	{
+		result = FAIL;
+	}
+	enable_irq( RTC_IRQ_NUM );
+	if( ioapic_irq_masked( RTC_IRQ_NUM ) )
+	{
+		result = FAIL;
+	}
+	if( was_masked )
+	{
+		disable_irq( RTC_IRQ_NUM );
+	}
+	restore_flags( flags );
+
+	return result;
+}
+
+/* IRQSTAT TEST */
+/* Waits for a few RTC interrupts, checks that every interrupt	*/
+/* and handler run landed in exactly one histogram bucket, then	*/
+/* prints the report, read in small pieces like cat does.		*/
+/* Inputs: None. 											   */
+/* Outputs: PASS/FAIL										   */
+/* Side Effects: Prints the report							   */
+/* Coverage: irqstat_enter, irqstat_exit, irqstat_read_text	   */
+#define IRQSTAT_TEST_WAIT	100000000
+int irqstat_test( void )
+{
+	TEST_HEADER;
+	irqstat_t* stat = &irqstats[ RTC_IRQ_NUM ];
+	volatile uint32_t* count = &stat->count;
+	uint8_t    buf[ 64 ];
+	uint32_t   start, i, b, runs, gaps;
+	uint32_t   flags;
+	uint32_t   pos = 0;
+	int32_t    len;
+	int        result = PASS;
+
+	start = stat->count;
+	for( i = 0; i < IRQSTAT_TEST_WAIT && *count < start + 4; i++ ) {}
+	if( *count < start + 4 )
+	{
+		printf( "\nno RTC interrupts\n" );
+		return FAIL;
+	}
+
+	cli_and_save( flags );
+	runs = 0;
+	gaps = 0;
+	for( b = 0; b < IRQSTAT_BUCKETS; b++ )
+	{
+		runs += stat->run_hist[ b ];
+		gaps += stat->gap_hist[ b ];
+	}
+	if( runs != stat->exits || gaps != stat->count - 1 || stat->exits > stat->count )
+	{
+		result = FAIL;
+	}
+	restore_flags( flags );
+
+	printf( "\n" );
+	while( ( len = irqstat_read_text( &pos, buf, sizeof( buf ) - 1 ) ) > 0 )
+	{
+		buf[ len ] = '\0';
+		printf( "%s", (int8_t*)buf );
+	}
+
+	return result;
+}
+
+/* SIGNAL TEST */
+/* Checks that hw_context_t matches the offsets the linkage	*/
+/* uses and the layout the ECE391 handlers expect (EAX is the	*/
+/* seventh word above the signal number), that a context saved	*/
+/* in kernel mode is never redirected, and that bad signal		*/
+/* numbers are refused.											*/
+/* Inputs: None. 											   */
+/* Outputs: PASS/FAIL										   */
+/* Side Effects: None.										   */
+/* Coverage: signal_check, signal_raise, syscall_set_handler   */
+int signal_test( void )
+{
+	TEST_HEADER;
+	hw_context_t regs;
+	int result = PASS;
+
+	if( sizeof( hw_context_t ) != HW_CONTEXT_SIZE ||
+		(uint32_t)&( (hw_context_t*)0 )->eax != HW_CONTEXT_EAX ||
+		(uint32_t)&( (hw_context_t*)0 )->eax != 6 * sizeof( uint32_t ) ||
+		(uint32_t)&( (hw_context_t*)0 )->eip != 12 * sizeof( uint32_t ) )
+	{
+		printf( "\nhw_context_t layout is wrong\n" );
+		result = FAIL;
+	}
+
+	/* Nothing is delivered on a return to the kernel */
+	memset( &regs, 0, sizeof( regs ) );
+	regs.cs = KERNEL_CS;
+	regs.eip = 0x12345678;
+	regs.esp = 0x87654320;
+	signal_check( &regs );
+	if( regs.eip != 0x12345678 || regs.esp != 0x87654320 )
+	{
+		result = FAIL;
+	}
+
+	if( syscall_set_handler( -1, NULL ) != FAILURE ||
+		syscall_set_handler( NUM_SIGNALS, NULL ) != FAILURE ||
+		signal_has_handler( 0, NUM_SIGNALS ) ||
+		signal_has_handler( -1, SIG_ALARM ) )
+	{
+		result = FAIL;
+	}
+	signal_raise( MAX_NUM_PROGS + 1, SIG_INTERRUPT );
+
+	return result;
+}
+
 /* PAGING BOUNDS TEST */
 /* Tests the bounds of the  kernel and video memory pages      */
 /*  up correctly      										   */ 
@@ -1062,7 +1714,7 @@ int32_t terminal_write_NULL_test( void )
 	}
 
 	/* Also reset keyboard buffer to prevent printing issues	*/
-	reset_keyboard_buffer( );
+	reset_keyboard_buffer( display_terminal );
 	return PASS;
 }
 
@@ -1116,7 +1768,7 @@ int32_t terminal_write_size_test( void )
 	keyboard_putc( c );
 
 	/* Also reset keyboard buffer to prevent printing issues	*/
-	reset_keyboard_buffer( );
+	reset_keyboard_buffer( display_terminal );
 
 	/* Synchronize screen coordinates with terminal coordinates	*/
 	screen_y = terminal_y[ display_terminal ];
@@ -1128,6 +1780,199 @@ int32_t terminal_write_size_test( void )
 
 
 
+/* TERMINAL INPUT RING TEST */
+/* Types two lines with keyboard_putc before reading anything	*/
+/* and checks that both are read back, one line per read, in	*/
+/* order. Then checks that raw mode returns single keystrokes	*/
+/* without waiting for ENTER. Non-blocking mode is used 		*/
+/* throughout so a failure cannot hang the test.				*/
+/* Inputs: None.												*/
+/* Outputs: PASS/FAIL											*/
+/* Side Effects: Echoes the typed lines to the screen.			*/
+int32_t terminal_input_ring_test( void )
+{
+	uint8_t buf[ BUFFER_SIZE ];
+	int32_t result = PASS;
+	int i;
+
+	terminal_y[ display_terminal ] = screen_y;
+	terminal_x[ display_terminal ] = screen_x;
+
+	/* Throw away anything earlier tests typed.	*/
+	reset_keyboard_buffer( display_terminal );
+	syscall_termmode( TERM_MODE_RAW | TERM_MODE_NONBLOCK );
+	while( terminal_read( NULL, buf, BUFFER_SIZE ) > 0 ) {}
+
+	/* Nothing typed yet, so nothing to read.	*/
+	syscall_termmode( TERM_MODE_CANON | TERM_MODE_NONBLOCK );
+	if( terminal_read( NULL, buf, BUFFER_SIZE ) != 0 )
+	{
+		result = FAIL;
+	}
+
+	/* An unfinished line is not returned either.	*/
+	keyboard_putc( 'a' );
+	keyboard_putc( 'b' );
+	if( terminal_read( NULL, buf, BUFFER_SIZE ) != 0 )
+	{
+		result = FAIL;
+	}
+	keyboard_putc( '\n' );
+	keyboard_putc( 'c' );
+	keyboard_putc( '\n' );
+
+	/* Both lines come back, one per read.	*/
+	i = terminal_read( NULL, buf, BUFFER_SIZE );
+	if( i != 3 || buf[ 0 ] != 'a' || buf[ 1 ] != 'b' || buf[ 2 ] != '\n' )
+	{
+		result = FAIL;
+	}
+	i = terminal_read( NULL, buf, BUFFER_SIZE );
+	if( i != 2 || buf[ 0 ] != 'c' || buf[ 1 ] != '\n' )
+	{
+		result = FAIL;
+	}
+
+	/* Raw mode hands out keystrokes as they arrive.	*/
+	syscall_termmode( TERM_MODE_RAW | TERM_MODE_NONBLOCK );
+	keyboard_putc( 'x' );
+	keyboard_putc( 'y' );
+	i = terminal_read( NULL, buf, 1 );
+	if( i != 1 || buf[ 0 ] != 'x' )
+	{
+		result = FAIL;
+	}
+	i = terminal_read( NULL, buf, BUFFER_SIZE );
+	if( i != 1 || buf[ 0 ] != 'y' )
+	{
+		result = FAIL;
+	}
+
+	/* Unknown mode bits are rejected.	*/
+	if( syscall_termmode( 0x80 ) != -1 )
+	{
+		result = FAIL;
+	}
+
+	syscall_termmode( TERM_MODE_CANON );
+	screen_y = terminal_y[ display_terminal ];
+	screen_x = terminal_x[ display_terminal ];
+	return result;
+}
+
+/* TERMINAL ANSI TEST */
+/* Writes escape sequences with terminal_write and checks the	*/
+/* cursor and the cells of the screen they should have changed.	*/
+/* Inputs: None.												*/
+/* Outputs: PASS/FAIL											*/
+/* Side Effects: Clears the screen.								*/
+#define ANSI_TEST_CELL( row, col ) \
+	( terminal_video_base( display_terminal ) \
+	  + ( ( NUM_COLS * ( terminal_top[ display_terminal ] + ( row ) ) + ( col ) ) << 1 ) )
+int32_t terminal_ansi_test( void )
+{
+	int32_t result = PASS;
+	uint8_t move[] = "\033[2J\033[5;10HX\033[31mR\033[0m";
+	uint8_t erase[] = "\033[5;1H\033[KY\033[3A\033[2C";
+	uint8_t scroll[] = "\033[25;1H\033[44m\n\033[0m";
+	uint8_t home[] = "\033[H";
+
+	/* Clear, print X at row 5 column 10 and a red R after it.	*/
+	terminal_write( NULL, move, sizeof( move ) - 1 );
+	if( ANSI_TEST_CELL( 4, 9 )[ 0 ] != 'X' || ANSI_TEST_CELL( 4, 9 )[ 1 ] != ATTRIB )
+	{
+		result = FAIL;
+	}
+	if( ANSI_TEST_CELL( 4, 10 )[ 0 ] != 'R' || ANSI_TEST_CELL( 4, 10 )[ 1 ] != 0x04 )
+	{
+		result = FAIL;
+	}
+	if( terminal_y[ display_terminal ] != 4 || terminal_x[ display_terminal ] != 11 )
+	{
+		result = FAIL;
+	}
+
+	/* Erase the line and print Y at its start, then move the	*/
+	/* cursor up three rows and right two columns.				*/
+	terminal_write( NULL, erase, sizeof( erase ) - 1 );
+	if( ANSI_TEST_CELL( 4, 0 )[ 0 ] != 'Y' || ANSI_TEST_CELL( 4, 9 )[ 0 ] != ' ' )
+	{
+		result = FAIL;
+	}
+	if( terminal_y[ display_terminal ] != 1 || terminal_x[ display_terminal ] != 3 )
+	{
+		result = FAIL;
+	}
+
+	/* Scroll with a blue background set; the new bottom row	*/
+	/* takes the background too.								*/
+	terminal_write( NULL, scroll, sizeof( scroll ) - 1 );
+	if( ANSI_TEST_CELL( NUM_ROWS - 1, 0 )[ 0 ] != ' ' || ANSI_TEST_CELL( NUM_ROWS - 1, 0 )[ 1 ] != 0x17 )
+	{
+		result = FAIL;
+	}
+
+	/* A typed Esc must not swallow the echo of the next key.	*/
+	terminal_write( NULL, home, sizeof( home ) - 1 );
+	keyboard_putc( ESCAPE );
+	keyboard_putc( 'k' );
+	if( ANSI_TEST_CELL( 0, 0 )[ 0 ] != 'k' )
+	{
+		result = FAIL;
+	}
+	reset_keyboard_buffer( display_terminal );
+
+	clear_and_reset_screen( );
+	screen_x = 0;
+	screen_y = 0;
+	return result;
+}
+
+/* TERMINAL WRITE CELLS TEST */
+/* Writes two lines with terminal_write on a cleared screen and	*/
+/* checks the count it returns, the cells and the cursor. Then	*/
+/* checks that a NUL stops the write and is not counted.		*/
+/* Inputs: None.												*/
+/* Outputs: PASS/FAIL											*/
+/* Side Effects: Clears the screen.								*/
+int32_t terminal_write_cells_test( void )
+{
+	int32_t result = PASS;
+	uint8_t lines[] = "\033[2J\033[Hab\ncd";
+	uint8_t nul[] = "xy\0zz";
+
+	if( terminal_write( NULL, lines, sizeof( lines ) - 1 ) != sizeof( lines ) - 1 )
+	{
+		result = FAIL;
+	}
+	if( ANSI_TEST_CELL( 0, 0 )[ 0 ] != 'a' || ANSI_TEST_CELL( 0, 1 )[ 0 ] != 'b' ||
+		ANSI_TEST_CELL( 1, 0 )[ 0 ] != 'c' || ANSI_TEST_CELL( 1, 1 )[ 0 ] != 'd' ||
+		ANSI_TEST_CELL( 1, 1 )[ 1 ] != ATTRIB )
+	{
+		result = FAIL;
+	}
+	if( terminal_y[ display_terminal ] != 1 || terminal_x[ display_terminal ] != 2 )
+	{
+		result = FAIL;
+	}
+
+	/* Only "xy" is printed, right after "cd".					*/
+	if( terminal_write( NULL, nul, sizeof( nul ) - 1 ) != 2 )
+	{
+		result = FAIL;
+	}
+	if( ANSI_TEST_CELL( 1, 2 )[ 0 ] != 'x' || ANSI_TEST_CELL( 1, 3 )[ 0 ] != 'y' ||
+		ANSI_TEST_CELL( 1, 4 )[ 0 ] != ' ' )
+	{
+		result = FAIL;
+	}
+
+	clear_and_reset_screen( );
+	screen_x = 0;
+	screen_y = 0;
+	return result;
+}
+
 /* TERMINAL READ/WRITE TEST */
 /* Tests if the read and write functions of the terminal driver	*/
 /* work as expected. Test read and write by typing on the 		*/
@@ -1151,11 +1996,11 @@ int terminal_read_write_test( void )
 
 		/* Enable the terminal to read. Press ENTER to	*/
 		/* finish reading, and write to terminal. 		*/
-		i = terminal_read( NULL, buf, NULL );
+		i = terminal_read( NULL, buf, BUFFER_SIZE );
 
 		/* Write the contents of buf to the screen.		*/
 		/* Loop for the duration of this test. 			*/
-		i = terminal_write( NULL, buf, 128 );
+		i = terminal_write( NULL, buf, i );
 	}
 
 	/* If somehow we ever reach here, we have technically	*/
@@ -1241,6 +2086,53 @@ void rtc_change_freq_test( unsigned int test_rate )
 	}
 }
 
+/* rtc_virtual_test											*/
+/* Runs two RTC descriptors at 1024 Hz and 64 Hz and checks		*/
+/* that the fast one ticks 16 times for every tick of the slow	*/
+/* one, and that an invalid rate is refused.					*/
+/* Inputs:None										  			*/
+/* Outputs: PASS/FAIL 											*/
+/* Side Effects: Enables the RTC interrupt while it runs		*/
+int rtc_virtual_test( void ) {
+	TEST_HEADER;
+
+	uint32_t fast = 1024;
+	uint32_t slow = 64;
+	uint32_t bad = 3;
+	uint32_t fast_ticks;
+	uint32_t slow_ticks;
+	int i;
+	int result = PASS;
+
+	/* The fast timer is set up first, so it can only be ahead.	*/
+	if (rtc_write(2, &fast, 4) != 0 || rtc_write(3, &slow, 4) != 0){
+		result = FAIL;
+	}
+	if (rtc_write(3, &bad, 4) != -1){
+		result = FAIL;
+	}
+
+	enable_irq(RTC_IRQ_NUM);
+	for (i = 0; i < 4; i++){
+		rtc_read(3, NULL, 0);
+	}
+	disable_irq(RTC_IRQ_NUM);
+
+	fast_ticks = rtc_virtual_ticks(2);
+	slow_ticks = rtc_virtual_ticks(3);
+	printf("fast: %d ticks, slow: %d ticks\n", fast_ticks, slow_ticks);
+	if (slow_ticks < 4 || fast_ticks < 16 * slow_ticks || fast_ticks > 16 * (slow_ticks + 1)){
+		result = FAIL;
+	}
+
+	rtc_close(2);
+	rtc_close(3);
+	if (rtc_virtual_ticks(2) != 0){
+		result = FAIL;
+	}
+	return result;
+}
+
 /* rtc_open_test												*/
 /* Tests the open functionality of the rtc driver 				*/
 /* Inputs:None										  			*/
@@ -1709,3 +2601,432 @@ void syscall_call_test( void )
 
 /* Checkpoint 4 tests */
 /* Checkpoint 5 tests */
+
+/* STRING BENCHMARK												*/
+/* Times the lib.c string and memory routines at a few sizes	*/
+/* and prints bytes per TSC cycle for each, next to a plain		*/
+/* byte loop strlen for comparison.								*/
+/* Inputs: None.												*/
+/* Outputs: PASS												*/
+/* Side Effects: Prints the table to the screen					*/
+#define STR_BENCH_MAX	4096
+#define STR_BENCH_REPS	64
+enum { SB_MEMCPY, SB_MEMMOVE_FWD, SB_MEMMOVE_BACK, SB_STRLEN, SB_STRLEN_BYTES,
+	   SB_STRNCMP, SB_STRCPY, SB_NUM };
+static int8_t* const string_bench_names[ SB_NUM ] = {
+	"memcpy", "memmove fwd", "memmove back", "strlen", "strlen bytes", "strncmp", "strcpy"
+};
+
+/* printf has no field widths, so pad table cells by hand.		*/
+static void string_bench_cell( int8_t* text, uint32_t width, int left )
+{
+	uint32_t len = strlen( text );
+	if( left )
+		printf( "%s", text );
+	for( ; len < width; len++ )
+		putc( ' ' );
+	if( !left )
+		printf( "%s", text );
+}
+int string_benchmark( void )
+{
+	TEST_HEADER;
+	static int8_t src[ STR_BENCH_MAX + 8 ];
+	static int8_t dst[ STR_BENCH_MAX + 8 ];
+	static const uint32_t sizes[] = { 16, 256, STR_BENCH_MAX };
+	uint32_t s, r, n, len, centi;
+	uint64_t start;
+	uint32_t cycles;
+	int8_t   cell[ 16 ];
+	int      k;
+
+	printf( "\n" );
+	string_bench_cell( "bytes/cycle", 13, 1 );
+	for( s = 0; s < sizeof( sizes ) / sizeof( sizes[ 0 ] ); s++ )
+	{
+		snprintf( cell, sizeof( cell ), "%u", sizes[ s ] );
+		string_bench_cell( cell, 8, 0 );
+	}
+	printf( "\n" );
+
+	for( k = 0; k < SB_NUM; k++ )
+	{
+		string_bench_cell( string_bench_names[ k ], 13, 1 );
+		for( s = 0; s < sizeof( sizes ) / sizeof( sizes[ 0 ] ); s++ )
+		{
+			n = sizes[ s ];
+			memset( src, 'a', n );
+			src[ n ] = '\0';
+			len = 0;
+
+			start = rdtsc( );
+			for( r = 0; r < STR_BENCH_REPS; r++ )
+			{
+				switch( k )
+				{
+					case SB_MEMCPY:			memcpy( dst, src, n ); break;
+					case SB_MEMMOVE_FWD:	memmove( src, src + 4, n ); break;
+					case SB_MEMMOVE_BACK:	memmove( src + 4, src, n ); break;
+					case SB_STRLEN:			len += strlen( src ); break;
+					case SB_STRLEN_BYTES:	for( len = 0; src[ len ] != '\0'; len++ ); break;
+					case SB_STRNCMP:		len += strncmp( dst, src, n ); break;
+					case SB_STRCPY:			strcpy( dst, src ); break;
+				}
+			}
+			cycles = (uint32_t)( rdtsc( ) - start );
+			if( cycles == 0 )
+				cycles = 1;
+
+			centi = n * STR_BENCH_REPS * 100 / cycles;
+			snprintf( cell, sizeof( cell ), "%u.%s%u", centi / 100, ( centi % 100 < 10 ) ? "0" : "", centi % 100 );
+			string_bench_cell( cell, 8, 0 );
+		}
+		printf( "\n" );
+	}
+	return PASS;
+}
+
+/* IRQ CONTROLLER BENCHMARK									*/
+/* Times masking plus unmasking an IRQ and sending an EOI on	*/
+/* the 8259s and, when present, the APIC. With the APIC in use	*/
+/* the 8259s are masked at LINT0, so toggling their masks is	*/
+/* harmless. The EOIs are sent with nothing in service, which	*/
+/* both controllers ignore.										*/
+/* Inputs: None.												*/
+/* Outputs: PASS												*/
+/* Side Effects: Prints average cycles per operation			*/
+#define IRQ_BENCH_REPS	1000
+int irq_controller_benchmark( void )
+{
+	TEST_HEADER;
+	uint32_t flags;
+	uint32_t i;
+	uint64_t start;
+	uint32_t mask_cycles, eoi_cycles;
+	uint8_t  saved_master;
+	int32_t  was_masked;
+
+	/* Each pair leaves the keyboard IRQ unmasked; put back	*/
+	/* the mask it had before.									*/
+	cli_and_save( flags );
+	saved_master = master_mask;
+	was_masked = ioapic_irq_masked( KEYBOARD_IRQ_NUM );
+
+	start = rdtsc( );
+	for( i = 0; i < IRQ_BENCH_REPS; i++ )
+	{
+		i8259_disable_irq( KEYBOARD_IRQ_NUM );
+		i8259_enable_irq( KEYBOARD_IRQ_NUM );
+	}
+	mask_cycles = (uint32_t)( rdtsc( ) - start ) / IRQ_BENCH_REPS;
+	if( saved_master & ( 1 << KEYBOARD_IRQ_NUM ) )
+	{
+		i8259_disable_irq( KEYBOARD_IRQ_NUM );
+	}
+
+	start = rdtsc( );
+	for( i = 0; i < IRQ_BENCH_REPS; i++ )
+	{
+		i8259_send_eoi( RTC_IRQ_NUM );
+	}
+	eoi_cycles = (uint32_t)( rdtsc( ) - start ) / IRQ_BENCH_REPS;
+	printf( "\n8259: mask+unmask %u cycles, EOI %u cycles (slave IRQ)\n",
+			mask_cycles, eoi_cycles );
+
+	if( apic_active )
+	{
+		start = rdtsc( );
+		for( i = 0; i < IRQ_BENCH_REPS; i++ )
+		{
+			ioapic_disable_irq( KEYBOARD_IRQ_NUM );
+			ioapic_enable_irq( KEYBOARD_IRQ_NUM );
+		}
+		mask_cycles = (uint32_t)( rdtsc( ) - start ) / IRQ_BENCH_REPS;
+		if( was_masked )
+		{
+			ioapic_disable_irq( KEYBOARD_IRQ_NUM );
+		}
+
+		start = rdtsc( );
+		for( i = 0; i < IRQ_BENCH_REPS; i++ )
+		{
+			lapic_eoi( );
+		}
+		eoi_cycles = (uint32_t)( rdtsc( ) - start ) / IRQ_BENCH_REPS;
+		printf( "APIC: mask+unmask %u cycles, EOI %u cycles\n",
+				mask_cycles, eoi_cycles );
+	}
+
+	restore_flags( flags );
+	return PASS;
+}
+
+/* TERMINAL SCROLL BENCHMARK									*/
+/* Prints verylargetextwithverylongname.txt to the terminal		*/
+/* with terminal_write, like "cat" does, and reports the TSC	*/
+/* cycles it took in total and per line printed.				*/
+/* Inputs: None.												*/
+/* Outputs: PASS/FAIL											*/
+/* Side Effects: Prints the file and the timing to the screen	*/
+#define BENCH_FILE_MAX	16384
+int terminal_scroll_benchmark( void )
+{
+	TEST_HEADER;
+	static uint8_t bench_buf[ BENCH_FILE_MAX ];
+	dentry_t dentry;
+	uint32_t size, lines, i;
+	uint64_t start, end;
+	uint32_t cycles;
+
+	if( read_dentry_by_name( (uint8_t*)"verylargetextwithverylongname.tx", &dentry ) == -1 )
+		return FAIL;
+	size = get_file_size( dentry.index_node_num );
+	if( size > BENCH_FILE_MAX )
+		size = BENCH_FILE_MAX;
+	if( read_data( dentry.index_node_num, 0, bench_buf, size ) <= 0 )
+		return FAIL;
+
+	lines = 0;
+	for( i = 0; i < size; i++ )
+		if( bench_buf[ i ] == '\n' )
+			lines++;
+	if( lines == 0 )
+		lines = 1;
+
+	start = rdtsc( );
+	terminal_write( 1, bench_buf, size );
+	end = rdtsc( );
+
+	cycles = (uint32_t)( end - start );
+	printf( "\n%u bytes, %u lines: %u cycles, %u cycles/line\n",
+			size, lines, cycles, cycles / lines );
+	return PASS;
+}
+
+/* //////////////////////////////////////////////////////////// */
+/* ---------------------- BENCHMARK SUITE --------------------- */
+/* //////////////////////////////////////////////////////////// */
+
+/* Every result is one line on the screen and on COM1:			*/
+/*     [BENCH] <metric> <integer> <unit>						*/
+/* Metric names and units do not change between builds, so the	*/
+/* output of "qemu -serial stdio" can be grepped for "[BENCH]"	*/
+/* and compared against a saved baseline. Rates need the TSC	*/
+/* frequency, which is printed first; without it only cycle	*/
+/* counts are given.											*/
+#define BENCH_SYSCALL_REPS	10000
+#define BENCH_EXEC_REPS		16
+#define BENCH_READ_REPS		64
+#define BENCH_WRITE_CHARS	1600		/* 20 full lines, no scrolling	*/
+#define BENCH_WRITE_REPS	8
+#define BENCH_SCROLL_LINES	200
+#define BENCH_SWITCH_REPS	100
+#define BENCH_IRQ_REPS		10000
+#define BENCH_EXEC_FILE		"hello"
+
+static void bench_output( int8_t* metric, uint32_t value, int8_t* unit )
+{
+	int8_t line[ 80 ];
+	int32_t len;
+
+	len = snprintf( line, sizeof( line ), "[BENCH] %s %u %s\n", metric, value, unit );
+	printf( "%s", line );
+	serial_write_buf( (uint8_t*)line, len );
+}
+
+/* Units per second for units done in cycles, 0 without a TSC	*/
+/* frequency. Both are scaled down until the divide fits.		*/
+static uint32_t bench_rate( uint32_t units, uint64_t cycles )
+{
+	uint64_t n = (uint64_t)units * tsc_khz * 1000;
+
+	while( cycles >> 32 )
+	{
+		cycles >>= 1;
+		n >>= 1;
+	}
+	if( cycles == 0 || tsc_khz == 0 || ( n >> 32 ) >= cycles )
+		return 0;
+	return div64_32( n, (uint32_t)cycles );
+}
+
+/* Average cycles per operation, saturating at 32 bits			*/
+static uint32_t bench_per_op( uint64_t cycles, uint32_t ops )
+{
+	if( ops == 0 || ( cycles >> 32 ) >= ops )
+		return 0xFFFFFFFF;
+	return div64_32( cycles, ops );
+}
+
+/* An invalid call number, so only the int $0x80 entry and the	*/
+/* iret are timed. From ring 0 there is no stack switch, so a	*/
+/* call from user mode costs somewhat more.						*/
+static void bench_syscall( void )
+{
+	uint64_t start;
+	uint32_t i;
+	int32_t  ret;
+
+	start = rdtsc( );
+	for( i = 0; i < BENCH_SYSCALL_REPS; i++ )
+		asm volatile( "int $0x80" : "=a" ( ret ) : "a" ( 0 ) : "memory", "cc" );
+	bench_output( "syscall_null", bench_per_op( rdtsc( ) - start, BENCH_SYSCALL_REPS ), "cycles/op" );
+}
+
+/* The kernel side of an execute/halt pair: PCB, kernel stack,	*/
+/* 4MB user frame and page directory, loading the program		*/
+/* image, and giving it all back. The two privilege switches	*/
+/* are left out, since halting the only process from here		*/
+/* would start a shell; execbench times the whole round trip.	*/
+static void bench_exec( void )
+{
+	dentry_t dentry;
+	uint64_t start;
+	uint32_t size, i;
+	uint32_t stack, page, dir;
+	void*    pcb;
+
+	if( read_dentry_by_name( (uint8_t*)BENCH_EXEC_FILE, &dentry ) == -1 )
+		return;
+	size = get_file_size( dentry.index_node_num );
+
+	start = rdtsc( );
+	for( i = 0; i < BENCH_EXEC_REPS; i++ )
+	{
+		pcb = kmalloc( sizeof( pcb_t ) );
+		stack = frame_alloc_contig( EIGHT_KB / FRAME_SIZE, EIGHT_KB / FRAME_SIZE );
+		page = frame_alloc_contig( FRAMES_PER_4MB, FRAMES_PER_4MB );
+		dir = frame_alloc( );
+		if( pcb == NULL || stack == 0 || page == 0 || dir == 0 )
+		{
+			printf( "bench_exec: out of memory\n" );
+			return;
+		}
+		page_directory_init( (page_directory_entry_t*)dir, page );
+		read_data( dentry.index_node_num, 0, (uint8_t*)( page + PROG_IMG_START - USER_START_ADDR ), size );
+
+		frame_free( dir );
+		frame_free_contig( page, FRAMES_PER_4MB );
+		frame_free_contig( stack, EIGHT_KB / FRAME_SIZE );
+		kfree( pcb );
+	}
+	bench_output( "exec_setup", bench_per_op( rdtsc( ) - start, BENCH_EXEC_REPS ), "cycles/op" );
+}
+
+/* Reads the largest regular file whole, again and again		*/
+static void bench_read_data( void )
+{
+	static uint8_t buf[ BENCH_FILE_MAX ];
+	dentry_t dentry;
+	uint32_t inode = 0;
+	uint32_t size = 0;
+	uint32_t i;
+	uint64_t start, cycles;
+
+	for( i = 0; i < p_boot_block_addr->num_dir_entries && read_dentry_by_index( i, &dentry ) == 0; i++ )
+	{
+		if( dentry.file_type == REG_FILE_TYPE && get_file_size( dentry.index_node_num ) > size )
+		{
+			inode = dentry.index_node_num;
+			size = get_file_size( inode );
+		}
+	}
+	if( size > BENCH_FILE_MAX )
+		size = BENCH_FILE_MAX;
+	if( size == 0 )
+		return;
+
+	start = rdtsc( );
+	for( i = 0; i < BENCH_READ_REPS; i++ )
+		read_data( inode, 0, buf, size );
+	cycles = rdtsc( ) - start;
+
+	bench_output( "read_data", bench_per_op( cycles, size * BENCH_READ_REPS / 1024 ), "cycles/KB" );
+	bench_output( "read_data", bench_rate( size * BENCH_READ_REPS / 1024, cycles ) / 1024, "MB/s" );
+}
+
+/* Characters that fit on a cleared screen, then whole lines	*/
+/* written below the last row, each of which scrolls it.		*/
+static void bench_terminal( void )
+{
+	static uint8_t buf[ BENCH_WRITE_CHARS ];
+	uint64_t start, cycles, scroll;
+	uint32_t i;
+
+	memset( buf, 'x', BENCH_WRITE_CHARS );
+	cycles = 0;
+	for( i = 0; i < BENCH_WRITE_REPS; i++ )
+	{
+		clear_and_reset_screen( );
+		start = rdtsc( );
+		terminal_write( 1, buf, BENCH_WRITE_CHARS );
+		cycles += rdtsc( ) - start;
+	}
+
+	memset( buf, '\n', BENCH_SCROLL_LINES );
+	terminal_write( 1, buf, NUM_ROWS );
+	start = rdtsc( );
+	terminal_write( 1, buf, BENCH_SCROLL_LINES );
+	scroll = rdtsc( ) - start;
+
+	clear_and_reset_screen( );
+	bench_output( "terminal_write", bench_per_op( cycles, BENCH_WRITE_CHARS * BENCH_WRITE_REPS ), "cycles/char" );
+	bench_output( "terminal_write", bench_rate( BENCH_WRITE_CHARS * BENCH_WRITE_REPS, cycles ), "chars/s" );
+	bench_output( "scroll", bench_per_op( scroll, BENCH_SCROLL_LINES ), "cycles/line" );
+}
+
+/* Switches to terminal 1 and back							*/
+static void bench_switch( void )
+{
+	uint64_t start;
+	uint32_t i;
+	uint32_t home = display_terminal;
+
+	switch_terminal( 0 );
+	start = rdtsc( );
+	for( i = 0; i < BENCH_SWITCH_REPS; i++ )
+	{
+		switch_terminal( 1 );
+		switch_terminal( 0 );
+	}
+	bench_output( "terminal_switch", bench_per_op( rdtsc( ) - start, 2 * BENCH_SWITCH_REPS ), "cycles/op" );
+	switch_terminal( home );
+}
+
+/* Raises the spurious vector in software. Its linkage is the	*/
+/* one every IRQ goes through (context save, irqstat, deferred	*/
+/* work, signal check) around an empty handler with no EOI.	*/
+/* Its irqstat counters are put back afterwards.				*/
+static void bench_irq( void )
+{
+	static irqstat_t saved;
+	uint64_t start;
+	uint32_t i;
+	uint32_t flags;
+
+	cli_and_save( flags );
+	memcpy( &saved, &irqstats[ IRQSTAT_SPURIOUS ], sizeof( saved ) );
+	start = rdtsc( );
+	for( i = 0; i < BENCH_IRQ_REPS; i++ )
+		asm volatile( "int %0" : : "i" ( SPURIOUS_VECTOR ) : "memory", "cc" );
+	bench_output( "irq_entry", bench_per_op( rdtsc( ) - start, BENCH_IRQ_REPS ), "cycles/irq" );
+	memcpy( &irqstats[ IRQSTAT_SPURIOUS ], &saved, sizeof( saved ) );
+	restore_flags( flags );
+}
+
+/* BENCHMARK SUITE												*/
+/* Runs every benchmark once, in a fixed order. The terminal	*/
+/* ones go first since they clear the screen.					*/
+/* Inputs: None.												*/
+/* Outputs: None.												*/
+/* Side Effects: Prints [BENCH] lines, clears the screen		*/
+void run_benchmarks( void )
+{
+	bench_terminal( );
+	bench_output( "tsc", tsc_khz, "kHz" );
+	bench_syscall( );
+	bench_exec( );
+	bench_read_data( );
+	bench_irq( );
+	bench_switch( );
+}
@@ -93,6 +93,36 @@ int rtc_init_test( void );
 /*  up correctly      										   */ 
 int paging_init_test( void );
 
+/* Allocates and frees page frames, checking their alignment */
+int frame_alloc_test( void );
+
+/* Allocates and frees kernel objects and prints cache statistics */
+int kmalloc_test( void );
+
+/* Logs kernel messages and reads them back */
+int klog_test( void );
+
+/* Writes to the COM1 serial port */
+int serial_test( void );
+
+/* Checks the TSC calibrated clock */
+int clock_test( void );
+
+/* Runs timers through every level of the timer wheel */
+int timer_wheel_test( void );
+
+/* Checks the string routines against byte loops */
+int string_routines_test( void );
+
+/* Checks IRQ masking through the I/O APIC */
+int apic_irq_test( void );
+
+/* Checks the per-IRQ histograms and prints them */
+int irqstat_test( void );
+
+/* Checks the signal frame layout and argument checks */
+int signal_test( void );
+
 /* Tests the bounds of the  kernel and video memory pages, */
 /* Should page fault for each case since we are testing    */
 /* upper and lower out-of-bounds cases                     */
@@ -165,6 +195,16 @@ int32_t terminal_write_NULL_test( void );
 /* the argument. 												*/
 int32_t terminal_write_size_test( void );
 
+/* Tests that typed lines are queued and read back one at a	*/
+/* time, and that raw mode returns single keystrokes.			*/
+int32_t terminal_input_ring_test( void );
+
+/* Tests the ANSI escape sequences understood by terminal_write	*/
+int32_t terminal_ansi_test( void );
+
+/* Checks terminal_write's count and the cells it prints to	*/
+int32_t terminal_write_cells_test( void );
+
 /* Tests if the read and write functions of the terminal driver	*/
 /* work as expected. Test read and write by typing on the 		*/
 /* keyboard and hitting ENTER. The characters typed should be 	*/
@@ -183,7 +223,23 @@ int rtc_close_test( void );
 /* then tests read                                              */
 int rtc_read_write_test( void );
 
+/* Runs two RTC descriptors at different virtual rates          */
+int rtc_virtual_test( void );
+
 void syscall_call_test( void );
 
 
+/* Times printing the large text file to the terminal */
+int terminal_scroll_benchmark( void );
+
+/* Prints bytes per cycle of the string and memory routines */
+int string_benchmark( void );
+
+/* Prints the cost of masking and EOI on the 8259s and the APIC */
+int irq_controller_benchmark( void );
+
+/* Benchmark suite, run instead of the tests with RUN_BENCHMARKS. */
+/* Prints one "[BENCH] <metric> <integer> <unit>" line per result */
+void run_benchmarks( void );
+
 #endif /* _TESTS_H */
@@ -0,0 +1,340 @@
+#include "timer.h"
+#include "lib.h"
+#include "scheduling.h"
+#include "syscall.h"
+#include "signal.h"
+
+/* The wheel. Each slot is a circular list with the     */
+/* slot's own entry as its head. Only touched with      */
+/* interrupts disabled.                                 */
+static ktimer_t timer_wheel[ TIMER_LEVELS ][ TIMER_SLOTS ];
+
+/* Next tick to run. Timers due at or before it go into */
+/* its level 0 slot.                                    */
+volatile uint32_t timer_jiffies = 0;
+
+/* Index of tick t in the slots of a level */
+#define TIMER_INDEX( t, level ) \
+    ( ( ( t ) >> ( ( level ) * TIMER_SLOT_BITS ) ) & TIMER_SLOT_MASK )
+
+/* Converts milliseconds to ticks, rounding up */
+#define MS_TO_TICKS( ms )   ( ( ( ms ) + TIMER_MS_PER_TICK - 1 ) / TIMER_MS_PER_TICK )
+
+/* ------------------- timer_wheel_init --------------- */
+/* Inputs:          None.                               */
+/* Outputs:         None.                               */
+/* Side Effects:    Empties every slot and starts the   */
+/*                  wheel at the current PIT tick.      */
+void timer_wheel_init( void )
+{
+    int32_t level;
+    int32_t slot;
+
+    for( level = 0; level < TIMER_LEVELS; level++ )
+    {
+        for( slot = 0; slot < TIMER_SLOTS; slot++ )
+        {
+            timer_wheel[ level ][ slot ].next = &timer_wheel[ level ][ slot ];
+            timer_wheel[ level ][ slot ].prev = &timer_wheel[ level ][ slot ];
+        }
+    }
+    timer_jiffies = sched_ticks;
+}
+
+/* ---------------------- timer_init ------------------ */
+/* Inputs:          timer -> timer to set up            */
+/*                  func  -> function to run            */
+/*                  arg   -> its argument               */
+void timer_init( ktimer_t* timer, timer_func_t func, uint32_t arg )
+{
+    timer->next = NULL;
+    timer->prev = NULL;
+    timer->expires = 0;
+    timer->func = func;
+    timer->arg = arg;
+}
+
+/* ---------------------- timer_link ------------------ */
+/* Puts a timer into the slot for its expiry time: the  */
+/* lowest level whose slots still reach that far.       */
+/* Timers that are already due go into the slot of the  */
+/* next tick. Interrupts must be disabled.              */
+static void timer_link( ktimer_t* timer )
+{
+    uint32_t delta = timer->expires - timer_jiffies;
+    int32_t  level = 0;
+    ktimer_t* head;
+
+    if( (int32_t)delta < 0 )
+    {
+        timer->expires = timer_jiffies;
+        delta = 0;
+    }
+    else if( delta > TIMER_MAX_DELTA )
+    {
+        timer->expires = timer_jiffies + TIMER_MAX_DELTA;
+        delta = TIMER_MAX_DELTA;
+    }
+
+    while( level < TIMER_LEVELS - 1 && delta >= ( 1U << ( ( level + 1 ) * TIMER_SLOT_BITS ) ) )
+    {
+        level++;
+    }
+
+    head = &timer_wheel[ level ][ TIMER_INDEX( timer->expires, level ) ];
+    timer->next = head;
+    timer->prev = head->prev;
+    head->prev->next = timer;
+    head->prev = timer;
+}
+
+/* --------------------- timer_unlink ----------------- */
+/* Takes a timer out of its slot. Interrupts must be    */
+/* disabled.                                            */
+static void timer_unlink( ktimer_t* timer )
+{
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->next = NULL;
+    timer->prev = NULL;
+}
+
+/* ---------------------- timer_add ------------------- */
+/* Inputs:          timer   -> an initialized timer     */
+/*                  expires -> PIT tick to run it at    */
+/* Outputs:         None.                               */
+/* Side Effects:    Moves the timer if it was pending.  */
+void timer_add( ktimer_t* timer, uint32_t expires )
+{
+    uint32_t flags;
+
+    cli_and_save( flags );
+    if( timer->next != NULL )
+    {
+        timer_unlink( timer );
+    }
+    timer->expires = expires;
+    timer_link( timer );
+    restore_flags( flags );
+}
+
+/* ---------------------- timer_del ------------------- */
+/* Inputs:          timer -> an initialized timer       */
+/* Outputs:         1 if it was pending, else 0.        */
+int32_t timer_del( ktimer_t* timer )
+{
+    uint32_t flags;
+    int32_t  was_pending = 0;
+
+    cli_and_save( flags );
+    if( timer->next != NULL )
+    {
+        timer_unlink( timer );
+        was_pending = 1;
+    }
+    restore_flags( flags );
+    return was_pending;
+}
+
+/* -------------------- timer_pending ----------------- */
+int32_t timer_pending( const ktimer_t* timer )
+{
+    return timer->next != NULL;
+}
+
+/* --------------------- timer_cascade ---------------- */
+/* Moves the timers of one slot of a higher level down  */
+/* to the levels below. Interrupts must be disabled.    */
+/* Outputs:         The index of the slot.              */
+static int32_t timer_cascade( int32_t level )
+{
+    int32_t   index = TIMER_INDEX( timer_jiffies, level );
+    ktimer_t* head = &timer_wheel[ level ][ index ];
+    ktimer_t* timer;
+
+    while( head->next != head )
+    {
+        timer = head->next;
+        timer_unlink( timer );
+        timer_link( timer );
+    }
+    return index;
+}
+
+/* --------------------- timer_advance ---------------- */
+/* Runs the wheel up to and including tick now. Called  */
+/* by the PIT handler with interrupts disabled. The     */
+/* slot being run is taken off the wheel first, and the */
+/* wheel moves on before the timers run, so a timer     */
+/* that re-adds itself goes into a later slot.          */
+/* Inputs:          now -> current PIT tick             */
+/* Outputs:         None.                               */
+/* Side Effects:    Calls the functions of the timers.  */
+void timer_advance( uint32_t now )
+{
+    ktimer_t  work;
+    ktimer_t* head;
+    ktimer_t* timer;
+    int32_t   level;
+
+    while( (int32_t)( now - timer_jiffies ) >= 0 )
+    {
+        /* Every time the index of a level wraps to 0,  */
+        /* the next slot of the level above is due.     */
+        level = 0;
+        while( level < TIMER_LEVELS - 1 && TIMER_INDEX( timer_jiffies, level ) == 0 )
+        {
+            level++;
+            if( timer_cascade( level ) != 0 )
+            {
+                break;
+            }
+        }
+
+        head = &timer_wheel[ 0 ][ TIMER_INDEX( timer_jiffies, 0 ) ];
+        timer_jiffies++;
+        if( head->next == head )
+        {
+            continue;
+        }
+
+        /* Move the whole slot onto a local list.       */
+        work.next = head->next;
+        work.prev = head->prev;
+        work.next->prev = &work;
+        work.prev->next = &work;
+        head->next = head;
+        head->prev = head;
+
+        while( work.next != &work )
+        {
+            timer = work.next;
+            timer_unlink( timer );
+            timer->func( timer->arg );
+        }
+    }
+}
+
+/* --------------------- sleep_expired ---------------- */
+/* Ends the sleep of a process.                         */
+static void sleep_expired( uint32_t pid )
+{
+    get_pcb( pid )->sleep_done = 1;
+    sched_wake_pid( pid, WAIT_TIMER );
+}
+
+/* --------------------- alarm_expired ---------------- */
+/* Raises SIG_ALARM for a process. signal_raise wakes  */
+/* it from whatever it waits on, which ends a sleep.    */
+static void alarm_expired( uint32_t pid )
+{
+    signal_raise( pid, SIG_ALARM );
+}
+
+/* ------------------ timer_process_init -------------- */
+/* Inputs:          pid -> the new process              */
+void timer_process_init( int32_t pid )
+{
+    pcb_t* pcb = get_pcb( pid );
+
+    timer_init( &pcb->sleep_timer, sleep_expired, pid );
+    timer_init( &pcb->alarm_timer, alarm_expired, pid );
+    pcb->sleep_done = 0;
+    pcb->pending_signals = 0;
+}
+
+/* ------------------ timer_process_exit -------------- */
+/* Inputs:          pid -> the halting process          */
+/* Side Effects:    Its timers will not run.            */
+void timer_process_exit( int32_t pid )
+{
+    pcb_t* pcb = get_pcb( pid );
+
+    timer_del( &pcb->sleep_timer );
+    timer_del( &pcb->alarm_timer );
+}
+
+/* --------------------- syscall_sleep ---------------- */
+/* Blocks the caller for at least ms milliseconds. A    */
+/* pending alarm or SIG_INTERRUPT ends the sleep early. */
+/* The alarm is consumed unless the process has a       */
+/* handler to deliver it to.                            */
+/* Inputs:          ms -> time to sleep                 */
+/* Outputs:         0, or the milliseconds left if a    */
+/*                  signal cut the sleep short. -1 when */
+/*                  called outside a process.           */
+/* Side Effects:    Blocks on WAIT_TIMER.               */
+int32_t syscall_sleep( uint32_t ms )
+{
+    pcb_t*   pcb;
+    uint32_t flags;
+    uint32_t left;
+
+    if( curr_pid < 0 )
+    {
+        return -1;
+    }
+    if( ms == 0 )
+    {
+        return 0;
+    }
+    pcb = get_pcb( curr_pid );
+
+    /* The current tick is already partly over, so wait */
+    /* one more to sleep at least ms.                   */
+    pcb->sleep_done = 0;
+    timer_add( &pcb->sleep_timer, sched_ticks + MS_TO_TICKS( ms ) + 1 );
+
+    sched_wait_event( WAIT_TIMER, pcb->sleep_done || ( pcb->pending_signals & ( 1 << SIG_ALARM ) ) ||
+                                  signal_interrupted( ) );
+
+    cli_and_save( flags );
+    left = 0;
+    if( !pcb->sleep_done )
+    {
+        if( pcb->signal_handlers[ SIG_ALARM ] == NULL )
+        {
+            pcb->pending_signals &= ~( 1 << SIG_ALARM );
+        }
+        left = ( pcb->sleep_timer.expires - sched_ticks ) * TIMER_MS_PER_TICK;
+        timer_del( &pcb->sleep_timer );
+    }
+    restore_flags( flags );
+
+    return left;
+}
+
+/* --------------------- syscall_alarm ---------------- */
+/* Arms the one-shot alarm of the caller, replacing any */
+/* earlier one. When it goes off SIG_ALARM is raised    */
+/* for the process, which wakes it from sleep.          */
+/* Inputs:          ms -> time until the alarm, 0 only  */
+/*                        cancels the current one       */
+/* Outputs:         Milliseconds that were left on the  */
+/*                  previous alarm, 0 if there was none.*/
+/*                  -1 when called outside a process.   */
+int32_t syscall_alarm( uint32_t ms )
+{
+    pcb_t*   pcb;
+    uint32_t flags;
+    uint32_t left = 0;
+
+    if( curr_pid < 0 )
+    {
+        return -1;
+    }
+    pcb = get_pcb( curr_pid );
+
+    cli_and_save( flags );
+    if( timer_del( &pcb->alarm_timer ) )
+    {
+        left = ( pcb->alarm_timer.expires - sched_ticks ) * TIMER_MS_PER_TICK;
+    }
+    if( ms != 0 )
+    {
+        timer_add( &pcb->alarm_timer, sched_ticks + MS_TO_TICKS( ms ) );
+    }
+    restore_flags( flags );
+
+    return left;
+}
@@ -0,0 +1,69 @@
+#ifndef _TIMER_H
+#define _TIMER_H
+
+#include "types.h"
+#include "scheduling.h"
+
+/* Kernel timers, driven by the SCHED_HZ PIT tick. The  */
+/* pending timers are kept in a hierarchical timing     */
+/* wheel: level 0 has one slot per tick for the next 64 */
+/* ticks, and every higher level has slots 64 times as  */
+/* wide. Adding or removing a timer only links it into  */
+/* or out of one slot. Each tick runs one level 0 slot, */
+/* and every 64 ticks the next slot of the level above  */
+/* is spread over the level below, so the cost of a     */
+/* tick does not depend on how many timers are pending. */
+
+#define TIMER_LEVELS        4
+#define TIMER_SLOT_BITS     6
+#define TIMER_SLOTS         ( 1 << TIMER_SLOT_BITS )
+#define TIMER_SLOT_MASK     ( TIMER_SLOTS - 1 )
+/* Farthest a timer can be set, about 46 hours; later   */
+/* expiry times are cut down to it.                     */
+#define TIMER_MAX_DELTA     ( ( 1 << ( TIMER_LEVELS * TIMER_SLOT_BITS ) ) - 1 )
+
+#define TIMER_MS_PER_TICK   ( 1000 / SCHED_HZ )
+
+typedef void ( *timer_func_t )( uint32_t arg );
+
+typedef struct ktimer_t {
+    struct ktimer_t* next;                  /* Links in the slot list, NULL */
+    struct ktimer_t* prev;                  /* while not pending            */
+    uint32_t         expires;               /* Tick to run at               */
+    timer_func_t     func;                  /* Called from the PIT handler, */
+    uint32_t         arg;                   /* with interrupts off          */
+} ktimer_t;
+
+/* Ticks the wheel has run up to */
+extern volatile uint32_t timer_jiffies;
+
+/* Sets up the empty wheel */
+extern void timer_wheel_init( void );
+
+/* Prepares a timer that is not pending */
+extern void timer_init( ktimer_t* timer, timer_func_t func, uint32_t arg );
+
+/* (Re)arms a timer to run at tick expires */
+extern void timer_add( ktimer_t* timer, uint32_t expires );
+
+/* Disarms a timer. Returns 1 if it was pending */
+extern int32_t timer_del( ktimer_t* timer );
+
+/* Non-zero while a timer is waiting to run */
+extern int32_t timer_pending( const ktimer_t* timer );
+
+/* Runs the timers that expired up to tick now */
+extern void timer_advance( uint32_t now );
+
+/* Sets up the sleep and alarm timers of a new process */
+extern void timer_process_init( int32_t pid );
+
+/* Cancels the timers of a halting process */
+extern void timer_process_exit( int32_t pid );
+
+/* System calls: blocks for ms milliseconds, and sets a */
+/* one-shot alarm ms milliseconds from now.             */
+extern int32_t syscall_sleep( uint32_t ms );
+extern int32_t syscall_alarm( uint32_t ms );
+
+#endif /* _TIMER_H */
@@ -23,7 +23,7 @@ int main ()
 	    ece391_fdputs (1, (uint8_t*)"file read failed\n");
 	    return 3;
 	}
-	if (-1 == ece391_write (1, buf, cnt))
+	if (-1 == ece391_fdwrite (1, buf, cnt))
 	    return 3;
     }
 
@@ -11,7 +11,7 @@ int main ()
     uint8_t buf[BUFSIZE];
 
     ece391_fdputs(1, (uint8_t*)"Enter the Test Number: (0): 100, (1): 10000, (2): 100000\n");
-    if (-1 == (cnt = ece391_read(0, buf, BUFSIZE-1)) ) {
+    if (-1 == (cnt = ece391_fdread(0, buf, BUFSIZE-1)) ) {
         ece391_fdputs(1, (uint8_t*)"Can't read the number from keyboard.\n");
      return 3;
     }
@@ -34,6 +34,8 @@ int main ()
         }
     }
 
+    /* Fill whole buffers rather than writing every line */
+    ece391_setbuf(1, ECE391_IOFBF);
     for (i = 0; i < max; i++) {
         ece391_itoa(i+1, buf, 10);
         ece391_fdputs(1, buf);
@@ -41,11 +41,12 @@ asm volatile ("                    \
 ")
 
 /* these wrappers require no changes */
+extern int32_t __ece391_halt (uint8_t status);
 extern int32_t __ece391_read (int32_t fd, void* buf, int32_t nbytes);
 extern int32_t __ece391_write (int32_t fd, const void* buf, int32_t nbytes);
 extern int32_t __ece391_close (int32_t fd);
 void fake_function () {
-DO_CALL(ece391_halt,1 /* SYS_HALT */);
+DO_CALL(__ece391_halt,1 /* SYS_HALT */);
 DO_CALL(__ece391_read,3 /* SYS_READ */);
 DO_CALL(__ece391_write,4 /* SYS_WRITE */);
 DO_CALL(__ece391_close,6 /* SYS_CLOSE */);
@@ -64,8 +65,8 @@ _start:                                 \n\
 /* end of fake container function */
 }
 
-int32_t 
-ece391_execute (const uint8_t* command)
+static int32_t 
+emu_execute (const uint8_t* command)
 {
     int status;
     uint8_t buf[1026];
@@ -110,8 +111,8 @@ ece391_execute (const uint8_t* command)
     return 256;
 }
 
-int32_t 
-ece391_open (const uint8_t* filename)
+static int32_t 
+emu_open (const uint8_t* filename)
 {
     uint32_t rval;
 
@@ -128,8 +129,8 @@ ece391_open (const uint8_t* filename)
     return rval;
 }
 
-int32_t 
-ece391_getargs (uint8_t* buf, int32_t nbytes)
+static int32_t 
+emu_getargs (uint8_t* buf, int32_t nbytes)
 {
     int32_t argc = *(uint32_t*)start_esp;
     uint8_t** argv = (uint8_t**)(start_esp + 4);
@@ -156,8 +157,8 @@ ece391_getargs (uint8_t* buf, int32_t nbytes)
     return 0;
 }
 
-int32_t 
-ece391_vidmap (uint8_t** screen_start)
+static int32_t 
+emu_vidmap (uint8_t** screen_start)
 {
     static int mem_fd = -1;
     void* mem_image;
@@ -176,8 +177,8 @@ ece391_vidmap (uint8_t** screen_start)
     return 0;
 }
 
-int32_t 
-ece391_read (int32_t fd, void* buf, int32_t nbytes)
+static int32_t 
+emu_read (int32_t fd, void* buf, int32_t nbytes)
 {
     struct dirent* de;
     int32_t copied;
@@ -205,16 +206,16 @@ ece391_read (int32_t fd, void* buf, int32_t nbytes)
     return copied;
 }
 
-int32_t 
-ece391_write (int32_t fd, const void* buf, int32_t nbytes)
+static int32_t 
+emu_write (int32_t fd, const void* buf, int32_t nbytes)
 {
     if (NULL == dir || dir_fd != fd)
         return __ece391_write (fd, buf, nbytes);
     return -1;
 }
 
-int32_t 
-ece391_close (int32_t fd)
+static int32_t 
+emu_close (int32_t fd)
 {
     if (NULL == dir || dir_fd != fd)
         return __ece391_close (fd);
@@ -225,3 +226,303 @@ ece391_close (int32_t fd)
     return 0;
 }
 
+
+
+/*
+ * Tracing.  With ECE391_TRACE set in the environment, every emulated
+ * call is logged to stderr with its arguments, its result and its
+ * latency in TSC cycles, and a summary per call is printed when the
+ * program halts:
+ *
+ *     ECE391_TRACE=1 ./grep foo       log each call, then the summary
+ *     ECE391_TRACE=summary ./shell    only the summary
+ *
+ * Programs started with execute inherit the setting and print their
+ * own summary.  libc is never initialised (see _start above), so the
+ * environment is found on the initial stack and all output goes out
+ * through the raw write call.
+ */
+
+enum { T_HALT, T_EXECUTE, T_READ, T_WRITE, T_OPEN, T_CLOSE,
+       T_GETARGS, T_VIDMAP, T_NUM };
+
+static const char* const trace_names[T_NUM] = {
+    "halt", "execute", "read", "write", "open", "close", "getargs", "vidmap"
+};
+
+typedef struct trace_stat {
+    uint32_t count;
+    uint32_t errors;
+    uint64_t bytes;             /* moved by successful reads and writes */
+    uint64_t cycles;
+    uint64_t max_cycles;
+} trace_stat_t;
+
+#define TRACE_OFF       0
+#define TRACE_SUMMARY   1
+#define TRACE_ALL       2
+#define TRACE_FD        2       /* stderr */
+#define TRACE_STR_MAX   40
+
+static int32_t trace_mode = -1;         /* -1 until the environment is read */
+static const char* trace_prog = "?";
+static trace_stat_t trace_stats[T_NUM];
+
+static void
+trace_init (void)
+{
+    uint32_t argc = *(uint32_t*)start_esp;
+    char** argv = (char**)(start_esp + 4);
+    char** envp = argv + argc + 1;
+    const char* val;
+
+    trace_mode = TRACE_OFF;
+    if (argc > 0) {
+        trace_prog = argv[0];
+        if ('.' == trace_prog[0] && '/' == trace_prog[1])
+            trace_prog += 2;
+    }
+    for (; NULL != *envp; envp++) {
+        if (0 != ece391_strncmp ((uint8_t*)*envp, (uint8_t*)"ECE391_TRACE=", 13))
+            continue;
+        val = *envp + 13;
+        if ('\0' == val[0] || 0 == ece391_strcmp ((uint8_t*)val, (uint8_t*)"0"))
+            trace_mode = TRACE_OFF;
+        else if (0 == ece391_strcmp ((uint8_t*)val, (uint8_t*)"summary"))
+            trace_mode = TRACE_SUMMARY;
+        else
+            trace_mode = TRACE_ALL;
+    }
+}
+
+static void
+trace_out (const char* s)
+{
+    (void)__ece391_write (TRACE_FD, s, ece391_strlen ((const uint8_t*)s));
+}
+
+/* Print an unsigned number right-aligned in width columns. */
+static void
+trace_num (uint64_t v, int32_t width)
+{
+    char buf[24];
+    int32_t i = sizeof (buf) - 1;
+
+    buf[i] = '\0';
+    do {
+        buf[--i] = '0' + v % 10;
+        v /= 10;
+    } while (0 != v);
+    while (i > 0 && (int32_t)sizeof (buf) - 1 - i < width)
+        buf[--i] = ' ';
+    trace_out (buf + i);
+}
+
+static void
+trace_int (int32_t v)
+{
+    if (v < 0) {
+        trace_out ("-");
+        trace_num ((uint32_t)-v, 0);
+    } else {
+        trace_num (v, 0);
+    }
+}
+
+static void
+trace_hex (uint32_t v)
+{
+    uint8_t buf[12];
+
+    trace_out ("0x");
+    trace_out ((char*)ece391_itoa (v, buf, 16));
+}
+
+/* Print a string argument quoted, cut short if it is long. */
+static void
+trace_str (const uint8_t* s)
+{
+    char buf[TRACE_STR_MAX + 1];
+    int32_t i;
+
+    for (i = 0; i < TRACE_STR_MAX && '\0' != s[i]; i++)
+        buf[i] = ('\n' == s[i]) ? ' ' : s[i];
+    buf[i] = '\0';
+    trace_out ("\"");
+    trace_out (buf);
+    trace_out ('\0' == s[i] ? "\"" : "\"...");
+}
+
+static void
+trace_prefix (void)
+{
+    trace_out ("[trace ");
+    trace_out (trace_prog);
+    trace_out ("] ");
+}
+
+static uint64_t
+trace_start (void)
+{
+    uint32_t lo, hi;
+
+    if (-1 == trace_mode)
+        trace_init ();
+    if (TRACE_OFF == trace_mode)
+        return 0;
+    asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/*
+ * Account for one call.  Numeric arguments are printed as given:
+ * nargs of them, a1 in hex when it is a pointer; str, if not NULL,
+ * replaces the first.
+ */
+static void
+trace_end (int32_t call, uint64_t start, int32_t rval, int32_t nargs,
+           uint32_t a0, uint32_t a1, uint32_t a2, const uint8_t* str)
+{
+    trace_stat_t* st = &trace_stats[call];
+    uint64_t cycles;
+    uint32_t lo, hi;
+
+    if (TRACE_OFF == trace_mode)
+        return;
+    asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+    cycles = (((uint64_t)hi << 32) | lo) - start;
+
+    st->count++;
+    st->cycles += cycles;
+    if (cycles > st->max_cycles)
+        st->max_cycles = cycles;
+    if (-1 == rval)
+        st->errors++;
+    else if ((T_READ == call || T_WRITE == call) && rval > 0)
+        st->bytes += rval;
+
+    if (TRACE_ALL != trace_mode)
+        return;
+    trace_prefix ();
+    trace_out (trace_names[call]);
+    trace_out ("(");
+    if (nargs > 0) {
+        if (NULL != str)
+            trace_str (str);
+        else if (T_GETARGS == call || T_VIDMAP == call)
+            trace_hex (a0);
+        else
+            trace_int (a0);
+    }
+    if (nargs > 1) {
+        trace_out (", ");
+        trace_hex (a1);
+    }
+    if (nargs > 2) {
+        trace_out (", ");
+        trace_int (a2);
+    }
+    trace_out (") = ");
+    trace_int (rval);
+    trace_out ("  ");
+    trace_num (cycles, 0);
+    trace_out (" cycles\n");
+}
+
+static void
+trace_summary (void)
+{
+    int32_t i;
+    uint32_t calls = 0;
+    uint64_t cycles = 0;
+
+    for (i = 0; i < T_NUM; i++) {
+        calls += trace_stats[i].count;
+        cycles += trace_stats[i].cycles;
+    }
+    trace_prefix ();
+    trace_out ("summary: ");
+    trace_num (calls, 0);
+    trace_out (" calls, ");
+    trace_num (cycles, 0);
+    trace_out (" cycles\n");
+    trace_prefix ();
+    trace_out ("  call    count  errors       bytes          cycles      max cycles\n");
+    for (i = 0; i < T_NUM; i++) {
+        if (0 == trace_stats[i].count)
+            continue;
+        trace_prefix ();
+        trace_out ("  ");
+        trace_out (trace_names[i]);
+        trace_num (trace_stats[i].count, 13 - ece391_strlen ((uint8_t*)trace_names[i]));
+        trace_num (trace_stats[i].errors, 8);
+        trace_num (trace_stats[i].bytes, 12);
+        trace_num (trace_stats[i].cycles, 16);
+        trace_num (trace_stats[i].max_cycles, 16);
+        trace_out ("\n");
+    }
+}
+
+#define TRACE_CALL(call, expr, nargs, a0, a1, a2, str)                    \
+    uint64_t start = trace_start ();                                      \
+    int32_t rval = (expr);                                                \
+    trace_end ((call), start, rval, (nargs), (uint32_t)(a0),              \
+               (uint32_t)(a1), (uint32_t)(a2), (str));                    \
+    return rval
+
+int32_t
+ece391_halt (uint8_t status)
+{
+    uint64_t start;
+
+    ece391_flush_all ();
+    start = trace_start ();
+    if (TRACE_OFF != trace_mode) {
+        trace_end (T_HALT, start, 0, 1, status, 0, 0, NULL);
+        trace_summary ();
+    }
+    return __ece391_halt (status);
+}
+
+int32_t
+ece391_execute (const uint8_t* command)
+{
+    ece391_flush_all ();
+    TRACE_CALL (T_EXECUTE, emu_execute (command), 1, 0, 0, 0, command);
+}
+
+int32_t
+ece391_open (const uint8_t* filename)
+{
+    TRACE_CALL (T_OPEN, emu_open (filename), 1, 0, 0, 0, filename);
+}
+
+int32_t
+ece391_getargs (uint8_t* buf, int32_t nbytes)
+{
+    TRACE_CALL (T_GETARGS, emu_getargs (buf, nbytes), 2, buf, nbytes, 0, NULL);
+}
+
+int32_t
+ece391_vidmap (uint8_t** screen_start)
+{
+    TRACE_CALL (T_VIDMAP, emu_vidmap (screen_start), 1, screen_start, 0, 0, NULL);
+}
+
+int32_t
+ece391_read (int32_t fd, void* buf, int32_t nbytes)
+{
+    TRACE_CALL (T_READ, emu_read (fd, buf, nbytes), 3, fd, buf, nbytes, NULL);
+}
+
+int32_t
+ece391_write (int32_t fd, const void* buf, int32_t nbytes)
+{
+    TRACE_CALL (T_WRITE, emu_write (fd, buf, nbytes), 3, fd, buf, nbytes, NULL);
+}
+
+int32_t
+ece391_close (int32_t fd)
+{
+    TRACE_CALL (T_CLOSE, emu_close (fd), 1, fd, 0, 0, NULL);
+}
@@ -0,0 +1,39 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+/*
+ * execbench [N] - time N execute/halt round trips of "hello".  Reads
+ * are made non-blocking before each run so hello finds no name and
+ * exits at once; halt puts the terminal back in canonical mode.  The
+ * time includes hello printing its two prompts.
+ */
+
+#define DEFAULT_COUNT   20
+
+int main ()
+{
+    uint32_t count, i;
+    uint64_t start, cycles;
+
+    count = ece391_arg_count (DEFAULT_COUNT);
+
+    cycles = 0;
+    for (i = 0; i < count; i++) {
+        ece391_termmode (TERM_CANON | TERM_NONBLOCK);
+        start = ece391_rdtsc ();
+        if (0 != ece391_execute ((uint8_t*)"hello")) {
+            ece391_fdputs (1, (uint8_t*)"\nexecute of hello failed\n");
+            return 2;
+        }
+        cycles += ece391_rdtsc () - start;
+    }
+    ece391_termmode (TERM_CANON);
+
+    ece391_fdputs (1, (uint8_t*)"\n");
+    ece391_bench_print ((uint8_t*)"user_exec_hello", cycles, count,
+                        (uint8_t*)"cycles/op");
+
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+/*
+ * fsbench [N] - read every file in the directory N times, first
+ * sequentially in 4 KB reads, then in reads of pseudo-random size
+ * (1 to 512 bytes).  There is no seek call, so the random sizes are
+ * what make the reads start and end at arbitrary offsets.
+ * "." and the "rtc" device are skipped.
+ */
+
+#define DEFAULT_PASSES  4
+#define NAME_LEN        32
+#define MAX_FILES       64
+#define SEQ_CHUNK       4096
+#define RAND_MAX_CHUNK  512
+
+static uint8_t buf[SEQ_CHUNK];
+static uint32_t seed = 391;
+
+/* Linear congruential generator, good enough for read sizes. */
+static uint32_t
+next_rand (void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 16;
+}
+
+/* Read a file to the end; returns the bytes read or -1. */
+static int32_t
+read_file (const uint8_t* name, int32_t random)
+{
+    int32_t fd, cnt, total = 0;
+    uint32_t chunk;
+
+    if (-1 == (fd = ece391_open (name)))
+        return -1;
+    do {
+        chunk = random ? 1 + next_rand () % RAND_MAX_CHUNK : SEQ_CHUNK;
+        cnt = ece391_read (fd, buf, chunk);
+        if (cnt > 0)
+            total += cnt;
+    } while (cnt > 0);
+    ece391_close (fd);
+    return total;
+}
+
+int main ()
+{
+    uint8_t names[MAX_FILES][NAME_LEN + 1];
+    int32_t nfiles, fd, cnt, i, random;
+    uint32_t passes, p, bytes;
+    uint64_t start, cycles;
+
+    passes = ece391_arg_count (DEFAULT_PASSES);
+
+    if (-1 == (fd = ece391_open ((uint8_t*)"."))) {
+        ece391_fdputs (1, (uint8_t*)"directory open failed\n");
+        return 2;
+    }
+    nfiles = 0;
+    while (nfiles < MAX_FILES && 0 < (cnt = ece391_read (fd, names[nfiles], NAME_LEN))) {
+        names[nfiles][cnt] = '\0';
+        if (0 != ece391_strcmp (names[nfiles], (uint8_t*)".") &&
+            0 != ece391_strcmp (names[nfiles], (uint8_t*)"rtc"))
+            nfiles++;
+    }
+    ece391_close (fd);
+
+    for (random = 0; random < 2; random++) {
+        bytes = 0;
+        start = ece391_rdtsc ();
+        for (p = 0; p < passes; p++) {
+            for (i = 0; i < nfiles; i++) {
+                if (-1 == (cnt = read_file (names[i], random))) {
+                    ece391_fdputs (1, (uint8_t*)"could not read ");
+                    ece391_fdputs (1, names[i]);
+                    ece391_fdputs (1, (uint8_t*)"\n");
+                    return 3;
+                }
+                bytes += cnt;
+            }
+        }
+        cycles = ece391_rdtsc () - start;
+        ece391_bench_print (random ? (uint8_t*)"user_read_random" : (uint8_t*)"user_read_seq",
+                            cycles, bytes >> 10, (uint8_t*)"cycles/KB");
+    }
+
+    return 0;
+}
@@ -5,56 +5,120 @@
 
 #define BUFSIZE 1024
 #define SBUFSIZE 33
+#define BLOCKSIZE 8192
+
+static uint8_t data[BLOCKSIZE];
+
+/* Horspool skip table: how far the window may move when its last
+   byte is c, without stepping over a possible match. */
+static uint32_t skip[256];
+
+static void
+make_skip (const uint8_t* s, int32_t s_len)
+{
+    int32_t i;
+
+    for (i = 0; i < 256; i++)
+        skip[i] = s_len;
+    for (i = 0; i < s_len - 1; i++)
+        skip[s[i]] = s_len - 1 - i;
+}
+
+/* Returns the first position >= from in data[0..end) where s starts,
+   or -1.  Compares the last byte of the window first. */
+static int32_t
+find (const uint8_t* s, int32_t s_len, int32_t from, int32_t end)
+{
+    uint8_t last = s[s_len - 1];
+    uint8_t c;
+    int32_t i;
+
+    while (from + s_len <= end) {
+        c = data[from + s_len - 1];
+        if (c == last) {
+            for (i = 0; i < s_len - 1 && data[from + i] == s[i]; i++);
+            if (i == s_len - 1)
+                return from;
+        }
+        from += skip[c];
+    }
+    return -1;
+}
+
+/* Prints "fname:line\n".  Like the old fdputs version, the line
+   stops at a NUL byte. */
+static void
+print_line (const char* fname, int32_t start, int32_t end)
+{
+    int32_t len;
+
+    for (len = 0; start + len < end && '\0' != data[start + len]; len++);
+    ece391_fdputs (1, (uint8_t*)fname);
+    ece391_fdwrite (1, ":", 1);
+    ece391_fdwrite (1, data + start, len);
+    ece391_fdwrite (1, "\n", 1);
+}
+
+/* Searches data[0..end), which ends on a line boundary, and prints
+   every line with a match once. */
+static void
+search_block (const char* s, int32_t s_len, const char* fname, int32_t end)
+{
+    int32_t pos, line_start, line_end, prev_end;
+
+    prev_end = 0;
+    pos = 0;
+    while (-1 != (pos = find ((uint8_t*)s, s_len, pos, end))) {
+        for (line_start = pos; line_start > prev_end && '\n' != data[line_start - 1];
+             line_start--);
+        for (line_end = pos + s_len; line_end < end && '\n' != data[line_end];
+             line_end++);
+        print_line (fname, line_start, line_end);
+        prev_end = pos = line_end + 1;
+    }
+}
 
 int32_t
-do_one_file (const char* s, const char* fname) 
+do_one_file (const char* s, const char* fname)
 {
-    int32_t fd, cnt, last, line_start, line_end, check, s_len;
-    uint8_t data[BUFSIZE+1];
+    int32_t fd, cnt, last, end, i, s_len;
 
     s_len = ece391_strlen ((uint8_t*)s);
     if (-1 == (fd = ece391_open ((uint8_t*)fname))) {
         ece391_fdputs (1, (uint8_t*)"file open failed\n");
         return -1;
     }
+    if (s_len > 0)
+        make_skip ((uint8_t*)s, s_len);
+
+    /* data[0..last) holds the unfinished line carried over from the
+       previous block, followed by the newly read bytes. */
     last = 0;
     while (1) {
-        cnt = ece391_read (fd, data + last, BUFSIZE - last);
+        cnt = ece391_read (fd, data + last, BLOCKSIZE - last);
 	if (-1 == cnt) {
             ece391_fdputs (1, (uint8_t*)"file read failed\n");
             return -1;
 	}
 	last += cnt;
-	line_start = 0;
-	while (1) {
-	    line_end = line_start;
-	    while (line_end < last && '\n' != data[line_end])
-		line_end++;
-	    if ('\n' != data[line_end] && 0 != cnt && line_start != 0) {
-		/* copy from line_start to last down to 0 and fix last */
-		data[line_end] = '\0';
-		ece391_strcpy (data, data + line_start);
-		last -= line_start;
-		break;
-	    }
-	    /* search the line */
-	    data[line_end] = '\0';
-	    for (check = line_start; check < line_end; check++) {
-		if (s[0] == data[check] && 
-		    0 == ece391_strncmp ((uint8_t*)(data + check), (uint8_t*)s, s_len)) {
-		    ece391_fdputs (1, (uint8_t*)fname);
-		    ece391_fdputs (1, (uint8_t*)":");
-		    ece391_fdputs (1, data + line_start);
-		    ece391_fdputs (1, (uint8_t*)"\n");
-		    break;
-		}
-	    }
-	    line_start = line_end + 1;
-	    if (line_start >= last) {
-	        last = 0;
-		break;
-	    }
+
+	/* Search up to the last line break; at the end of the file,
+	   or when one line fills the whole block, search it all. */
+	end = last;
+	if (0 != cnt) {
+	    while (end > 0 && '\n' != data[end - 1])
+	        end--;
+	    if (0 == end && BLOCKSIZE == last)
+	        end = last;
 	}
+	if (s_len > 0)
+	    search_block (s, s_len, fname, end);
+
+	/* Move the unfinished line down to the front */
+	for (i = end; i < last; i++)
+	    data[i - end] = data[i];
+	last -= end;
+
 	if (0 == cnt)
 	    break;
     }
@@ -81,6 +145,9 @@ int main ()
 	return 2;
     }
 
+    /* Collect matches into full buffers */
+    ece391_setbuf (1, ECE391_IOFBF);
+
     while (0 != (cnt = ece391_read (fd, buf, SBUFSIZE-1))) {
         if (-1 == cnt) {
 	    ece391_fdputs (1, (uint8_t*)"directory entry read failed\n");
@@ -11,7 +11,7 @@ int main ()
     uint8_t buf[BUFSIZE];
 
     ece391_fdputs (1, (uint8_t*)"Hi, what's your name? ");
-    if (-1 == (cnt = ece391_read (0, buf, BUFSIZE-1))) {
+    if (-1 == (cnt = ece391_fdread (0, buf, BUFSIZE-1))) {
         ece391_fdputs (1, (uint8_t*)"Can't read name from keyboard.\n");
         return 3;
     }
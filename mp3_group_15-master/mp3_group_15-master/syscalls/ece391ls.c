@@ -15,13 +15,15 @@ int main ()
         return 2;
     }
 
+    /* One write for the whole listing */
+    ece391_setbuf (1, ECE391_IOFBF);
     while (0 != (cnt = ece391_read (fd, buf, SBUFSIZE-1))) {
         if (-1 == cnt) {
 	        ece391_fdputs (1, (uint8_t*)"directory entry read failed\n");
 	        return 3;
 	    }
 	    buf[cnt] = '\n';
-	    if (-1 == ece391_write (1, buf, cnt + 1))
+	    if (-1 == ece391_fdwrite (1, buf, cnt + 1))
 	        return 3;
     }
 
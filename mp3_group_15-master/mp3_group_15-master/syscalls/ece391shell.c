@@ -13,7 +13,7 @@ int main ()
 
     while (1) {
         ece391_fdputs (1, (uint8_t*)"391OS> ");
-	if (-1 == (cnt = ece391_read (0, buf, BUFSIZE-1))) {
+	if (-1 == (cnt = ece391_fdread (0, buf, BUFSIZE-1))) {
 	    ece391_fdputs (1, (uint8_t*)"read from keyboard failed\n");
 	    return 3;
 	}
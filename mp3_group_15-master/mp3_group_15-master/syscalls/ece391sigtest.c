@@ -20,6 +20,9 @@ int main ()
 	return 3;
     }
 
+    /* The handlers print too, so keep nothing half-written in a buffer */
+    ece391_setbuf (1, ECE391_IONBF);
+
 	if (buf[0] == '1') {
 		ece391_fdputs(1, (uint8_t*)"Installing signal handlers\n");
 		ece391_set_handler(SEGFAULT, segfault_sighandler);
@@ -27,7 +30,7 @@ int main ()
 	}
 
     ece391_fdputs (1, (uint8_t*)"Hi, what's your name? ");
-    if (-1 == (cnt = ece391_read (0, buf, BUFSIZE-1))) {
+    if (-1 == (cnt = ece391_fdread (0, buf, BUFSIZE-1))) {
         ece391_fdputs (1, (uint8_t*)"Can't read name from keyboard.\n");
     return 3;
     }
@@ -18,7 +18,7 @@ void ece391_strcpy(uint8_t* dst, const uint8_t* src)
 
 void ece391_fdputs(int32_t fd, const uint8_t* s)
 {
-    (void)ece391_write (fd, s, ece391_strlen(s));
+    (void)ece391_fdwrite (fd, s, ece391_strlen(s));
 }
 
 int32_t ece391_strcmp(const uint8_t* s1, const uint8_t* s2)
@@ -102,3 +102,220 @@ uint8_t* ece391_strrev(uint8_t* s)
    return s;
 }
 
+
+/*
+ * Timing helpers for benchmarks: take ece391_now_ns() before the work
+ * and pass it to ece391_elapsed_us() afterwards.
+ */
+uint64_t ece391_now_ns(void)
+{
+    uint64_t ns;
+
+    if (ece391_gettime(&ns) != 0) {
+        return 0;
+    }
+    return ns;
+}
+
+uint32_t ece391_elapsed_us(uint64_t start_ns)
+{
+    uint64_t delta = ece391_now_ns() - start_ns;
+    uint32_t ns_per_us = 1000;
+    uint32_t q, r;
+
+    /* A single divl needs the quotient to fit in 32 bits, about
+       71 minutes; longer intervals saturate. */
+    if ((uint32_t)(delta >> 32) >= ns_per_us) {
+        return 0xFFFFFFFF;
+    }
+    asm ("divl %4"
+         : "=a" (q), "=d" (r)
+         : "a" ((uint32_t)delta), "d" ((uint32_t)(delta >> 32)), "rm" (ns_per_us));
+    return q;
+}
+
+/*
+ * Cycle counting for the benchmark programs.  The kernel leaves the
+ * TSC readable from user mode.
+ */
+uint64_t ece391_rdtsc(void)
+{
+    uint32_t lo, hi;
+
+    asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/*
+ * Print "[BENCH] <metric> <cycles / ops> <unit>", the same line format
+ * the kernel's benchmark suite uses, so one script can compare both.
+ */
+void ece391_bench_print(const uint8_t* metric, uint64_t cycles, uint32_t ops,
+                        const uint8_t* unit)
+{
+    uint8_t buf[16];
+    uint32_t q, r;
+
+    if (0 == ops || (uint32_t)(cycles >> 32) >= ops) {
+        q = 0xFFFFFFFF;
+    } else {
+        asm ("divl %4"
+             : "=a" (q), "=d" (r)
+             : "a" ((uint32_t)cycles), "d" ((uint32_t)(cycles >> 32)), "rm" (ops));
+    }
+    ece391_fdputs (1, (uint8_t*)"[BENCH] ");
+    ece391_fdputs (1, metric);
+    ece391_fdputs (1, (uint8_t*)" ");
+    ece391_fdputs (1, ece391_itoa (q, buf, 10));
+    ece391_fdputs (1, (uint8_t*)" ");
+    ece391_fdputs (1, unit);
+    ece391_fdputs (1, (uint8_t*)"\n");
+}
+
+/*
+ * Buffered I/O, see ece391support.h.  rbuf[rpos..rlen) is input that
+ * has been read but not yet handed out; wbuf[0..wlen) is output that
+ * has not yet been written.
+ */
+typedef struct iobuf {
+    uint8_t rbuf[ECE391_IOBUF_SIZE];
+    int32_t rpos;
+    int32_t rlen;
+    uint8_t wbuf[ECE391_IOBUF_SIZE];
+    int32_t wlen;
+    int32_t mode;
+} iobuf_t;
+
+static iobuf_t iobufs[ECE391_MAX_FD] = {
+    [1] = { .mode = ECE391_IOLBF }
+};
+
+static void copy_bytes(uint8_t* dst, const uint8_t* src, int32_t n)
+{
+    while (n-- > 0)
+        *dst++ = *src++;
+}
+
+void ece391_setbuf(int32_t fd, int32_t mode)
+{
+    if (fd < 0 || fd >= ECE391_MAX_FD)
+        return;
+    (void)ece391_fdflush (fd);
+    iobufs[fd].mode = mode;
+}
+
+int32_t ece391_fdread(int32_t fd, void* buf, int32_t nbytes)
+{
+    iobuf_t* b;
+    int32_t cnt;
+
+    if (fd < 0 || fd >= ECE391_MAX_FD || nbytes <= 0)
+        return ece391_read (fd, buf, nbytes);
+    b = &iobufs[fd];
+
+    if (b->rpos == b->rlen) {
+        if (0 == fd)
+            (void)ece391_fdflush (1);
+        /* Large reads skip the buffer */
+        if (nbytes >= ECE391_IOBUF_SIZE)
+            return ece391_read (fd, buf, nbytes);
+        cnt = ece391_read (fd, b->rbuf, ECE391_IOBUF_SIZE);
+        if (cnt <= 0)
+            return cnt;
+        b->rpos = 0;
+        b->rlen = cnt;
+    }
+
+    cnt = b->rlen - b->rpos;
+    if (cnt > nbytes)
+        cnt = nbytes;
+    copy_bytes (buf, b->rbuf + b->rpos, cnt);
+    b->rpos += cnt;
+    return cnt;
+}
+
+/* Returns the next byte, or -1 at the end of the file or on an error */
+int32_t ece391_fdgetc(int32_t fd)
+{
+    uint8_t c;
+
+    if (1 != ece391_fdread (fd, &c, 1))
+        return -1;
+    return c;
+}
+
+int32_t ece391_fdwrite(int32_t fd, const void* buf, int32_t nbytes)
+{
+    const uint8_t* s = buf;
+    iobuf_t* b;
+    int32_t i;
+
+    if (fd < 0 || fd >= ECE391_MAX_FD || nbytes <= 0)
+        return ece391_write (fd, buf, nbytes);
+    b = &iobufs[fd];
+
+    if (b->wlen + nbytes > ECE391_IOBUF_SIZE && -1 == ece391_fdflush (fd))
+        return -1;
+    if (ECE391_IONBF == b->mode || nbytes >= ECE391_IOBUF_SIZE)
+        return ece391_write (fd, buf, nbytes);
+
+    copy_bytes (b->wbuf + b->wlen, s, nbytes);
+    b->wlen += nbytes;
+    if (ECE391_IOLBF == b->mode) {
+        for (i = 0; i < nbytes; i++) {
+            if ('\n' == s[i])
+                return (-1 == ece391_fdflush (fd)) ? -1 : nbytes;
+        }
+    }
+    return nbytes;
+}
+
+/* Writes out anything buffered for fd.  Returns 0, or -1 if the write
+   failed, in which case the buffered output is dropped. */
+int32_t ece391_fdflush(int32_t fd)
+{
+    iobuf_t* b;
+    int32_t cnt;
+
+    if (fd < 0 || fd >= ECE391_MAX_FD)
+        return -1;
+    b = &iobufs[fd];
+    if (0 == b->wlen)
+        return 0;
+    cnt = ece391_write (fd, b->wbuf, b->wlen);
+    b->wlen = 0;
+    return (-1 == cnt) ? -1 : 0;
+}
+
+void ece391_flush_all(void)
+{
+    int32_t fd;
+
+    for (fd = 0; fd < ECE391_MAX_FD; fd++)
+        (void)ece391_fdflush (fd);
+}
+
+/* Flushes fd, drops its unread input, and closes it */
+int32_t ece391_fdclose(int32_t fd)
+{
+    if (fd >= 0 && fd < ECE391_MAX_FD) {
+        (void)ece391_fdflush (fd);
+        iobufs[fd].rpos = 0;
+        iobufs[fd].rlen = 0;
+    }
+    return ece391_close (fd);
+}
+
+/* Parse a decimal argument; returns dflt if there is none. */
+uint32_t ece391_arg_count(uint32_t dflt)
+{
+    uint8_t buf[128];
+    uint32_t n = 0;
+    int32_t i;
+
+    if (0 != ece391_getargs (buf, sizeof (buf)))
+        return dflt;
+    for (i = 0; buf[i] >= '0' && buf[i] <= '9'; i++)
+        n = n * 10 + (buf[i] - '0');
+    return (0 == n) ? dflt : n;
+}
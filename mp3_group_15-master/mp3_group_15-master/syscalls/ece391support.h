@@ -8,6 +8,38 @@ extern int32_t ece391_strcmp(const uint8_t* s1, const uint8_t* s2);
 extern int32_t ece391_strncmp(const uint8_t* s1, const uint8_t* s2, uint32_t n);
 extern uint8_t *ece391_itoa(uint32_t value, uint8_t* buf, int32_t radix);
 extern uint8_t *ece391_strrev(uint8_t* s);
+extern uint64_t ece391_now_ns(void);
+extern uint32_t ece391_elapsed_us(uint64_t start_ns);
+extern uint64_t ece391_rdtsc(void);
+extern void ece391_bench_print(const uint8_t* metric, uint64_t cycles, uint32_t ops,
+                               const uint8_t* unit);
+extern uint32_t ece391_arg_count(uint32_t dflt);
+
+/*
+ * Buffered I/O.  Each of the eight file descriptors gets a read buffer
+ * and a write buffer.  Output to fd 1 is line buffered and output to
+ * the others is fully buffered; ece391_setbuf changes that.  Reads
+ * return at most what one kernel read returned, so a terminal read
+ * still ends at the end of the line.  Reading fd 0 flushes fd 1 first,
+ * so a prompt appears before the program waits for input.  halt and
+ * execute flush every buffer, but a program that mixes these calls
+ * with ece391_read/ece391_write on the same fd must flush itself.
+ * The rtc should not be read through a buffer.
+ */
+#define ECE391_IOBUF_SIZE 1024
+#define ECE391_MAX_FD     8
+
+#define ECE391_IOFBF 0  /* flush when the buffer is full */
+#define ECE391_IOLBF 1  /* also flush after each newline */
+#define ECE391_IONBF 2  /* no buffering */
+
+extern void ece391_setbuf(int32_t fd, int32_t mode);
+extern int32_t ece391_fdread(int32_t fd, void* buf, int32_t nbytes);
+extern int32_t ece391_fdgetc(int32_t fd);
+extern int32_t ece391_fdwrite(int32_t fd, const void* buf, int32_t nbytes);
+extern int32_t ece391_fdflush(int32_t fd);
+extern void ece391_flush_all(void);
+extern int32_t ece391_fdclose(int32_t fd);
 
 #endif /* ECE391SUPPORT_H */
 
@@ -0,0 +1,36 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+/*
+ * sysbench [N] - time N system calls from user mode.  The null call
+ * uses an invalid call number, so only the int $0x80 entry, the
+ * signal check and the iret are timed; close(-1) adds argument
+ * checking in a real call.
+ */
+
+#define DEFAULT_COUNT   100000
+
+int main ()
+{
+    uint32_t count, i;
+    uint64_t start;
+    int32_t ret;
+
+    count = ece391_arg_count (DEFAULT_COUNT);
+
+    start = ece391_rdtsc ();
+    for (i = 0; i < count; i++)
+        asm volatile ("int $0x80" : "=a" (ret) : "a" (0) : "memory", "cc");
+    ece391_bench_print ((uint8_t*)"user_syscall_null", ece391_rdtsc () - start,
+                        count, (uint8_t*)"cycles/op");
+
+    start = ece391_rdtsc ();
+    for (i = 0; i < count; i++)
+        ece391_close (-1);
+    ece391_bench_print ((uint8_t*)"user_syscall_close", ece391_rdtsc () - start,
+                        count, (uint8_t*)"cycles/op");
+
+    return 0;
+}
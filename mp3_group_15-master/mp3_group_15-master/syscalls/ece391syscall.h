@@ -22,6 +22,57 @@ extern int32_t ece391_vidmap (uint8_t** screen_start);
 extern int32_t ece391_set_handler (int32_t signum, void* handler);
 extern int32_t ece391_sigreturn (void);
 
+/*
+ * Scheduler statistics, one record per process plus a leading idle
+ * record (pid -1).  cpu_ticks are scheduler ticks (about 100 per second);
+ * the wake-to-run latencies are in TSC cycles.  Returns the number of
+ * records filled in.
+ */
+#define SCHED_NAME_LEN 32
+typedef struct sched_stat {
+    int32_t  pid;
+    int32_t  terminal;
+    uint32_t state;             /* 0 runnable, 1 blocked */
+    uint32_t cpu_ticks;
+    uint32_t nvcsw;             /* voluntary context switches */
+    uint32_t nivcsw;            /* involuntary (preempted) switches */
+    uint32_t wakeups;
+    uint32_t wake_lat_avg;
+    uint32_t wake_lat_max;
+    int8_t   name[SCHED_NAME_LEN];
+} sched_stat_t;
+
+extern int32_t ece391_schedstat (sched_stat_t* buf, int32_t nbytes);
+
+/*
+ * Line discipline of the caller's terminal.  In raw mode reads return
+ * keystrokes as they are typed, without echo or line editing; with
+ * TERM_NONBLOCK reads return 0 when there is no input.  Returns the
+ * previous mode.  Halting puts the terminal back into canonical mode.
+ */
+#define TERM_CANON    0x0
+#define TERM_RAW      0x1
+#define TERM_NONBLOCK 0x2
+extern int32_t ece391_termmode (int32_t mode);
+
+/*
+ * Monotonic clock: stores the nanoseconds since boot in *ns.  The kernel
+ * counts them with the TSC, calibrated against the PIT at boot.
+ */
+extern int32_t ece391_gettime (uint64_t* ns);
+
+/*
+ * Timers, with a resolution of 10 ms.  sleep blocks for at least ms
+ * milliseconds.  alarm raises ALARM once, ms milliseconds from now
+ * (0 cancels), and returns the milliseconds left on the previous alarm.
+ * An alarm going off or an INTERRUPT (Ctrl+C) ends a sleep early;
+ * sleep then returns the milliseconds it did not sleep.  A read blocked
+ * on the keyboard, RTC or serial port returns -1 when an INTERRUPT or a
+ * signal with a handler arrives, and the handler runs on the way out.
+ */
+extern int32_t ece391_sleep (uint32_t ms);
+extern int32_t ece391_alarm (uint32_t ms);
+
 enum signums {
 	DIV_ZERO = 0,
 	SEGFAULT,
@@ -300,7 +300,7 @@ int main ()
 	int fail = 0;
 
     ece391_fdputs (1, (uint8_t*)"Choose from tests 1-8. 0 to run all: ");
-    if (-1 == (cnt = ece391_read (0, buf, 127))) {
+    if (-1 == (cnt = ece391_fdread (0, buf, 127))) {
         ece391_fdputs (1, (uint8_t*)"Can't read test #\n");
 		return 2;
     }
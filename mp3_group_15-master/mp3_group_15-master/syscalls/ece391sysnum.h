@@ -11,5 +11,10 @@
 #define SYS_VIDMAP  8
 #define SYS_SET_HANDLER  9
 #define SYS_SIGRETURN  10
+#define SYS_SCHEDSTAT  11
+#define SYS_TERMMODE  12
+#define SYS_GETTIME  13
+#define SYS_SLEEP  14
+#define SYS_ALARM  15
 
 #endif /* ECE391SYSNUM_H */
@@ -0,0 +1,119 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define MAX_RECORDS     8
+#define RTC_HZ          2
+#define DEFAULT_COUNT   10
+#define ARGBUF_SIZE     128
+#define NUMBUF_SIZE     16
+
+/* Print value right-aligned in a field of the given width. */
+static void
+put_num (uint32_t value, int32_t width)
+{
+    uint8_t buf[NUMBUF_SIZE];
+    int32_t len;
+
+    ece391_itoa (value, buf, 10);
+    for (len = ece391_strlen (buf); len < width; len++)
+        ece391_fdputs (1, (uint8_t*)" ");
+    ece391_fdputs (1, buf);
+}
+
+/* Find a process in the previous sample; returns its index or -1. */
+static int32_t
+find_prev (sched_stat_t* prev, int32_t nprev, int32_t pid)
+{
+    int32_t i;
+
+    for (i = 0; i < nprev; i++)
+        if (prev[i].pid == pid)
+            return i;
+    return -1;
+}
+
+int main ()
+{
+    sched_stat_t cur[MAX_RECORDS];
+    sched_stat_t prev[MAX_RECORDS];
+    int32_t ncur, nprev = 0;
+    int32_t rtc_fd, rate, garbage;
+    int32_t i, j, p, count, refresh;
+    uint32_t total, delta;
+    uint8_t buf[ARGBUF_SIZE];
+
+    /* "top N" refreshes N times, plain "top" uses the default. */
+    count = DEFAULT_COUNT;
+    if (0 == ece391_getargs (buf, ARGBUF_SIZE)) {
+        count = 0;
+        for (i = 0; buf[i] >= '0' && buf[i] <= '9'; i++)
+            count = count * 10 + (buf[i] - '0');
+        if (0 == count)
+            count = DEFAULT_COUNT;
+    }
+
+    if (-1 == (rtc_fd = ece391_open ((uint8_t*)"rtc"))) {
+        ece391_fdputs (1, (uint8_t*)"could not open rtc\n");
+        return 2;
+    }
+    rate = RTC_HZ;
+    ece391_write (rtc_fd, &rate, 4);
+
+    /* Each refresh goes out in one write */
+    ece391_setbuf (1, ECE391_IOFBF);
+
+    for (refresh = 0; refresh < count; refresh++) {
+        if (-1 == (ncur = ece391_schedstat (cur, sizeof (cur)))) {
+            ece391_fdputs (1, (uint8_t*)"schedstat failed\n");
+            return 3;
+        }
+
+        /* The ticks of all records together are the elapsed time. */
+        total = 0;
+        for (i = 0; i < ncur; i++) {
+            p = find_prev (prev, nprev, cur[i].pid);
+            total += cur[i].cpu_ticks - (p >= 0 ? prev[p].cpu_ticks : 0);
+        }
+        if (0 == total)
+            total = 1;
+
+        ece391_fdputs (1, (uint8_t*)"\n  PID TTY S %CPU   TICKS  VCSW IVCSW  WAKES  AVGLAT  MAXLAT NAME\n");
+        for (i = 0; i < ncur; i++) {
+            p = find_prev (prev, nprev, cur[i].pid);
+            delta = cur[i].cpu_ticks - (p >= 0 ? prev[p].cpu_ticks : 0);
+
+            if (cur[i].pid < 0)
+                ece391_fdputs (1, (uint8_t*)"    -   -");
+            else {
+                put_num (cur[i].pid, 5);
+                put_num (cur[i].terminal, 4);
+            }
+            ece391_fdputs (1, cur[i].state ? (uint8_t*)" S" : (uint8_t*)" R");
+            put_num (delta * 100 / total, 5);
+            put_num (cur[i].cpu_ticks, 8);
+            put_num (cur[i].nvcsw, 6);
+            put_num (cur[i].nivcsw, 6);
+            put_num (cur[i].wakeups, 7);
+            put_num (cur[i].wake_lat_avg, 8);
+            put_num (cur[i].wake_lat_max, 8);
+            ece391_fdputs (1, (uint8_t*)" ");
+            ece391_fdputs (1, (uint8_t*)cur[i].name);
+            ece391_fdputs (1, (uint8_t*)"\n");
+        }
+
+        for (j = 0; j < ncur; j++)
+            prev[j] = cur[j];
+        nprev = ncur;
+
+        ece391_fdflush (1);
+
+        /* Refresh once per RTC second. */
+        for (j = 0; j < RTC_HZ; j++)
+            ece391_read (rtc_fd, &garbage, 4);
+    }
+
+    ece391_close (rtc_fd);
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+/*
+ * ttybench [N] - write N bytes of text to stdout one byte per write,
+ * one 80 column line per write and 4000 bytes per write, and time
+ * each.  Every line ends in a newline, so the screen scrolls as a
+ * real program's would.
+ */
+
+#define DEFAULT_BYTES   8000
+#define LINE_LEN        80
+#define BULK_LEN        4000
+#define NUM_RUNS        3
+
+static uint8_t text[BULK_LEN];
+
+/* Write total bytes in writes of at most chunk bytes. */
+static uint64_t
+run (uint32_t chunk, uint32_t total)
+{
+    uint64_t start;
+    uint32_t done, n;
+
+    start = ece391_rdtsc ();
+    for (done = 0; done < total; done += n) {
+        n = total - done;
+        if (n > chunk)
+            n = chunk;
+        ece391_write (1, text + (done % BULK_LEN), n);
+    }
+    return ece391_rdtsc () - start;
+}
+
+int main ()
+{
+    static const uint32_t chunk[NUM_RUNS] = {1, LINE_LEN, BULK_LEN};
+    static const char* metric[NUM_RUNS] = {
+        "user_write_byte", "user_write_line", "user_write_bulk"
+    };
+    uint64_t cycles[NUM_RUNS];
+    uint32_t total, i;
+
+    total = ece391_arg_count (DEFAULT_BYTES);
+    total -= total % BULK_LEN;
+    if (0 == total)
+        total = BULK_LEN;
+
+    for (i = 0; i < BULK_LEN; i++)
+        text[i] = (i % LINE_LEN == LINE_LEN - 1) ? '\n' : 'a' + (i % 26);
+
+    /* Print after all runs, so the results stay on screen. */
+    for (i = 0; i < NUM_RUNS; i++)
+        cycles[i] = run (chunk[i], total);
+    for (i = 0; i < NUM_RUNS; i++)
+        ece391_bench_print ((uint8_t*)metric[i], cycles[i], total,
+                            (uint8_t*)"cycles/char");
+
+    return 0;
+}